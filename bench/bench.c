@@ -0,0 +1,50 @@
+/**
+  @file bench.c
+  @brief See header for details
+  */
+#include "bench.h"
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+long bench_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+size_t bench_heap_bytes(void) {
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return (size_t)bench_rss_kb() * 1024u;
+#endif
+}
+
+void bench_suite(const char* name) {
+    printf("\n%s\n", name);
+}
+
+void bench_report(const char* name, size_t ops, double start) {
+    double secs = bench_now() - start;
+    printf("  %-40s %12.0f ops/sec %10.3f ms %8ld KB peak RSS\n",
+           name, (secs > 0) ? ((double)ops / secs) : 0.0, secs * 1e3,
+           bench_rss_kb());
+}
+
+void bench_report_footprint(const char* name, size_t count, size_t before) {
+    size_t after = bench_heap_bytes();
+    size_t bytes = (after > before) ? (after - before) : 0;
+    printf("  %-40s %12zu elements %10.1f bytes each %8zu KB total\n",
+           name, count, (count > 0) ? ((double)bytes / (double)count) : 0.0,
+           bytes / 1024u);
+}
@@ -0,0 +1,51 @@
+/**
+  @file bench.h
+  @brief A minimal harness for timing library operations.
+  */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define BENCH_SUITE(name) void name(void)
+
+#define RUN_BENCH_SUITE(name) \
+    extern BENCH_SUITE(name); \
+    bench_suite(#name);       \
+    name();
+
+/**
+ * @brief Returns a monotonic timestamp in seconds.
+ */
+double bench_now(void);
+
+/**
+ * @brief Returns the peak resident set size of the process in kilobytes.
+ */
+long bench_rss_kb(void);
+
+/**
+ * @brief Returns the number of bytes currently allocated from the heap, or the
+ *        peak resident set size where the C library cannot report it.
+ */
+size_t bench_heap_bytes(void);
+
+/**
+ * @brief Prints the heading for a suite of benchmarks.
+ */
+void bench_suite(const char* name);
+
+/**
+ * @brief Prints the throughput of a benchmark that performed the given number
+ *        of operations since the start timestamp.
+ */
+void bench_report(const char* name, size_t ops, double start);
+
+/**
+ * @brief Prints the heap growth per element of a structure holding the given
+ *        number of elements since the heap held the given number of bytes.
+ */
+void bench_report_footprint(const char* name, size_t count, size_t before);
+
+#endif /* BENCH_H */
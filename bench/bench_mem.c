@@ -0,0 +1,689 @@
+// Benchmark Framework Includes
+#include "bench.h"
+
+// File To Benchmark
+#include "mem.h"
+#include "epoch.h"
+#include "list.h"
+#include "map.h"
+#include "flatmap.h"
+#include "set.h"
+#include "str.h"
+#include "vec.h"
+#include "rbt.h"
+#include "murmur3.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define NUM_OBJECTS 1000000u
+#define NUM_KEYS    200000u
+#define NUM_RETAINS 10000000u
+#define NUM_THREADS 4
+#define NUM_REQUESTS 2000u
+#define REQUEST_OBJS 500u
+#define NUM_CONFIG_KEYS 64u
+#define NUM_LOOKUPS 2000000u
+
+static uint32_t hash_int(void* obj) {
+    intptr_t val = mem_unbox(obj);
+    return murmur3_32((uint8_t*)&val, sizeof(intptr_t));
+}
+
+static int cmp_int(void* env, void* obja, void* objb) {
+    intptr_t a = mem_unbox(obja);
+    intptr_t b = mem_unbox(objb);
+    (void)env;
+    return (a == b) ? 0 : ((a < b) ? -1 : 1);
+}
+
+static uint32_t hash_str(void* obj) {
+    return murmur3_32((uint8_t*)str_cstr((str_t*)obj), (uint32_t)str_size((str_t*)obj));
+}
+
+static int cmp_str(void* env, void* obja, void* objb) {
+    (void)env;
+    return str_compare((str_t*)obja, (str_t*)objb);
+}
+
+static void* retain_release_worker(void* p_obj) {
+    size_t i;
+    for (i = 0; i < NUM_RETAINS; i++) {
+        mem_retain(p_obj);
+        mem_release(p_obj);
+    }
+    return NULL;
+}
+
+static void bench_threads(const char* name, size_t nthreads, void* p_obj) {
+    pthread_t threads[NUM_THREADS];
+    double start = bench_now();
+    size_t i;
+    for (i = 0; i < nthreads; i++)
+        pthread_create(&threads[i], NULL, retain_release_worker, p_obj);
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    bench_report(name, nthreads * NUM_RETAINS, start);
+}
+
+BENCH_SUITE(MemBench) {
+    static void* objs[NUM_OBJECTS];
+    double start;
+    size_t i;
+
+    printf("  (MEM_SLAB_ALLOCATOR = %d, MEM_TAGGED_INTEGERS = %d, LEAK_DETECT_LEVEL = %d)\n",
+           MEM_SLAB_ALLOCATOR, MEM_TAGGED_INTEGERS, LEAK_DETECT_LEVEL);
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_release(mem_box((intptr_t)i));
+    bench_report("box alloc/release churn", NUM_OBJECTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        objs[i] = mem_box((intptr_t)i);
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_release(objs[i]);
+    bench_report("box bulk alloc then release", NUM_OBJECTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        objs[i] = str_new("short string");
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_release(objs[i]);
+    bench_report("short str_t alloc then release", NUM_OBJECTS, start);
+
+    start = bench_now();
+    {
+        list_t* list = list_new();
+        for (i = 0; i < NUM_OBJECTS; i++)
+            list_push_back(list, mem_box((intptr_t)i));
+        list_clear(list);
+        mem_release(list);
+    }
+    bench_report("list push_back and clear", NUM_OBJECTS, start);
+
+    start = bench_now();
+    {
+        map_t* map = map_new(cmp_new(NULL, cmp_int), hash_int);
+        for (i = 0; i < NUM_KEYS; i++)
+            map_insert(map, mem_box((intptr_t)i), mem_box((intptr_t)i));
+        mem_release(map);
+    }
+    bench_report("map insert and release", NUM_KEYS, start);
+
+    start = bench_now();
+    {
+        set_t* set = set_new(cmp_new(NULL, cmp_int), hash_int);
+        for (i = 0; i < NUM_KEYS; i++)
+            set_insert(set, mem_box((intptr_t)i));
+        mem_release(set);
+    }
+    bench_report("set insert and release", NUM_KEYS, start);
+}
+
+BENCH_SUITE(RefcountBench) {
+    void* p_local  = mem_allocate(sizeof(int), NULL);
+    void* p_shared = mem_share(mem_allocate(sizeof(int), NULL));
+    double start;
+
+    printf("  (MEM_ATOMIC_REFCOUNT = %d, MEM_BIASED_REFCOUNT = %d)\n",
+           MEM_ATOMIC_REFCOUNT, MEM_BIASED_REFCOUNT);
+
+    start = bench_now();
+    retain_release_worker(p_local);
+    bench_report("retain/release unshared object", NUM_RETAINS, start);
+
+    start = bench_now();
+    retain_release_worker(p_shared);
+    bench_report("retain/release shared object", NUM_RETAINS, start);
+
+    bench_threads("retain/release shared, 2 threads", 2, p_shared);
+    bench_threads("retain/release shared, 4 threads", NUM_THREADS, p_shared);
+
+    mem_release(p_local);
+    mem_release(p_shared);
+}
+
+static void handle_request(void) {
+    vec_t* strs = vec_new(0);
+    map_t* map = map_new(cmp_new(NULL, cmp_int), hash_int);
+    size_t i;
+    for (i = 0; i < REQUEST_OBJS; i++) {
+        vec_push_back(strs, str_new("header: value"));
+        map_insert(map, mem_box((intptr_t)i), str_new("value"));
+    }
+    mem_release(strs);
+    mem_release(map);
+}
+
+BENCH_SUITE(ArenaBench) {
+    double start;
+    size_t i;
+
+    start = bench_now();
+    for (i = 0; i < NUM_REQUESTS; i++)
+        handle_request();
+    bench_report("request objects released one by one", NUM_REQUESTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_REQUESTS; i++) {
+        mem_arena_t* arena = mem_arena_new(0);
+        mem_arena_enter(arena);
+        handle_request();
+        mem_arena_exit(arena);
+        mem_release(arena);
+    }
+    bench_report("request objects reclaimed with an arena", NUM_REQUESTS, start);
+}
+
+static list_t* build_list(void) {
+    list_t* list = list_new();
+    size_t i;
+    for (i = 0; i < NUM_OBJECTS; i++)
+        list_push_back(list, mem_box((intptr_t)i));
+    return list;
+}
+
+BENCH_SUITE(ReleaseBench) {
+    list_t* list = build_list();
+    double start, call_start, max_pause = 0;
+    size_t calls = 0, remaining = 1;
+
+    start = bench_now();
+    mem_release(list);
+    bench_report("release 1M node list in one call", NUM_OBJECTS, start);
+
+    list = build_list();
+    mem_defer(true);
+    start = bench_now();
+    mem_release(list);
+    while (remaining > 0) {
+        double pause;
+        call_start = bench_now();
+        remaining = mem_drain(10000);
+        pause = bench_now() - call_start;
+        max_pause = (pause > max_pause) ? pause : max_pause;
+        calls++;
+    }
+    mem_defer(false);
+    bench_report("release 1M node list, drain(10000)", NUM_OBJECTS, start);
+    printf("  %-40s %12zu calls %10.3f ms max pause\n", "", calls, max_pause * 1e3);
+}
+
+#define NUM_CHURN   2000000u
+#define CHURN_BATCH 256u
+
+/* Allocates and releases small objects in batches, like a worker building
+ * and tearing down short lived structures */
+static void* churn_worker(void* p_arg) {
+    void* objs[CHURN_BATCH];
+    size_t i, j;
+    (void)p_arg;
+    for (i = 0; i < NUM_CHURN; i += CHURN_BATCH) {
+        for (j = 0; j < CHURN_BATCH; j++)
+            objs[j] = mem_allocate(16 + (j % 4) * 16, NULL);
+        for (j = 0; j < CHURN_BATCH; j++)
+            mem_release(objs[j]);
+    }
+    return NULL;
+}
+
+/* Releases on this thread whatever the paired producer allocated */
+typedef struct {
+    void* objs[CHURN_BATCH];
+    bool full;
+} handoff_t;
+
+static void* producer_worker(void* p_arg) {
+    handoff_t* p_handoff = (handoff_t*)p_arg;
+    size_t i, j;
+    for (i = 0; i < NUM_CHURN; i += CHURN_BATCH) {
+        while (__atomic_load_n(&p_handoff->full, __ATOMIC_ACQUIRE))
+            sched_yield();
+        for (j = 0; j < CHURN_BATCH; j++)
+            p_handoff->objs[j] = mem_allocate(32, NULL);
+        __atomic_store_n(&p_handoff->full, true, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void* consumer_worker(void* p_arg) {
+    handoff_t* p_handoff = (handoff_t*)p_arg;
+    size_t i, j;
+    for (i = 0; i < NUM_CHURN; i += CHURN_BATCH) {
+        while (!__atomic_load_n(&p_handoff->full, __ATOMIC_ACQUIRE))
+            sched_yield();
+        for (j = 0; j < CHURN_BATCH; j++)
+            mem_release(p_handoff->objs[j]);
+        __atomic_store_n(&p_handoff->full, false, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+BENCH_SUITE(ScalingBench) {
+    pthread_t threads[2 * NUM_THREADS];
+    handoff_t handoffs[NUM_THREADS];
+    char name[64];
+    double start;
+    size_t nthreads, i;
+
+    printf("  (MEM_SLAB_ALLOCATOR = %d, MEM_SLAB_MAGAZINE_SIZE = %d, %ld CPUs)\n",
+           MEM_SLAB_ALLOCATOR, MEM_SLAB_MAGAZINE_SIZE, sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (nthreads = 1; nthreads <= NUM_THREADS; nthreads *= 2) {
+        start = bench_now();
+        for (i = 0; i < nthreads; i++)
+            pthread_create(&threads[i], NULL, churn_worker, NULL);
+        for (i = 0; i < nthreads; i++)
+            pthread_join(threads[i], NULL);
+        snprintf(name, sizeof(name), "alloc/release churn, %zu threads", nthreads);
+        bench_report(name, nthreads * NUM_CHURN, start);
+    }
+
+    for (nthreads = 1; nthreads <= NUM_THREADS; nthreads *= 2) {
+        start = bench_now();
+        for (i = 0; i < nthreads; i++) {
+            handoffs[i].full = false;
+            pthread_create(&threads[2 * i], NULL, producer_worker, &handoffs[i]);
+            pthread_create(&threads[(2 * i) + 1], NULL, consumer_worker, &handoffs[i]);
+        }
+        for (i = 0; i < 2 * nthreads; i++)
+            pthread_join(threads[i], NULL);
+        snprintf(name, sizeof(name), "cross-thread release, %zu pairs", nthreads);
+        bench_report(name, nthreads * NUM_CHURN, start);
+    }
+}
+
+BENCH_SUITE(BatchBench) {
+    void** p_objs = (void**)malloc(sizeof(void*) * NUM_OBJECTS);
+    void* p_shared = mem_allocate(sizeof(int), NULL);
+    vec_t* p_vec = vec_new(0);
+    double start;
+    size_t i;
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_retain(p_shared);
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_release(p_shared);
+    bench_report("retain/release one object 1M times", NUM_OBJECTS, start);
+
+    for (i = 0; i < NUM_OBJECTS; i++)
+        p_objs[i] = p_shared;
+    start = bench_now();
+    mem_retain_n(p_shared, NUM_OBJECTS);
+    mem_release_array(p_objs, NUM_OBJECTS);
+    bench_report("retain_n/release_array one object", NUM_OBJECTS, start);
+
+    start = bench_now();
+    vec_resize(p_vec, NUM_OBJECTS, mem_retain(p_shared));
+    vec_clear(p_vec);
+    bench_report("vec_resize 1M with one value and clear", NUM_OBJECTS, start);
+
+    for (i = 0; i < NUM_OBJECTS; i++)
+        p_objs[i] = mem_allocate(sizeof(int), NULL);
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_release(p_objs[i]);
+    bench_report("release 1M objects one by one", NUM_OBJECTS, start);
+
+    for (i = 0; i < NUM_OBJECTS; i++)
+        p_objs[i] = mem_allocate(sizeof(int), NULL);
+    start = bench_now();
+    mem_release_array(p_objs, NUM_OBJECTS);
+    bench_report("release 1M objects with release_array", NUM_OBJECTS, start);
+
+    mem_release(p_vec);
+    mem_release(p_shared);
+    free(p_objs);
+}
+
+/* Every structure is kept alive until the end so that memory recycled from
+ * one workload is not counted as free for the next. Run before the other
+ * suites so the slab pools start out empty. */
+BENCH_SUITE(FootprintBench) {
+    static void* objs[NUM_OBJECTS];
+    static void* strs[NUM_OBJECTS];
+    list_t* list;
+    map_t* map;
+    set_t* set;
+    rbt_t* tree;
+    size_t before;
+    size_t i;
+
+    printf("  (MEM_COMPACT_HEADER = %d, MEM_SLAB_ALLOCATOR = %d)\n",
+           MEM_COMPACT_HEADER, MEM_SLAB_ALLOCATOR);
+
+    before = bench_heap_bytes();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        objs[i] = mem_allocate(sizeof(intptr_t), NULL);
+    bench_report_footprint("8-byte objects", NUM_OBJECTS, before);
+
+    before = bench_heap_bytes();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        strs[i] = str_new("short string");
+    bench_report_footprint("short str_t", NUM_OBJECTS, before);
+
+    before = bench_heap_bytes();
+    list = build_list();
+    bench_report_footprint("list of boxes", NUM_OBJECTS, before);
+
+    before = bench_heap_bytes();
+    map = map_new(cmp_new(NULL, cmp_int), hash_int);
+    for (i = 0; i < NUM_KEYS; i++)
+        map_insert(map, mem_box((intptr_t)i), mem_box((intptr_t)i));
+    bench_report_footprint("map of boxes", NUM_KEYS, before);
+
+    before = bench_heap_bytes();
+    set = set_new(cmp_new(NULL, cmp_int), hash_int);
+    for (i = 0; i < NUM_KEYS; i++)
+        set_insert(set, mem_box((intptr_t)i));
+    bench_report_footprint("set of boxes", NUM_KEYS, before);
+
+    before = bench_heap_bytes();
+    tree = rbt_new(cmp_new(NULL, cmp_int));
+    for (i = 0; i < NUM_KEYS; i++)
+        rbt_insert(tree, mem_box((intptr_t)i));
+    bench_report_footprint("rbt of boxes", NUM_KEYS, before);
+
+    for (i = 0; i < NUM_OBJECTS; i++) {
+        mem_release(objs[i]);
+        mem_release(strs[i]);
+    }
+    mem_release(list);
+    mem_release(map);
+    mem_release(set);
+    mem_release(tree);
+}
+
+typedef struct {
+    map_t* map;
+    str_t** keys;
+} config_t;
+
+/* Looks keys up the way a request handler would, holding a reference to the
+ * key and the value while it uses them */
+static void* lookup_worker(void* p_arg) {
+    config_t* p_config = (config_t*)p_arg;
+    size_t i;
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        str_t* key = mem_retain(p_config->keys[i % NUM_CONFIG_KEYS]);
+        void* value = mem_retain(map_lookup(p_config->map, key));
+        mem_release(value);
+        mem_release(key);
+    }
+    return NULL;
+}
+
+static void bench_lookups(const char* name, config_t* p_config) {
+    pthread_t threads[NUM_THREADS];
+    double start = bench_now();
+    size_t i;
+    for (i = 0; i < NUM_THREADS; i++)
+        pthread_create(&threads[i], NULL, lookup_worker, p_config);
+    for (i = 0; i < NUM_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    bench_report(name, NUM_THREADS * NUM_LOOKUPS, start);
+}
+
+static config_t* config_new(bool immortal) {
+    static str_t* keys[2][NUM_CONFIG_KEYS];
+    static config_t configs[2];
+    config_t* p_config = &configs[immortal];
+    char name[32];
+    size_t i;
+    p_config->map  = map_new(cmp_new(NULL, cmp_str), hash_str);
+    p_config->keys = keys[immortal];
+    for (i = 0; i < NUM_CONFIG_KEYS; i++) {
+        str_t* value;
+        sprintf(name, "config.key.%zu", i);
+        p_config->keys[i] = mem_share(str_new(name));
+        value = mem_share(str_new(name));
+        if (immortal) {
+            mem_make_immortal(p_config->keys[i]);
+            mem_make_immortal(value);
+        }
+        map_insert(p_config->map, mem_retain(p_config->keys[i]), value);
+    }
+    return p_config;
+}
+
+static void config_free(config_t* p_config) {
+    size_t i;
+    for (i = 0; i < NUM_CONFIG_KEYS; i++)
+        mem_release(p_config->keys[i]);
+    mem_release(p_config->map);
+}
+
+BENCH_SUITE(ImmortalBench) {
+    config_t* p_shared   = config_new(false);
+    config_t* p_immortal = config_new(true);
+    bench_lookups("lookups with shared keys, 4 threads", p_shared);
+    bench_lookups("lookups with immortal keys, 4 threads", p_immortal);
+    config_free(p_shared);
+    config_free(p_immortal);
+}
+
+static void* Epoch_Shared = NULL;
+static bool Epoch_Done = false;
+
+static void* epoch_reader(void* p_arg) {
+    size_t* p_reads = (size_t*)p_arg;
+    mem_epoch_register();
+    while (!__atomic_load_n(&Epoch_Done, __ATOMIC_ACQUIRE)) {
+        mem_epoch_enter();
+        (void)*(volatile intptr_t*)__atomic_load_n(&Epoch_Shared, __ATOMIC_ACQUIRE);
+        mem_epoch_exit();
+        (*p_reads)++;
+    }
+    mem_epoch_unregister();
+    return NULL;
+}
+
+BENCH_SUITE(EpochBench) {
+    pthread_t threads[NUM_THREADS];
+    size_t reads[NUM_THREADS] = { 0 };
+    size_t total_reads = 0;
+    double start;
+    size_t i;
+
+    mem_epoch_register();
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_release(mem_allocate(sizeof(intptr_t), NULL));
+    bench_report("allocate and release", NUM_OBJECTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_retire(mem_allocate(sizeof(intptr_t), NULL));
+    mem_epoch_barrier();
+    bench_report("allocate and retire", NUM_OBJECTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++) {
+        mem_epoch_enter();
+        mem_epoch_exit();
+    }
+    bench_report("enter/exit critical section", NUM_OBJECTS, start);
+
+    Epoch_Shared = mem_allocate(sizeof(intptr_t), NULL);
+    for (i = 0; i < NUM_THREADS - 1; i++)
+        pthread_create(&threads[i], NULL, epoch_reader, &reads[i]);
+    start = bench_now();
+    for (i = 0; i < NUM_OBJECTS; i++)
+        mem_retire(__atomic_exchange_n(&Epoch_Shared, mem_allocate(sizeof(intptr_t), NULL), __ATOMIC_ACQ_REL));
+    bench_report("swap and retire, 3 reader threads", NUM_OBJECTS, start);
+    __atomic_store_n(&Epoch_Done, true, __ATOMIC_RELEASE);
+    for (i = 0; i < NUM_THREADS - 1; i++) {
+        pthread_join(threads[i], NULL);
+        total_reads += reads[i];
+    }
+    printf("  %-40s %12zu reads\n", "", total_reads);
+    mem_retire(Epoch_Shared);
+    mem_epoch_unregister();
+}
+
+static void report_latency(const char* name, size_t ops, double start) {
+    double secs = bench_now() - start;
+    bench_report(name, ops, start);
+    printf("  %-40s %12.1f ns/lookup\n", "", secs * 1e9 / (double)ops);
+}
+
+/* Random lookups, half of them for keys that are absent */
+BENCH_SUITE(LookupBench) {
+    void** keys = (void**)malloc(sizeof(void*) * NUM_OBJECTS);
+    void** values = (void**)malloc(sizeof(void*) * NUM_OBJECTS);
+    map_t* map;
+    flatmap_t* flat;
+    uint32_t seed;
+    size_t found = 0;
+    double start;
+    size_t i;
+
+    start = bench_now();
+    map = map_new(cmp_new(NULL, cmp_int), hash_int);
+    for (i = 0; i < NUM_OBJECTS; i++)
+        map_insert(map, mem_box((intptr_t)(i * 2)), mem_box((intptr_t)i));
+    bench_report("map_insert 1M keys", NUM_OBJECTS, start);
+
+    /* Shuffled so the build has to sort */
+    for (i = 0; i < NUM_OBJECTS; i++) {
+        size_t j = (i * 7919u) % NUM_OBJECTS;
+        keys[i] = mem_box((intptr_t)(j * 2));
+        values[i] = mem_box((intptr_t)j);
+    }
+    start = bench_now();
+    flat = flatmap_from_arrays(cmp_new(NULL, cmp_int), NUM_OBJECTS, keys, values);
+    bench_report("flatmap_from_arrays 1M keys", NUM_OBJECTS, start);
+
+    seed = 1;
+    start = bench_now();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        void* key;
+        seed = (seed * 1664525u) + 1013904223u;
+        key = mem_box((intptr_t)(seed % (2 * NUM_OBJECTS)));
+        found += (NULL != map_lookup(map, key));
+        mem_release(key);
+    }
+    report_latency("map_lookup", NUM_LOOKUPS, start);
+
+    seed = 1;
+    start = bench_now();
+    for (i = 0; i < NUM_LOOKUPS; i++) {
+        void* key;
+        seed = (seed * 1664525u) + 1013904223u;
+        key = mem_box((intptr_t)(seed % (2 * NUM_OBJECTS)));
+        found += (NULL != flatmap_lookup(flat, key));
+        mem_release(key);
+    }
+    report_latency("flatmap_lookup", NUM_LOOKUPS, start);
+
+    printf("  %-40s %12zu found\n", "", found);
+    mem_release(map);
+    mem_release(flat);
+    free(keys);
+    free(values);
+}
+
+#define NUM_LIST_OPS   100000u
+#define NUM_LIST_WALKS 100u
+
+BENCH_SUITE(ListIndexBench) {
+    list_t* list = build_list();
+    list_node_t* node;
+    double start;
+    uint32_t seed = 1;
+    size_t i, j, total = 0;
+
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++)
+        total += list_size(list);
+    report_latency("list_size", NUM_LIST_OPS, start);
+
+    /* Positional access as it was before the index, walking from the head */
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_WALKS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        node = list->head;
+        for (j = seed % NUM_OBJECTS; j > 0; j--)
+            node = node->next;
+        total += (size_t)mem_unbox(node->contents);
+    }
+    report_latency("walk to random index", NUM_LIST_WALKS, start);
+
+    /* The first few accesses walk the list until the index pays for itself */
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        total += (size_t)mem_unbox(list_at(list, seed % NUM_OBJECTS)->contents);
+    }
+    report_latency("list_at random index", NUM_LIST_OPS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        list_insert(list, seed % list_size(list), mem_box((intptr_t)i));
+    }
+    report_latency("list_insert random index", NUM_LIST_OPS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        list_delete(list, seed % list_size(list));
+    }
+    report_latency("list_delete random index", NUM_LIST_OPS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        list_push_back(list, mem_box((intptr_t)i));
+        mem_release(list_pop_front(list));
+    }
+    report_latency("push_back and pop_front", NUM_LIST_OPS, start);
+
+    /* Edits next to the node just found keep the index */
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        node = list_at(list, seed % list_size(list));
+        if (0 == (i & 1))
+            list_insert_after(list, node, mem_box((intptr_t)i));
+        else
+            list_delete_node(list, node);
+    }
+    report_latency("list_at and edit the node found", NUM_LIST_OPS, start);
+
+    /* The walk again, now that updates have scattered the nodes */
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_WALKS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        node = list->head;
+        for (j = seed % list_size(list); j > 0; j--)
+            node = node->next;
+        total += (size_t)mem_unbox(node->contents);
+    }
+    report_latency("walk to random index after updates", NUM_LIST_WALKS, start);
+
+    /* Edits next to any other node in the middle find its position through
+     * the index */
+    node = list_at(list, NUM_OBJECTS / 2);
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        total += (size_t)mem_unbox(list_at(list, seed % list_size(list))->contents);
+        list_insert_after(list, node, mem_box((intptr_t)i));
+    }
+    report_latency("list_at and edit another node", NUM_LIST_OPS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_LIST_OPS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        total += (size_t)mem_unbox(list_at(list, seed % NUM_OBJECTS)->contents);
+    }
+    report_latency("list_at after updates", NUM_LIST_OPS, start);
+
+    printf("  %-40s %12zu checksum\n", "", total);
+    list_clear(list);
+    mem_release(list);
+}
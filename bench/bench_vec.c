@@ -0,0 +1,594 @@
+// Benchmark Framework Includes
+#include "bench.h"
+
+// File To Benchmark
+#include "vec.h"
+#include "tvec.h"
+#include "segvec.h"
+#include "gapvec.h"
+#include "pvec.h"
+#include "str.h"
+#include <unistd.h>
+
+#ifndef NUM_LARGE_ELEMS
+#define NUM_LARGE_ELEMS (1u << 27)
+#endif
+#define NUM_PROBES 20000000u
+
+#define NUM_EDITS  200000u
+#define NUM_EDIT_BASE (1u << 16)
+#define NUM_PUSHES 10000000u
+#define NUM_SNAPSHOT_ELEMS (1u << 20)
+#define NUM_SNAPSHOTS 100u
+#define NUM_BULK (1u << 21)
+#define NUM_SMALL_REDUCES 200u
+#define NUM_SORTED 10000000u
+#define NUM_SMALL  1000000u
+#define NUM_TIMED  (1u << 25)
+#define NUM_VALUES 1000000u
+#define NUM_SCANS  20u
+
+/* The reference point: a bare array grown by doubling like std::vector */
+static void raw_push_back(void*** p_array, size_t* p_size, size_t* p_capacity, void* data) {
+    if (*p_size == *p_capacity) {
+        *p_capacity = (0 == *p_capacity) ? 8 : (*p_capacity * 2);
+        *p_array = (void**)realloc(*p_array, sizeof(void*) * *p_capacity);
+    }
+    (*p_array)[(*p_size)++] = data;
+}
+
+static void bench_push_back(const char* name, unsigned percent) {
+    vec_t* p_vec = vec_new(0);
+    double start;
+    size_t i;
+    if (0 != percent)
+        vec_set_growth(p_vec, percent);
+    start = bench_now();
+    for (i = 0; i < NUM_PUSHES; i++)
+        vec_push_back(p_vec, (void*)((i << 1) | 1u));
+    bench_report(name, NUM_PUSHES, start);
+    mem_release(p_vec);
+}
+
+BENCH_SUITE(GrowthBench) {
+    void** p_array = NULL;
+    size_t size = 0, capacity = 0;
+    double start;
+    size_t i;
+
+    start = bench_now();
+    for (i = 0; i < NUM_PUSHES; i++)
+        raw_push_back(&p_array, &size, &capacity, (void*)((i << 1) | 1u));
+    bench_report("raw array push_back, 2x realloc", NUM_PUSHES, start);
+    free(p_array);
+
+    bench_push_back("vec_push_back, 2x growth", 200);
+    bench_push_back("vec_push_back, 1.5x growth", 150);
+}
+
+BENCH_SUITE(BulkVecBench) {
+    void** p_elems = (void**)malloc(sizeof(void*) * NUM_PUSHES);
+    vec_t* p_vec;
+    vec_t* p_copy;
+    double start;
+    size_t i;
+    for (i = 0; i < NUM_PUSHES; i++)
+        p_elems[i] = (void*)((i << 1) | 1u);
+
+    start = bench_now();
+    p_vec = vec_new(0);
+    for (i = 0; i < NUM_PUSHES; i++)
+        vec_push_back(p_vec, p_elems[i]);
+    bench_report("vec_push_back per element", NUM_PUSHES, start);
+    mem_release(p_vec);
+
+    start = bench_now();
+    p_vec = vec_new(0);
+    vec_append_array(p_vec, NUM_PUSHES, p_elems);
+    bench_report("vec_append_array", NUM_PUSHES, start);
+
+    /* Refilling a cleared vector leaves out the page faults of a new buffer */
+    vec_clear(p_vec);
+    start = bench_now();
+    for (i = 0; i < NUM_PUSHES; i++)
+        vec_push_back(p_vec, p_elems[i]);
+    bench_report("vec_push_back per element, reused", NUM_PUSHES, start);
+    vec_clear(p_vec);
+    start = bench_now();
+    vec_append_array(p_vec, NUM_PUSHES, p_elems);
+    bench_report("vec_append_array, reused", NUM_PUSHES, start);
+
+    start = bench_now();
+    p_copy = vec_from_array(0, NULL);
+    vec_extend(p_copy, p_vec);
+    bench_report("vec_extend", NUM_PUSHES, start);
+    mem_release(p_copy);
+
+    /* Prepending in chunks shifts the whole vector once per chunk */
+    start = bench_now();
+    p_copy = vec_new(0);
+    for (i = 0; i < NUM_PUSHES; i += 1000000u)
+        vec_insert_array(p_copy, 0, 1000000u, &p_elems[i]);
+    bench_report("vec_insert_array at the front", NUM_PUSHES, start);
+    mem_release(p_copy);
+
+    start = bench_now();
+    vec_erase(p_vec, 0, NUM_PUSHES - 2);
+    bench_report("vec_erase of all but one", NUM_PUSHES - 1, start);
+    mem_release(p_vec);
+    free(p_elems);
+}
+
+static int cmp_unboxed(void* env, void* obja, void* objb) {
+    intptr_t a = mem_unbox(obja);
+    intptr_t b = mem_unbox(objb);
+    (void)env;
+    return (a == b) ? 0 : ((a < b) ? -1 : 1);
+}
+
+static int qsort_unboxed(const void* p_a, const void* p_b) {
+    return cmp_unboxed(NULL, *(void* const*)p_a, *(void* const*)p_b);
+}
+
+static vec_t* random_vec(size_t num_elements) {
+    vec_t* p_vec = vec_new(0);
+    uint32_t seed = 7;
+    size_t i;
+    vec_reserve(p_vec, num_elements);
+    for (i = 0; i < num_elements; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        vec_push_back(p_vec, mem_box((intptr_t)(seed >> 4)));
+    }
+    return p_vec;
+}
+
+BENCH_SUITE(SortBench) {
+    cmp_t* p_cmp = cmp_new(NULL, cmp_unboxed);
+    vec_t* p_vec = random_vec(NUM_SORTED);
+    void** p_array = (void**)malloc(sizeof(void*) * NUM_SORTED);
+    size_t found = 0;
+    double start;
+    size_t i;
+
+    printf("  (%zu elements, %ld processors, VEC_SORT_MAX_THREADS = %d)\n",
+           (size_t)NUM_SORTED, sysconf(_SC_NPROCESSORS_ONLN), VEC_SORT_MAX_THREADS);
+
+    /* The old way: copy the pointers out and sort them with qsort */
+    memcpy(p_array, p_vec->p_buffer, sizeof(void*) * NUM_SORTED);
+    start = bench_now();
+    qsort(p_array, NUM_SORTED, sizeof(void*), qsort_unboxed);
+    bench_report("qsort of a copied array", NUM_SORTED, start);
+
+    start = bench_now();
+    vec_sort(p_vec, p_cmp);
+    bench_report("vec_sort", NUM_SORTED, start);
+    mem_release(p_vec);
+
+    p_vec = random_vec(NUM_SORTED);
+    start = bench_now();
+    vec_stable_sort(p_vec, p_cmp);
+    bench_report("vec_stable_sort", NUM_SORTED, start);
+
+    start = bench_now();
+    vec_sort(p_vec, p_cmp);
+    bench_report("vec_sort of a sorted vector", NUM_SORTED, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SORTED; i++)
+        found += vec_binary_search(p_vec, p_cmp, p_array[i]);
+    bench_report("vec_binary_search", NUM_SORTED, start);
+
+    if (found != NUM_SORTED)
+        puts("  binary search missed an element");
+    mem_release(p_vec);
+    mem_release(p_cmp);
+    free(p_array);
+}
+
+BENCH_SUITE(SmallVecBench) {
+    static vec_t* vecs[NUM_SMALL];
+    str_t* line = str_new("key=value");
+    str_t* sep = str_new("=");
+    size_t before;
+    double start;
+    size_t i;
+
+    printf("  (VEC_INLINE_CAPACITY = %d)\n", VEC_INLINE_CAPACITY);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SMALL; i++) {
+        vec_t* p_vec = vec_new(0);
+        vec_push_back(p_vec, (void*)((i << 1) | 1u));
+        vec_push_back(p_vec, (void*)((i << 1) | 1u));
+        vec_push_back(p_vec, (void*)((i << 1) | 1u));
+        mem_release(p_vec);
+    }
+    bench_report("create, fill with 3 and release", NUM_SMALL, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SMALL; i++)
+        mem_release(str_split(line, sep));
+    bench_report("str_split of a short line", NUM_SMALL, start);
+
+    before = bench_heap_bytes();
+    for (i = 0; i < NUM_SMALL; i++)
+        vecs[i] = vec_new(3, (void*)1, (void*)3, (void*)5);
+    bench_report_footprint("vectors of 3 elements", NUM_SMALL, before);
+    for (i = 0; i < NUM_SMALL; i++)
+        mem_release(vecs[i]);
+    mem_release(line);
+    mem_release(sep);
+}
+
+static void report_worst(double worst, size_t slow) {
+    printf("  %-40s %12.1f us worst push, %zu over 100 us\n", "", worst * 1e6, slow);
+}
+
+/* Every push is timed to find the slowest, which for vec_t is the one that
+ * regrows the whole array */
+BENCH_SUITE(SegVecBench) {
+    vec_t* p_vec = vec_new(0);
+    segvec_t* p_seg = segvec_new();
+    uintptr_t sum = 0;
+    double start, worst, before, after;
+    size_t i, slow;
+
+    printf("  (%u pushes, SEGVEC_CHUNK_SIZE = %u)\n", NUM_TIMED, (unsigned)SEGVEC_CHUNK_SIZE);
+
+    worst = 0.0;
+    slow = 0;
+    start = bench_now();
+    for (i = 0; i < NUM_TIMED; i++) {
+        before = bench_now();
+        vec_push_back(p_vec, (void*)((i << 1) | 1u));
+        after = bench_now();
+        worst = ((after - before) > worst) ? (after - before) : worst;
+        slow += ((after - before) > 100e-6);
+    }
+    bench_report("vec_push_back, timed", NUM_TIMED, start);
+    report_worst(worst, slow);
+
+    worst = 0.0;
+    slow = 0;
+    start = bench_now();
+    for (i = 0; i < NUM_TIMED; i++) {
+        before = bench_now();
+        segvec_push_back(p_seg, (void*)((i << 1) | 1u));
+        after = bench_now();
+        worst = ((after - before) > worst) ? (after - before) : worst;
+        slow += ((after - before) > 100e-6);
+    }
+    bench_report("segvec_push_back, timed", NUM_TIMED, start);
+    report_worst(worst, slow);
+
+    start = bench_now();
+    for (i = 0; i < NUM_TIMED; i++)
+        sum += (uintptr_t)vec_at(p_vec, i);
+    bench_report("vec_at scan", NUM_TIMED, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_TIMED; i++)
+        sum += (uintptr_t)segvec_at(p_seg, i);
+    bench_report("segvec_at scan", NUM_TIMED, start);
+
+    mem_release(p_vec);
+    mem_release(p_seg);
+    if (0 == sum)
+        puts("");
+}
+
+/* An editor-style stream: the cursor wanders a few places either way and
+ * each step inserts or erases one element there. The elements are NULL so
+ * that only the containers are measured. */
+static bool edit_step(uint32_t* p_seed, size_t* p_cursor, size_t size) {
+    size_t cursor = *p_cursor;
+    *p_seed = (*p_seed * 1664525u) + 1013904223u;
+    cursor += ((*p_seed >> 8) % 17u);
+    cursor = (cursor > 8u) ? (cursor - 8u) : 0u;
+    *p_cursor = (cursor > size) ? size : cursor;
+    return ((*p_seed >> 28) & 1u) || (*p_cursor == size);
+}
+
+BENCH_SUITE(GapVecBench) {
+    vec_t* p_vec = vec_new(0);
+    gapvec_t* p_gap = gapvec_new();
+    void* elem = NULL;
+    uint32_t seed;
+    size_t cursor;
+    double start;
+    size_t i;
+
+    printf("  (%u edits near a cursor in %u elements)\n", NUM_EDITS, NUM_EDIT_BASE);
+    vec_resize(p_vec, NUM_EDIT_BASE, NULL);
+    for (i = 0; i < NUM_EDIT_BASE; i++)
+        gapvec_push_back(p_gap, NULL);
+
+    seed = 11;
+    cursor = NUM_EDIT_BASE / 2;
+    start = bench_now();
+    for (i = 0; i < NUM_EDITS; i++) {
+        if (edit_step(&seed, &cursor, vec_size(p_vec)))
+            vec_insert_array(p_vec, cursor, 1, &elem);
+        else
+            vec_erase(p_vec, cursor, cursor);
+    }
+    bench_report("vec_insert_array / vec_erase", NUM_EDITS, start);
+
+    seed = 11;
+    cursor = NUM_EDIT_BASE / 2;
+    start = bench_now();
+    for (i = 0; i < NUM_EDITS; i++) {
+        if (edit_step(&seed, &cursor, gapvec_size(p_gap)))
+            gapvec_insert(p_gap, cursor, 1, &elem);
+        else
+            gapvec_erase(p_gap, cursor, cursor);
+    }
+    bench_report("gapvec_insert / gapvec_erase", NUM_EDITS, start);
+
+    if (vec_size(p_vec) != gapvec_size(p_gap))
+        puts("  sizes differ");
+    mem_release(p_vec);
+    mem_release(p_gap);
+}
+
+/* A writer publishes a new version after every update while readers keep
+ * the old ones. With vec_t each version is a full copy. */
+BENCH_SUITE(PVecBench) {
+    vec_t* p_vec = vec_new(0);
+    pvec_t* p_pvec = pvec_new();
+    pvec_t* p_empty = pvec_new();
+    pvec_t* p_batch;
+    uint32_t seed = 7;
+    intptr_t sum = 0;
+    double start;
+    size_t i;
+
+    printf("  (%u elements)\n", NUM_SNAPSHOT_ELEMS);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SNAPSHOT_ELEMS; i++)
+        vec_push_back(p_vec, mem_box((intptr_t)i));
+    bench_report("vec_push_back", NUM_SNAPSHOT_ELEMS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SNAPSHOT_ELEMS; i++) {
+        pvec_t* p_next = pvec_push(p_pvec, mem_box((intptr_t)i));
+        mem_release(p_pvec);
+        p_pvec = p_next;
+    }
+    bench_report("pvec_push, keeping each version", NUM_SNAPSHOT_ELEMS, start);
+
+    start = bench_now();
+    p_batch = pvec_transient(p_empty);
+    for (i = 0; i < NUM_SNAPSHOT_ELEMS; i++)
+        pvec_transient_push(p_batch, mem_box((intptr_t)i));
+    pvec_persistent(p_batch);
+    bench_report("pvec_transient_push", NUM_SNAPSHOT_ELEMS, start);
+    mem_release(p_batch);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SNAPSHOTS; i++) {
+        vec_t* p_copy = vec_from_array(vec_size(p_vec), p_vec->p_buffer);
+        mem_retain_array(p_copy->p_buffer, vec_size(p_copy));
+        seed = (seed * 1664525u) + 1013904223u;
+        mem_release(vec_at(p_copy, seed % NUM_SNAPSHOT_ELEMS));
+        vec_set(p_copy, seed % NUM_SNAPSHOT_ELEMS, mem_box(-1));
+        mem_release(p_vec);
+        p_vec = p_copy;
+    }
+    bench_report("vec_t copy and set", NUM_SNAPSHOTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SNAPSHOTS; i++) {
+        pvec_t* p_next;
+        seed = (seed * 1664525u) + 1013904223u;
+        p_next = pvec_set(p_pvec, seed % NUM_SNAPSHOT_ELEMS, mem_box(-1));
+        mem_release(p_pvec);
+        p_pvec = p_next;
+    }
+    bench_report("pvec_set", NUM_SNAPSHOTS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SNAPSHOT_ELEMS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        sum += mem_unbox(vec_at(p_vec, seed % NUM_SNAPSHOT_ELEMS));
+    }
+    bench_report("random vec_at", NUM_SNAPSHOT_ELEMS, start);
+
+    start = bench_now();
+    for (i = 0; i < NUM_SNAPSHOT_ELEMS; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        sum += mem_unbox(pvec_at(p_pvec, seed % NUM_SNAPSHOT_ELEMS));
+    }
+    bench_report("random pvec_at", NUM_SNAPSHOT_ELEMS, start);
+
+    mem_release(p_vec);
+    mem_release(p_pvec);
+    mem_release(p_empty);
+    if (0 == sum)
+        puts("");
+}
+
+static void* add_value(void* env, void* p_acc, void* p_elem) {
+    (void)env;
+    return (void*)((intptr_t)p_acc + *(intptr_t*)p_elem);
+}
+
+static void* add_sums(void* env, void* p_acc, void* p_other) {
+    (void)env;
+    return (void*)((intptr_t)p_acc + (intptr_t)p_other);
+}
+
+static bool is_odd_value(void* env, void* p_elem) {
+    (void)env;
+    return (*(intptr_t*)p_elem & 1);
+}
+
+/* The elements are heap objects in shuffled order, so each visit is likely
+ * a cache miss that prefetching can hide */
+BENCH_SUITE(BulkOpsBench) {
+    vec_t* p_vec = vec_new(0);
+    vec_t* p_small;
+    intptr_t sum = 0;
+    uint32_t seed = 7;
+    size_t threads;
+    double start;
+    size_t i;
+
+    printf("  (%u shuffled objects, VEC_PREFETCH_DISTANCE = %d, %ld online CPUs)\n",
+           NUM_BULK, VEC_PREFETCH_DISTANCE, sysconf(_SC_NPROCESSORS_ONLN));
+    for (i = 0; i < NUM_BULK; i++) {
+        intptr_t* p_val = (intptr_t*)mem_allocate(sizeof(intptr_t), NULL);
+        *p_val = (intptr_t)i;
+        vec_push_back(p_vec, p_val);
+    }
+    for (i = NUM_BULK - 1; i > 0; i--) {
+        void* p_swap = p_vec->p_buffer[i];
+        size_t j;
+        seed = (seed * 1664525u) + 1013904223u;
+        j = (seed >> 4) % (i + 1);
+        p_vec->p_buffer[i] = p_vec->p_buffer[j];
+        p_vec->p_buffer[j] = p_swap;
+    }
+
+    start = bench_now();
+    for (i = 0; i < NUM_BULK; i++)
+        sum += *(intptr_t*)vec_at(p_vec, i);
+    bench_report("vec_at loop", NUM_BULK, start);
+
+    start = bench_now();
+    sum += (intptr_t)vec_reduce(p_vec, add_value, NULL, (void*)0);
+    bench_report("vec_reduce", NUM_BULK, start);
+
+    start = bench_now();
+    sum += (intptr_t)vec_find_if(p_vec, is_odd_value, NULL);
+    mem_release(vec_filter(p_vec, is_odd_value, NULL));
+    bench_report("vec_find_if and vec_filter", NUM_BULK, start);
+
+    for (threads = 1; threads <= VEC_PARALLEL_MAX_THREADS; threads *= 2) {
+        char name[64];
+        start = bench_now();
+        sum += (intptr_t)vec_parallel_reduce(p_vec, add_value, add_sums, NULL, (void*)0, threads);
+        snprintf(name, sizeof(name), "vec_parallel_reduce, %zu threads", threads);
+        bench_report(name, NUM_BULK, start);
+    }
+
+    /* A vector just big enough to split hands its ranges to the workers on
+     * every call, so this is mostly the cost of doing that */
+    p_small = vec_new(0);
+    for (i = 0; i < (2 * VEC_PARALLEL_MIN_CHUNK); i++)
+        vec_push_back(p_small, mem_retain(vec_at(p_vec, i)));
+    start = bench_now();
+    for (i = 0; i < NUM_SMALL_REDUCES; i++)
+        sum += (intptr_t)vec_parallel_reduce(p_small, add_value, add_sums, NULL, (void*)0, 2);
+    bench_report("vec_parallel_reduce of two chunks", NUM_SMALL_REDUCES * 2 * VEC_PARALLEL_MIN_CHUNK, start);
+
+    mem_release(p_small);
+    mem_release(p_vec);
+    if (0 == sum)
+        puts("");
+}
+
+/* Buffers past MEM_MMAP_THRESHOLD are mapped directly and invisible to the
+ * heap statistics, so they are added to the growth the heap reports */
+static void report_footprint(const char* name, size_t count, size_t before, size_t buffer_bytes) {
+    size_t after = bench_heap_bytes();
+    size_t bytes = ((after > before) ? (after - before) : 0) +
+                   ((buffer_bytes >= MEM_MMAP_THRESHOLD) ? buffer_bytes : 0);
+    printf("  %-40s %12zu elements %10.1f bytes each %8zu KB total\n",
+           name, count, (double)bytes / (double)count, bytes / 1024u);
+}
+
+BENCH_SUITE(ValueVecBench) {
+    vec_t* p_boxed = vec_new(0);
+    tvec_t* p_values = tvec_new(sizeof(intptr_t), NULL, 0, NULL);
+    intptr_t sum = 0;
+    size_t before;
+    double start;
+    size_t i, n;
+
+    before = bench_heap_bytes();
+    for (i = 0; i < NUM_VALUES; i++) {
+        intptr_t* p_val = (intptr_t*)mem_allocate(sizeof(intptr_t), NULL);
+        *p_val = (intptr_t)i;
+        vec_push_back(p_boxed, p_val);
+    }
+    vec_shrink_to_fit(p_boxed);
+    report_footprint("vec_t of 8-byte objects", NUM_VALUES, before, sizeof(void*) * NUM_VALUES);
+
+    before = bench_heap_bytes();
+    for (i = 0; i < NUM_VALUES; i++) {
+        intptr_t val = (intptr_t)i;
+        tvec_push_back(p_values, &val);
+    }
+    tvec_shrink_to_fit(p_values);
+    report_footprint("tvec_t of 8-byte values", NUM_VALUES, before, sizeof(intptr_t) * NUM_VALUES);
+
+    start = bench_now();
+    for (n = 0; n < NUM_SCANS; n++)
+        for (i = 0; i < NUM_VALUES; i++)
+            sum += *(intptr_t*)vec_at(p_boxed, i);
+    bench_report("vec_at scan of 8-byte objects", NUM_VALUES * NUM_SCANS, start);
+
+    start = bench_now();
+    for (n = 0; n < NUM_SCANS; n++)
+        for (i = 0; i < NUM_VALUES; i++)
+            sum += *(intptr_t*)tvec_at(p_values, i);
+    bench_report("tvec_at scan of 8-byte values", NUM_VALUES * NUM_SCANS, start);
+
+    start = bench_now();
+    for (n = 0; n < NUM_SCANS; n++) {
+        intptr_t* p_data = (intptr_t*)tvec_data(p_values);
+        for (i = 0; i < NUM_VALUES; i++)
+            sum += p_data[i];
+    }
+    bench_report("tvec_data scan of 8-byte values", NUM_VALUES * NUM_SCANS, start);
+
+    mem_release(p_boxed);
+    mem_release(p_values);
+    if (0 == sum)
+        puts("");
+}
+
+BENCH_SUITE(LargeVecBench) {
+    vec_t* p_vec = vec_new(0);
+    uintptr_t sum = 0;
+    uint32_t seed = 1;
+    double start;
+    size_t i;
+
+    printf("  (%zu MB vector, MEM_MMAP_THRESHOLD = %u, MEM_HUGE_PAGES = %d)\n",
+           (NUM_LARGE_ELEMS * sizeof(void*)) >> 20, (unsigned)MEM_MMAP_THRESHOLD, MEM_HUGE_PAGES);
+
+    start = bench_now();
+    for (i = 0; i < NUM_LARGE_ELEMS; i++)
+        vec_push_back(p_vec, (void*)((i << 1) | 1u));
+    bench_report("push_back growth", NUM_LARGE_ELEMS, start);
+
+    /* Only the growth itself, each step copying or remapping the buffer */
+    start = bench_now();
+    {
+        vec_t* p_grown = vec_new(0);
+        for (i = 8; i <= NUM_LARGE_ELEMS; i *= 2)
+            vec_resize(p_grown, i, NULL);
+        mem_release(p_grown);
+    }
+    bench_report("vec_resize doubling", NUM_LARGE_ELEMS, start);
+
+    /* Random probes touch a new page almost every time, so they are bound by
+     * TLB misses rather than by the cache */
+    start = bench_now();
+    for (i = 0; i < NUM_PROBES; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        sum += (uintptr_t)vec_at(p_vec, seed % NUM_LARGE_ELEMS);
+    }
+    bench_report("random vec_at", NUM_PROBES, start);
+    printf("  %-40s %12.2f ns/probe\n", "", (bench_now() - start) * 1e9 / NUM_PROBES);
+
+    start = bench_now();
+    vec_clear(p_vec);
+    mem_release(p_vec);
+    bench_report("clear and release", NUM_LARGE_ELEMS, start);
+    if (0 == sum)
+        puts("");
+}
@@ -0,0 +1,34 @@
+#include "bench.h"
+#include "mem.h"
+#include <unistd.h>
+
+int main(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+    RUN_BENCH_SUITE(FootprintBench);
+    RUN_BENCH_SUITE(MemBench);
+    RUN_BENCH_SUITE(RefcountBench);
+    RUN_BENCH_SUITE(ArenaBench);
+    RUN_BENCH_SUITE(ReleaseBench);
+    RUN_BENCH_SUITE(BatchBench);
+    RUN_BENCH_SUITE(ScalingBench);
+    RUN_BENCH_SUITE(ImmortalBench);
+    RUN_BENCH_SUITE(EpochBench);
+    RUN_BENCH_SUITE(LookupBench);
+    RUN_BENCH_SUITE(ListIndexBench);
+    RUN_BENCH_SUITE(GrowthBench);
+    RUN_BENCH_SUITE(ValueVecBench);
+    RUN_BENCH_SUITE(BulkVecBench);
+    RUN_BENCH_SUITE(SortBench);
+    RUN_BENCH_SUITE(SmallVecBench);
+    RUN_BENCH_SUITE(SegVecBench);
+    RUN_BENCH_SUITE(GapVecBench);
+    RUN_BENCH_SUITE(PVecBench);
+    RUN_BENCH_SUITE(BulkOpsBench);
+    RUN_BENCH_SUITE(LargeVecBench);
+#if (LEAK_DETECT_LEVEL > 0)
+    mem_stats_dump(STDOUT_FILENO);
+#endif
+    return 0;
+}
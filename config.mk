@@ -15,3 +15,34 @@
 # Enable output of coverage information
 #CFLAGS  += --coverage
 #LDFLAGS += --coverage
+
+# Serve small objects from per size class slabs instead of malloc
+#CFLAGS += -DMEM_SLAB_ALLOCATOR=1
+
+# Use atomic reference counting for every object, not just mem_share'd ones
+#CFLAGS += -DMEM_ATOMIC_REFCOUNT=1
+
+# Count references from the allocating thread without atomics and from every
+# other thread with them, so no object needs to be passed to mem_share
+#CFLAGS += -DMEM_BIASED_REFCOUNT=1
+
+# Gather allocation statistics (1) and break them down by type (2)
+#CFLAGS += -DLEAK_DETECT_LEVEL=2
+
+# Ask for transparent huge pages on large memory mapped objects, or set the
+# mapping threshold to 0 to leave every object to malloc
+#CFLAGS += -DMEM_HUGE_PAGES=1
+#CFLAGS += -DMEM_MMAP_THRESHOLD=0
+
+# Heap-allocate every box instead of tagging small integers into the pointer
+#CFLAGS += -DMEM_TAGGED_INTEGERS=0
+
+# Shrink every object header to 8 bytes by indexing a table of destructors
+#CFLAGS += -DMEM_COMPACT_HEADER=1
+
+# Cache line align the internal arrays of vectors and circular buffers
+#CFLAGS += -DVEC_BUFFER_ALIGNMENT=64 -DBUF_BUFFER_ALIGNMENT=64
+
+# Give every vector a separate buffer instead of keeping up to 8 elements
+# inside the vector object
+#CFLAGS += -DVEC_INLINE_CAPACITY=0
@@ -12,7 +12,11 @@ buf_t* buf_new(size_t size)
     if (size > 0)
     {
         buf         = (buf_t*) mem_allocate(sizeof(buf_t), &buf_free);
+#if (BUF_BUFFER_ALIGNMENT > 0)
+        buf->buffer = (void**) mem_allocate_aligned( sizeof(void*) * size, BUF_BUFFER_ALIGNMENT, NULL );
+#else
         buf->buffer = (void**) malloc( sizeof(void*) * size );
+#endif
         buf->size   = size;
         buf->reads  = 0;
         buf->writes = 0;
@@ -39,13 +43,12 @@ bool buf_full(buf_t* buf)
 
 void buf_clear(buf_t* buf)
 {
-    void* entry;
-    while ( !buf_empty(buf) )
-    {
-        entry = buf_read(buf);
-        if (NULL != entry)
-            mem_release( entry );
-    }
+    size_t count = buf->writes - buf->reads;
+    size_t start = buf->reads % buf->size;
+    /* The unread entries wrap around the end of the buffer at most once */
+    size_t first = ((buf->size - start) < count) ? (buf->size - start) : count;
+    mem_release_array( &buf->buffer[start], first );
+    mem_release_array( buf->buffer, count - first );
     buf->reads  = 0;
     buf->writes = 0;
 }
@@ -76,6 +79,10 @@ bool buf_write(buf_t* buf, void* data)
 static void buf_free(void* p_buf)
 {
     buf_clear((buf_t*)p_buf);
+#if (BUF_BUFFER_ALIGNMENT > 0)
+    mem_release( ((buf_t*)p_buf)->buffer );
+#else
     free( ((buf_t*)p_buf)->buffer );
+#endif
 }
 
@@ -19,6 +19,13 @@ typedef struct {
     size_t writes; /**< Total number of writes that have occrurred */
 } buf_t;
 
+/** Unless otherwise specified, the buffer's array is allocated with malloc.
+ *  A non-zero value allocates it with mem_allocate_aligned at that alignment
+ *  instead, eg. MEM_CACHE_LINE_SIZE. */
+#ifndef BUF_BUFFER_ALIGNMENT
+#define BUF_BUFFER_ALIGNMENT 0
+#endif
+
 /**
  * @brief Creates a new buffer.
  *
@@ -4,14 +4,62 @@
   */
 #include "list.h"
 
+/* The number of nodes list_clear hands to mem_release_array at a time */
+#define LIST_RELEASE_BATCH 64
+
+/* The most levels a list index has above the list itself */
+#define LIST_INDEX_LEVELS 16
+
+/* Each level of the index holds about one in this many of the entries of the
+ * level below. Must be a power of two. */
+#define LIST_INDEX_FANOUT 4u
+
+/* Building an index and later dropping it costs about this many times as much
+ * per node as walking the list, so positional access walks this many times the
+ * size of the list before it builds one */
+#define LIST_INDEX_BUILD_COST 8u
+
+/* An entry on one level of the index. Positions count from 1, with the head
+ * entries at position 0, and the width of the last entry on a level reaches
+ * one past the end of the list. */
+typedef struct list_skip_t
+{
+    list_node_t* node;          /* the node the entry stands for */
+    struct list_skip_t* next;   /* the next entry on the same level */
+    struct list_skip_t* prev;   /* the previous entry on the same level */
+    struct list_skip_t* down;   /* the same node's entry on the level below */
+    struct list_skip_t* up;     /* the same node's entry on the level above */
+    size_t width;               /* the positions from this entry to the next */
+} list_skip_t;
+
+typedef struct list_index_t
+{
+    size_t levels;                          /* the number of levels in use */
+    uint32_t seed;                          /* picks the levels of inserted nodes */
+    list_node_t* finger;                    /* the node last found or changed, if any */
+    size_t finger_pos;                      /* the position of that node */
+    list_skip_t heads[LIST_INDEX_LEVELS];   /* the entries before the first node */
+} list_index_t;
+
 static void list_free(void* p_list);
 static void list_node_free(void* p_node);
+static void list_link(list_t* list, list_node_t* node, list_node_t* new_node);
+static void list_unlink(list_t* list, list_node_t* node);
+static list_index_t* list_index(list_t* list);
+static void list_index_find(list_index_t* index, size_t pos, list_skip_t** path, size_t* path_pos);
+static size_t list_index_locate(list_t* list, list_node_t* node);
+static void list_index_insert(list_t* list, list_node_t* node, size_t pos);
+static void list_index_remove(list_t* list, list_node_t* node, size_t pos);
+static void list_index_drop(list_t* list);
 
 list_t* list_new(void)
 {
     list_t* list = (list_t*)mem_allocate(sizeof(list_t), &list_free);
     list->head = NULL;
     list->tail = NULL;
+    list->size = 0;
+    list->index = NULL;
+    list->walked = 0;
     return list;
 }
 
@@ -21,6 +69,7 @@ list_node_t* list_new_node(void* contents)
     node->contents = contents;
     node->prev = NULL;
     node->next = NULL;
+    node->skip = NULL;
     return node;
 }
 
@@ -39,7 +88,7 @@ list_node_t* list_back( list_t* list )
 size_t list_size(list_t* list)
 {
     assert(NULL != list);
-    return list_index_of(list, NULL);
+    return list->size;
 }
 
 bool list_empty(list_t* list)
@@ -58,10 +107,40 @@ list_node_t* list_at(list_t* list, size_t index)
     assert(NULL != list);
     list_node_t* node = list->head;
     size_t cur_index = 0;
-    while( NULL != node && cur_index != index)
+    list_index_t* p_index = (index < list->size) ? list_index(list) : NULL;
+    if (index >= list->size)
+    {
+        node = NULL;
+    }
+    else if (NULL != p_index)
+    {
+        /* Start from the last entry on the lowest level before the node */
+        list_skip_t* path[LIST_INDEX_LEVELS];
+        size_t path_pos[LIST_INDEX_LEVELS];
+        list_index_find(p_index, index + 1, path, path_pos);
+        if (path_pos[0] > 0)
+        {
+            node = path[0]->node;
+            cur_index = path_pos[0] - 1;
+        }
+        for (; cur_index != index; cur_index++)
+            node = node->next;
+        p_index->finger = node;
+        p_index->finger_pos = index + 1;
+    }
+    else if (index >= (list->size / 2))
     {
-        node = node->next;
-        cur_index++;
+        /* Walk from whichever end is nearer, counting the nodes walked */
+        node = list->tail;
+        for (cur_index = list->size - 1; cur_index != index; cur_index--)
+            node = node->prev;
+        list->walked += list->size - index;
+    }
+    else
+    {
+        for (; cur_index != index; cur_index++)
+            node = node->next;
+        list->walked += index;
     }
     return node;
 }
@@ -69,6 +148,8 @@ list_node_t* list_at(list_t* list, size_t index)
 int list_index_of(list_t* list, list_node_t* node)
 {
     assert(NULL != list);
+    if (NULL == node)
+        return (int)list->size;
     int i = 0;
     list_node_t* edon = list->head;
     while( NULL != edon && edon != node)
@@ -117,11 +198,19 @@ list_node_t* list_insert( list_t* list, size_t index, void* contents)
 {
     assert(NULL != list);
     list_node_t* new_node = NULL;
-    list_node_t* prev = (index > 0 ? list_at(list, index-1) : NULL);
-    if(prev || index == 0)
-        new_node = list_insert_after(list, prev, contents);
+    if(index <= list->size)
+    {
+        list_node_t* prev = (index > 0 ? list_at(list, index-1) : NULL);
+        new_node = list_new_node(contents);
+        assert(NULL != new_node);
+        if (NULL != list->index)
+            list_index_insert(list, new_node, index + 1);
+        list_link(list, prev, new_node);
+    }
     else
+    {
         mem_release(contents);
+    }
     return new_node;
 }
 
@@ -130,51 +219,63 @@ list_node_t* list_insert_after( list_t* list, list_node_t* node, void* contents)
     assert(NULL != list);
     list_node_t* new_node = list_new_node(contents);
     assert(NULL != new_node);
-    list_node_t* next = (node ? node->next : list->head);
-    new_node->prev = node;
-    new_node->next = next;
-    *(node ? &(node->next) : &(list->head)) = new_node;
-    *(next ? &(next->prev) : &(list->tail)) = new_node;
+    if (NULL != list->index)
+        list_index_insert(list, new_node, (NULL != node ? list_index_locate(list, node) : 0) + 1);
+    list_link(list, node, new_node);
     return new_node;
 }
 
 void list_delete( list_t* list, size_t index)
 {
     assert(NULL != list);
-    list_delete_node(list, list_at(list, index));
+    list_node_t* node = list_at(list, index);
+    assert(NULL != node);
+    if (NULL != list->index)
+        list_index_remove(list, node, index + 1);
+    list_unlink(list, node);
 }
 
 void list_delete_node(list_t* list, list_node_t* node)
 {
     assert(NULL != list);
     assert(NULL != node);
-    *(node->prev ? &(node->prev->next) : &(list->head)) = node->next;
-    *(node->next ? &(node->next->prev) : &(list->tail)) = node->prev;
-    node->next = NULL;
-    node->prev = NULL;
-    mem_release(node);
+    if (NULL != list->index)
+        list_index_remove(list, node, list_index_locate(list, node));
+    list_unlink(list, node);
 }
 
 void list_clear(list_t* list)
 {
     assert(NULL != list);
+    void* nodes[LIST_RELEASE_BATCH];
+    size_t count = 0;
     list_node_t* node = list->tail;
+    /* Dropped first, as it points back into the nodes */
+    list_index_drop(list);
     while(NULL != node)
     {
         list_node_t* p = node->prev;
         node->prev = NULL;
         node->next = NULL;
-        mem_release((void*) node);
+        nodes[count++] = node;
+        if (LIST_RELEASE_BATCH == count)
+        {
+            mem_release_array(nodes, count);
+            count = 0;
+        }
         node = p;
     }
+    mem_release_array(nodes, count);
     list->head = NULL;
     list->tail = NULL;
+    list->size = 0;
 }
 
 static void list_free(void* p_list)
 {
     list_t* list = (list_t*)p_list;
     assert(NULL != list);
+    list_index_drop(list);
     if (NULL != list->head)
         mem_release(list->head);
 }
@@ -189,3 +290,272 @@ static void list_node_free(void* p_node)
         mem_release(node->next);
 }
 
+
+/* Links a new node in after the given one, or at the front if it is NULL */
+static void list_link(list_t* list, list_node_t* node, list_node_t* new_node)
+{
+    list_node_t* next = (node ? node->next : list->head);
+    new_node->prev = node;
+    new_node->next = next;
+    *(node ? &(node->next) : &(list->head)) = new_node;
+    *(next ? &(next->prev) : &(list->tail)) = new_node;
+    list->size++;
+}
+
+static void list_unlink(list_t* list, list_node_t* node)
+{
+    *(node->prev ? &(node->prev->next) : &(list->head)) = node->next;
+    *(node->next ? &(node->next->prev) : &(list->tail)) = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+    list->size--;
+    mem_release(node);
+}
+
+static void list_index_free(void* p_index)
+{
+    list_index_t* index = (list_index_t*)p_index;
+    size_t level;
+    for (level = 0; level < index->levels; level++)
+    {
+        list_skip_t* entry = index->heads[level].next;
+        while (NULL != entry)
+        {
+            list_skip_t* next = entry->next;
+            mem_release(entry);
+            entry = next;
+        }
+    }
+}
+
+/* Makes an entry for a node and links it in after the given entry on the same
+ * level, above the node's entry on the level below if it has one */
+static list_skip_t* list_index_entry(list_node_t* node, list_skip_t* prev, list_skip_t* down)
+{
+    list_skip_t* entry = (list_skip_t*)mem_allocate(sizeof(list_skip_t), NULL);
+    assert(NULL != entry);
+    entry->node = node;
+    entry->next = prev->next;
+    entry->prev = prev;
+    entry->down = down;
+    entry->up = NULL;
+    entry->width = 0;
+    if (NULL != entry->next)
+        entry->next->prev = entry;
+    prev->next = entry;
+    *(down ? &(down->up) : &(node->skip)) = entry;
+    return entry;
+}
+
+/* Adds empty levels to the top of the index */
+static void list_index_raise(list_t* list, size_t levels)
+{
+    list_index_t* index = list->index;
+    for (; index->levels < levels; index->levels++)
+    {
+        list_skip_t* head = &index->heads[index->levels];
+        head->node = NULL;
+        head->next = NULL;
+        head->prev = NULL;
+        head->up = NULL;
+        head->down = (index->levels > 0) ? &index->heads[index->levels - 1] : NULL;
+        head->width = list->size + 1;
+    }
+}
+
+/* Returns the list's index, building it if the list is big enough to need
+ * one and walking it has cost as much as building the index would. Every
+ * LIST_INDEX_FANOUT-th entry of a level is raised to the next, so a freshly
+ * built index is perfectly balanced. */
+static list_index_t* list_index(list_t* list)
+{
+    if ((NULL == list->index) && (LIST_INDEX_MIN_SIZE > 0) && (list->size >= LIST_INDEX_MIN_SIZE) &&
+        ((list->walked / LIST_INDEX_BUILD_COST) >= list->size))
+    {
+        list_skip_t* last[LIST_INDEX_LEVELS];
+        size_t last_pos[LIST_INDEX_LEVELS];
+        size_t levels = 1, span, level, pos;
+        list_node_t* node;
+        for (span = LIST_INDEX_FANOUT * LIST_INDEX_FANOUT; (span <= list->size) && (levels < LIST_INDEX_LEVELS); span *= LIST_INDEX_FANOUT)
+            levels++;
+        list->index = (list_index_t*)mem_allocate(sizeof(list_index_t), &list_index_free);
+        assert(NULL != list->index);
+        list->index->levels = 0;
+        list->index->seed = 0x9E3779B9u;
+        list->index->finger = NULL;
+        list->index->finger_pos = 0;
+        list_index_raise(list, levels);
+        for (level = 0; level < levels; level++)
+        {
+            last[level] = &list->index->heads[level];
+            last_pos[level] = 0;
+        }
+        for (node = list->head, pos = 1; NULL != node; node = node->next, pos++)
+        {
+            list_skip_t* down = NULL;
+            for (level = 0, span = LIST_INDEX_FANOUT; (level < levels) && (0 == (pos % span)); level++, span *= LIST_INDEX_FANOUT)
+            {
+                list_skip_t* entry = list_index_entry(node, last[level], down);
+                last[level]->width = pos - last_pos[level];
+                last[level] = entry;
+                last_pos[level] = pos;
+                down = entry;
+            }
+        }
+        for (level = 0; level < levels; level++)
+            last[level]->width = (list->size + 1) - last_pos[level];
+    }
+    return list->index;
+}
+
+/* Finds the last entry on each level before the given position */
+static void list_index_find(list_index_t* index, size_t pos, list_skip_t** path, size_t* path_pos)
+{
+    list_skip_t* entry = &index->heads[index->levels - 1];
+    size_t cur_pos = 0;
+    size_t level = index->levels;
+    while (level-- > 0)
+    {
+        while ((NULL != entry->next) && ((cur_pos + entry->width) < pos))
+        {
+            cur_pos += entry->width;
+            entry = entry->next;
+        }
+        path[level] = entry;
+        path_pos[level] = cur_pos;
+        entry = entry->down;
+    }
+}
+
+/* Finds the position of a node in the list. Nodes at either end of the list
+ * or next to the finger are found straight away. Any other node is found by
+ * walking on to the first node with an entry in the index, and then back
+ * along the index from that entry, climbing a level wherever the node has an
+ * entry on the level above, until it reaches the head entries. */
+static size_t list_index_locate(list_t* list, list_node_t* node)
+{
+    list_index_t* index = list->index;
+    list_node_t* finger = index->finger;
+    size_t pos = 0;
+    if (list->head == node)
+        pos = 1;
+    else if (list->tail == node)
+        pos = list->size;
+    else if ((NULL != finger) && (finger == node))
+        pos = index->finger_pos;
+    else if ((NULL != finger) && (finger->next == node))
+        pos = index->finger_pos + 1;
+    else if ((NULL != finger) && (finger->prev == node))
+        pos = index->finger_pos - 1;
+    else
+    {
+        list_skip_t* entry;
+        size_t walked = 0;
+        for (; (NULL != node) && (NULL == node->skip); node = node->next)
+            walked++;
+        if (NULL == node)
+        {
+            pos = list->size + 1;
+        }
+        else
+        {
+            for (entry = node->skip; NULL != entry->node;)
+            {
+                if (NULL != entry->up)
+                {
+                    entry = entry->up;
+                }
+                else
+                {
+                    entry = entry->prev;
+                    pos += entry->width;
+                }
+            }
+        }
+        pos -= walked;
+    }
+    return pos;
+}
+
+/* Adds a node about to be linked in at the given position to the index */
+static void list_index_insert(list_t* list, list_node_t* node, size_t pos)
+{
+    list_index_t* index = list->index;
+    list_skip_t* path[LIST_INDEX_LEVELS];
+    size_t path_pos[LIST_INDEX_LEVELS];
+    list_skip_t* down = NULL;
+    size_t height = 0, level;
+    /* The node goes on each level with probability 1 / LIST_INDEX_FANOUT of
+     * being on the one below */
+    for (;;)
+    {
+        index->seed ^= index->seed << 13;
+        index->seed ^= index->seed >> 17;
+        index->seed ^= index->seed << 5;
+        if ((height == LIST_INDEX_LEVELS) || (0 != (index->seed & (LIST_INDEX_FANOUT - 1))))
+            break;
+        height++;
+    }
+    list_index_raise(list, height);
+    list_index_find(index, pos, path, path_pos);
+    for (level = 0; level < index->levels; level++)
+    {
+        if (level < height)
+        {
+            list_skip_t* entry = list_index_entry(node, path[level], down);
+            entry->width = (path_pos[level] + path[level]->width + 1) - pos;
+            path[level]->width = pos - path_pos[level];
+            down = entry;
+        }
+        else
+        {
+            path[level]->width++;
+        }
+    }
+    index->finger = node;
+    index->finger_pos = pos;
+}
+
+/* Removes a node about to be unlinked from the given position from the index */
+static void list_index_remove(list_t* list, list_node_t* node, size_t pos)
+{
+    list_index_t* index = list->index;
+    list_skip_t* path[LIST_INDEX_LEVELS];
+    size_t path_pos[LIST_INDEX_LEVELS];
+    size_t level;
+    list_index_find(index, pos, path, path_pos);
+    for (level = 0; level < index->levels; level++)
+    {
+        list_skip_t* entry = path[level]->next;
+        if ((NULL != entry) && (node == entry->node))
+        {
+            path[level]->width += entry->width - 1;
+            path[level]->next = entry->next;
+            if (NULL != entry->next)
+                entry->next->prev = path[level];
+            mem_release(entry);
+        }
+        else
+        {
+            path[level]->width--;
+        }
+    }
+    node->skip = NULL;
+    /* The finger moves to the node before, which is still linked in */
+    index->finger = node->prev;
+    index->finger_pos = pos - 1;
+}
+
+static void list_index_drop(list_t* list)
+{
+    /* Cleared now, as the index may be freed after the nodes */
+    if ((NULL != list->index) && (list->index->levels > 0))
+    {
+        list_skip_t* entry;
+        for (entry = list->index->heads[0].next; NULL != entry; entry = entry->next)
+            entry->node->skip = NULL;
+    }
+    mem_release(list->index);
+    list->index = NULL;
+    list->walked = 0;
+}
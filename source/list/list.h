@@ -11,6 +11,9 @@ extern "C" {
 
 #include "rt.h"
 
+/* list index entry data structure */
+struct list_skip_t;
+
 /** A linked list node. */
 typedef struct list_node_t
 {
@@ -20,8 +23,22 @@ typedef struct list_node_t
     struct list_node_t* next;
     /** pointer to prev node in the list */
     struct list_node_t* prev;
+    /** The node's entry on the lowest level of the list's index, if any */
+    struct list_skip_t* skip;
 } list_node_t;
 
+/** Positional access to a list of at least this many nodes builds a skip
+ *  list index over the nodes, so list_at, list_insert and list_delete take
+ *  O(log n) time instead of walking the list. The index is built once
+ *  walking the list for positional access has cost about as much as building
+ *  the index would. A value of 0 disables the index. */
+#ifndef LIST_INDEX_MIN_SIZE
+#define LIST_INDEX_MIN_SIZE 64
+#endif
+
+/* list index data structure */
+struct list_index_t;
+
 /** A doubly linked list */
 typedef struct list_t
 {
@@ -29,6 +46,12 @@ typedef struct list_t
     list_node_t* head;
     /** Pointer to the last element in the list */
     list_node_t* tail;
+    /** The number of elements in the list */
+    size_t size;
+    /** Skip list over the nodes for positional access, built on demand */
+    struct list_index_t* index;
+    /** The nodes positional access has walked while the list had no index */
+    size_t walked;
 } list_t;
 
 /**
@@ -68,8 +91,7 @@ list_node_t* list_back( list_t* list );
 /**
  * @brief Returns the number of elements in the list.
  *
- * This function loops through the supplied list and returns a count of the
- * number of elements contained in the list.
+ * The count is kept up to date by every update, so this takes constant time.
  *
  * @param list The list to be counted.
  *
@@ -100,8 +122,9 @@ list_node_t* list_prev(list_t* list, list_node_t* node);
 /**
  * @brief   Return the node at the specified index in a linked list.
  *
- * This function loops through the linked list and returns the node in the list
- * at the specified index. Returns NULL if the index is out of range.
+ * This function returns the node in the list at the specified index, walking
+ * down the list's index if it has one and along the list from the nearer end
+ * otherwise. Returns NULL if the index is out of range.
  *
  * @param list  The list to search for the supplied index.
  * @param index The index of the node to return.
@@ -178,9 +201,9 @@ list_node_t* list_pop_back( list_t* list );
 /**
  * @brief Inserts a new node in a linked list at the specified index.
  *
- * This function traverses the list to the desired index and inserts a new node
- * with the given contents at that position. The node previously at the desired
- * index becomes the child of the new node.
+ * This function finds the node before the desired index as list_at does and
+ * inserts a new node with the given contents at that position. The node
+ * previously at the desired index becomes the child of the new node.
  *
  * @param list     The list to operate on.
  * @param index    The index where the new node will be inserted.
@@ -193,6 +216,10 @@ list_node_t* list_insert( list_t* list, size_t index, void* contents);
 /**
  * @brief Inserts a new node in a linked list after the specified node
  *
+ * The list's index is kept up to date. Finding the node's position takes
+ * constant time when it is at either end of the list, or is or neighbours the
+ * node last found or changed by position, and O(log n) time otherwise.
+ *
  * @param list     The list to operate on.
  * @param node     The node after which the item should be inserted.
  *                 if node is NULL, will insert at the beginning of the list
@@ -205,8 +232,8 @@ list_node_t* list_insert_after( list_t* list, list_node_t* node, void* contents)
 /**
  * @brief Deletes a node from the supplied list.
  *
- * This function traverses the list to the desired index and frees the memory
- * allocated for that node. If the deleted node has a child then the child is
+ * This function finds the node at the desired index as list_at does and frees
+ * the memory allocated for that node. If the deleted node has a child then the child is
  * reattached to the deleted node's parent.
  *
  * @param list          The list to operate on.
@@ -218,7 +245,8 @@ void list_delete(list_t* list, size_t index);
  * @brief Delete a node from the supplied list.
  *
  * This function differs from the above list_delete in that it is given a
- * pointer to a node to be deleted instead of an index.
+ * pointer to a node to be deleted instead of an index. The list's index is
+ * kept up to date as for list_insert_after.
  *
  * @param list          The list to operate on.
  * @param node          A pointer to the node to delete.
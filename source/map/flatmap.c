@@ -0,0 +1,125 @@
+/**
+  @file flatmap.c
+  @brief See header for details
+*/
+#include "flatmap.h"
+
+struct flatmap_t {
+    cmp_t* cmp;
+    vec_t* keys;   /* sorted by cmp */
+    vec_t* values; /* values[i] is associated with keys[i] */
+};
+
+static void flatmap_free(void* obj)
+{
+    flatmap_t* map = (flatmap_t*)obj;
+    mem_release(map->keys);
+    mem_release(map->values);
+    mem_release(map->cmp);
+}
+
+/* Compares the keys held in two slots of the array given to
+ * flatmap_from_arrays */
+static int flatmap_compare_slots(void* env, void* p_a, void* p_b)
+{
+    return cmp_compare((cmp_t*)env, *(void**)p_a, *(void**)p_b);
+}
+
+static bool flatmap_find(flatmap_t* map, void* key, size_t* p_index)
+{
+    size_t index = vec_lower_bound(map->keys, map->cmp, key);
+    *p_index = index;
+    return (index < vec_size(map->keys)) && (0 == cmp_compare(map->cmp, key, vec_at(map->keys, index)));
+}
+
+flatmap_t* flatmap_new(cmp_t* cmp)
+{
+    flatmap_t* map = (flatmap_t*)mem_allocate(sizeof(flatmap_t), &flatmap_free);
+    map->cmp    = cmp;
+    map->keys   = vec_new(0);
+    map->values = vec_new(0);
+    return map;
+}
+
+flatmap_t* flatmap_from_arrays(cmp_t* cmp, size_t count, void** keys, void** values)
+{
+    flatmap_t* map = flatmap_new(cmp);
+    cmp_t by_key = { cmp, &flatmap_compare_slots };
+    vec_t* order = vec_new(0);
+    size_t i;
+    /* Sort pointers to the key slots, stably so the first of any duplicate
+     * keys comes first, then copy the pairs out in that order. The slot's
+     * offset in the array gives the position of its value. */
+    vec_reserve(order, count);
+    for (i = 0; i < count; i++)
+        order->p_buffer[i] = &keys[i];
+    order->size = count;
+    vec_stable_sort(order, &by_key);
+    vec_reserve(map->keys, count);
+    vec_reserve(map->values, count);
+    for (i = 0; i < count; i++) {
+        size_t index = (size_t)((void**)vec_at(order, i) - keys);
+        size_t size = vec_size(map->keys);
+        if ((size > 0) && (0 == cmp_compare(cmp, vec_at(map->keys, size - 1), keys[index]))) {
+            mem_release(keys[index]);
+            mem_release(values[index]);
+        } else {
+            vec_push_back(map->keys, keys[index]);
+            vec_push_back(map->values, values[index]);
+        }
+    }
+    vec_shrink_to_fit(map->keys);
+    vec_shrink_to_fit(map->values);
+    /* The slot pointers are not objects, so the vector must not release them */
+    order->size = 0;
+    mem_release(order);
+    return map;
+}
+
+bool flatmap_has_key(flatmap_t* map, void* key)
+{
+    size_t index;
+    return flatmap_find(map, key, &index);
+}
+
+size_t flatmap_size(flatmap_t* map)
+{
+    return vec_size(map->keys);
+}
+
+void* flatmap_lookup(flatmap_t* map, void* key)
+{
+    size_t index;
+    return flatmap_find(map, key, &index) ? vec_at(map->values, index) : NULL;
+}
+
+void flatmap_insert(flatmap_t* map, void* key, void* value)
+{
+    size_t index;
+    if (!flatmap_find(map, key, &index)) {
+        vec_insert_array(map->keys, index, 1, &key);
+        vec_insert_array(map->values, index, 1, &value);
+    } else {
+        mem_release(key);
+        mem_release(value);
+    }
+}
+
+void flatmap_delete(flatmap_t* map, void* key)
+{
+    size_t index;
+    if (flatmap_find(map, key, &index)) {
+        vec_erase(map->keys, index, index);
+        vec_erase(map->values, index, index);
+    }
+}
+
+void* flatmap_key_at(flatmap_t* map, size_t index)
+{
+    return vec_at(map->keys, index);
+}
+
+void* flatmap_value_at(flatmap_t* map, size_t index)
+{
+    return vec_at(map->values, index);
+}
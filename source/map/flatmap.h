@@ -0,0 +1,106 @@
+/**
+  @file flatmap.h
+  @brief A map kept as sorted arrays of keys and values, for tables that are
+         built once and then mostly read.
+*/
+#ifndef FLATMAP_H
+#define FLATMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vec.h"
+
+/* flatmap data structure */
+struct flatmap_t;
+
+/* flatmap structure type alias */
+typedef struct flatmap_t flatmap_t;
+
+/**
+ * @brief Create a new empty map ordered by the provided comparator.
+ * @param cmp User-provided comparator, released with the map.
+ * @return The new map.
+ */
+flatmap_t* flatmap_new(cmp_t* cmp);
+
+/**
+ * @brief Create a new map from arrays of keys and values in any order.
+ *
+ * The pairs are sorted once rather than inserted one at a time. Where a key
+ * appears more than once the first pair is kept and the others released, as
+ * if they had been passed to flatmap_insert in order.
+ *
+ * @param cmp User-provided comparator, released with the map.
+ * @param count The number of pairs.
+ * @param keys The keys, whose references are taken over by the map.
+ * @param values The values, whose references are taken over by the map.
+ * @return The new map.
+ */
+flatmap_t* flatmap_from_arrays(cmp_t* cmp, size_t count, void** keys, void** values);
+
+/**
+ * @brief Determines whether the map contains the given key or not.
+ * @param map The map to search.
+ * @param key The key to search for.
+ * @return True if the map has the key, false otherwise.
+ */
+bool flatmap_has_key(flatmap_t* map, void* key);
+
+/**
+ * @brief Returns the number of key/value pairs in the map.
+ * @param map The map.
+ * @return The number of keys.
+ */
+size_t flatmap_size(flatmap_t* map);
+
+/**
+ * @brief Lookup a value by key with a binary search.
+ * @param map The map.
+ * @param key The key to lookup.
+ * @return The value associated with the key or null if no association exists.
+ */
+void* flatmap_lookup(flatmap_t* map, void* key);
+
+/**
+ * @brief Associate the key with the given value in map.
+ *
+ * Moves every greater pair along, so building a large map this way takes
+ * quadratic time. Use flatmap_from_arrays instead. If the key is already
+ * present the map is unchanged and the given key and value are released.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @param value The value.
+ */
+void flatmap_insert(flatmap_t* map, void* key, void* value);
+
+/**
+ * @brief Delete the given key/value association from the map.
+ * @param map The map.
+ * @param key The key of the association to delete.
+ */
+void flatmap_delete(flatmap_t* map, void* key);
+
+/**
+ * @brief Returns the key at the given position in ascending key order.
+ * @param map The map.
+ * @param index The position of the pair.
+ * @return The key or null if the index is out of range.
+ */
+void* flatmap_key_at(flatmap_t* map, size_t index);
+
+/**
+ * @brief Returns the value at the given position in ascending key order.
+ * @param map The map.
+ * @param index The position of the pair.
+ * @return The value or null if the index is out of range.
+ */
+void* flatmap_value_at(flatmap_t* map, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLATMAP_H */
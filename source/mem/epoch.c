@@ -0,0 +1,185 @@
+/**
+  @file epoch.c
+  @brief See header for details
+  */
+#include "epoch.h"
+#include <sched.h>
+
+/* Objects retired by one thread while the global epoch had a given value */
+typedef struct {
+    uintptr_t epoch;
+    void** p_objs;
+    size_t count;
+    size_t capacity;
+} limbo_t;
+
+/* A registered thread. Records are never freed, only reused by threads that
+ * register later, so scanning the list never touches freed memory. Each one
+ * is cache line aligned so announcing an epoch does not disturb the others. */
+typedef struct epoch_rec_t {
+    uintptr_t announced;        /* (epoch << 1) | 1 inside a critical section, else 0 */
+    bool in_use;                /* owned by a registered thread */
+    struct epoch_rec_t* p_next; /* next record in Epoch_Records */
+    size_t nesting;             /* depth of nested critical sections */
+    size_t retired;             /* objects retired since the last collection */
+    limbo_t limbo[3];           /* indexed by epoch, only the last three matter */
+} epoch_rec_t;
+
+static uintptr_t Epoch_Global = 0;
+
+static epoch_rec_t* Epoch_Records = NULL;
+
+static THREAD_LOCAL epoch_rec_t* Epoch_Thread = NULL;
+
+/* Releases everything in the limbo list and moves it to the given epoch. The
+ * list is emptied first because destructors may retire more objects. */
+static void limbo_flush(limbo_t* p_limbo, uintptr_t epoch)
+{
+    void** p_objs = p_limbo->p_objs;
+    size_t count = p_limbo->count;
+    size_t i;
+    p_limbo->epoch    = epoch;
+    p_limbo->p_objs   = NULL;
+    p_limbo->count    = 0;
+    p_limbo->capacity = 0;
+    for (i = 0; i < count; i++)
+        mem_release(p_objs[i]);
+    free(p_objs);
+}
+
+static void limbo_push(limbo_t* p_limbo, void* p_obj)
+{
+    if (p_limbo->count == p_limbo->capacity) {
+        p_limbo->capacity = (0 == p_limbo->capacity) ? MEM_EPOCH_RETIRE_THRESHOLD : (p_limbo->capacity * 2);
+        p_limbo->p_objs = (void**)realloc(p_limbo->p_objs, sizeof(void*) * p_limbo->capacity);
+        assert(NULL != p_limbo->p_objs);
+    }
+    p_limbo->p_objs[p_limbo->count++] = p_obj;
+}
+
+/* The epoch only moves on once every thread in a critical section has seen
+ * the current one, so a thread is never more than one epoch behind */
+static void epoch_try_advance(uintptr_t epoch)
+{
+    epoch_rec_t* p_rec = __atomic_load_n(&Epoch_Records, __ATOMIC_ACQUIRE);
+    bool quiescent = true;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (; quiescent && (NULL != p_rec); p_rec = p_rec->p_next) {
+        uintptr_t announced = __atomic_load_n(&p_rec->announced, __ATOMIC_ACQUIRE);
+        quiescent = (0 == announced) || ((announced >> 1) == epoch);
+    }
+    if (quiescent)
+        __atomic_compare_exchange_n(&Epoch_Global, &epoch, epoch + 1, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static size_t epoch_collect(epoch_rec_t* p_rec)
+{
+    uintptr_t epoch;
+    size_t pending = 0;
+    size_t i;
+    epoch_try_advance(__atomic_load_n(&Epoch_Global, __ATOMIC_ACQUIRE));
+    epoch = __atomic_load_n(&Epoch_Global, __ATOMIC_ACQUIRE);
+    p_rec->retired = 0;
+    for (i = 0; i < 3; i++) {
+        limbo_t* p_limbo = &p_rec->limbo[i];
+        /* Two advances since retirement means every reader that could have
+         * seen the object has left its critical section */
+        if ((p_limbo->count > 0) && ((p_limbo->epoch + 2) <= epoch))
+            limbo_flush(p_limbo, p_limbo->epoch);
+    }
+    for (i = 0; i < 3; i++)
+        pending += p_rec->limbo[i].count;
+    return pending;
+}
+
+void mem_epoch_register(void)
+{
+    epoch_rec_t* p_rec;
+    if (NULL == Epoch_Thread) {
+        for (p_rec = __atomic_load_n(&Epoch_Records, __ATOMIC_ACQUIRE); NULL != p_rec; p_rec = p_rec->p_next) {
+            bool expected = false;
+            if (!__atomic_load_n(&p_rec->in_use, __ATOMIC_RELAXED) &&
+                __atomic_compare_exchange_n(&p_rec->in_use, &expected, true, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                break;
+        }
+        if (NULL == p_rec) {
+            p_rec = (epoch_rec_t*)mem_make_immortal(
+                mem_allocate_aligned(sizeof(epoch_rec_t), MEM_CACHE_LINE_SIZE, NULL));
+            memset(p_rec, 0, sizeof(epoch_rec_t));
+            p_rec->in_use = true;
+            p_rec->p_next = __atomic_load_n(&Epoch_Records, __ATOMIC_RELAXED);
+            while (!__atomic_compare_exchange_n(&Epoch_Records, &p_rec->p_next, p_rec, true,
+                                                __ATOMIC_RELEASE, __ATOMIC_RELAXED)) { }
+        }
+        Epoch_Thread = p_rec;
+    }
+}
+
+void mem_epoch_unregister(void)
+{
+    epoch_rec_t* p_rec = Epoch_Thread;
+    if (NULL != p_rec) {
+        mem_epoch_barrier();
+        Epoch_Thread = NULL;
+        __atomic_store_n(&p_rec->in_use, false, __ATOMIC_RELEASE);
+    }
+}
+
+void mem_epoch_enter(void)
+{
+    epoch_rec_t* p_rec = Epoch_Thread;
+    uintptr_t epoch;
+    assert(NULL != p_rec);
+    if (0 == p_rec->nesting++) {
+        /* Announce again if the epoch moved on before the announcement was
+         * visible, as the advancing thread may not have accounted for us */
+        do {
+            epoch = __atomic_load_n(&Epoch_Global, __ATOMIC_RELAXED);
+            __atomic_store_n(&p_rec->announced, (epoch << 1) | 1u, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        } while (epoch != __atomic_load_n(&Epoch_Global, __ATOMIC_RELAXED));
+    }
+}
+
+void mem_epoch_exit(void)
+{
+    epoch_rec_t* p_rec = Epoch_Thread;
+    assert((NULL != p_rec) && (p_rec->nesting > 0));
+    if (0 == --p_rec->nesting)
+        __atomic_store_n(&p_rec->announced, 0, __ATOMIC_RELEASE);
+}
+
+void mem_retire(void* p_obj)
+{
+    epoch_rec_t* p_rec = Epoch_Thread;
+    limbo_t* p_limbo;
+    uintptr_t epoch;
+    assert((NULL != p_rec) && (NULL != p_obj));
+    /* The epoch must be read after the object was unlinked so that any reader
+     * still holding it announced this epoch or an earlier one */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n(&Epoch_Global, __ATOMIC_RELAXED);
+    p_limbo = &p_rec->limbo[epoch % 3];
+    /* Anything left in the slot is three epochs old and safe to release */
+    if (p_limbo->epoch != epoch)
+        limbo_flush(p_limbo, epoch);
+    limbo_push(p_limbo, p_obj);
+    if (++p_rec->retired >= MEM_EPOCH_RETIRE_THRESHOLD)
+        epoch_collect(p_rec);
+}
+
+size_t mem_epoch_collect(void)
+{
+    assert(NULL != Epoch_Thread);
+    return epoch_collect(Epoch_Thread);
+}
+
+void mem_epoch_barrier(void)
+{
+    epoch_rec_t* p_rec = Epoch_Thread;
+    assert((NULL != p_rec) && (0 == p_rec->nesting));
+    while (epoch_collect(p_rec) > 0)
+        sched_yield();
+}
@@ -0,0 +1,83 @@
+/**
+  @file epoch.h
+  @brief Epoch based reclamation for objects shared with lock-free readers.
+  */
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mem.h"
+
+/** The number of objects a thread retires between attempts to advance the
+ *  global epoch and reclaim what it has retired */
+#ifndef MEM_EPOCH_RETIRE_THRESHOLD
+#define MEM_EPOCH_RETIRE_THRESHOLD 64
+#endif
+
+/**
+ * @brief Registers the calling thread with the reclamation epochs.
+ *
+ * A thread must be registered before it enters a critical section or retires
+ * an object. Registering an already registered thread has no effect.
+ */
+void mem_epoch_register(void);
+
+/**
+ * @brief Unregisters the calling thread.
+ *
+ * Waits for the objects the thread has retired to become unreachable and
+ * releases them, so this blocks while any other thread is in a critical
+ * section that started before the call.
+ */
+void mem_epoch_unregister(void);
+
+/**
+ * @brief Enters a critical section on the calling thread.
+ *
+ * Objects reached through shared pointers inside the critical section will
+ * not be reclaimed until it is exited, even if they are retired meanwhile.
+ * Critical sections may be nested.
+ */
+void mem_epoch_enter(void);
+
+/**
+ * @brief Exits the innermost critical section on the calling thread.
+ */
+void mem_epoch_exit(void);
+
+/**
+ * @brief Retires an object that has been unlinked from every shared pointer.
+ *
+ * The reference the caller held is released once no thread can still be in
+ * a critical section that might have read the object. Readers that need it
+ * for longer should mem_retain it inside their critical section, which
+ * requires the object to have been passed to mem_share.
+ *
+ * @param p_obj The object to be retired.
+ */
+void mem_retire(void* p_obj);
+
+/**
+ * @brief Tries to advance the global epoch and releases whatever the calling
+ *        thread retired that is now safe to reclaim.
+ *
+ * @return The number of objects retired by this thread still awaiting release.
+ */
+size_t mem_epoch_collect(void);
+
+/**
+ * @brief Waits until every object the calling thread has retired so far has
+ *        been released.
+ *
+ * Must not be called from inside a critical section.
+ */
+void mem_epoch_barrier(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EPOCH_H */
@@ -2,39 +2,969 @@
   @file mem.c
   @brief See header for details
   */
+/* mremap and MAP_ANONYMOUS are extensions */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include "mem.h"
 #include <stdio.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#if (MEM_MMAP_THRESHOLD > 0)
+#include <sys/mman.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
+#if (MEM_BIASED_REFCOUNT > 0) || (MEM_SLAB_ALLOCATOR > 0)
+#include <pthread.h>
+#endif
 
 typedef struct {
+#if (LEAK_DETECT_LEVEL > 0)
+    size_t size;    /* size of the payload, for the allocation statistics */
+    size_t type;    /* slot in the per type statistics table */
+#endif
     int refcount;
+#if (MEM_BIASED_REFCOUNT > 0)
+    int shared;     /* count from other threads, see brc_unref */
+    uint32_t owner; /* thread that may use refcount without atomics */
+#if (MEM_COMPACT_HEADER == 0)
+    uint32_t reserved; /* pads the header to 32 bytes to keep payloads 16-byte aligned */
+#endif
+#endif
+#if (MEM_COMPACT_HEADER > 0)
+    uint16_t finalize; /* slot in the destructor table, 0 for no destructor */
+    uint8_t pool;
+    uint8_t flags;
+#else
+    uint16_t pool;
+    uint16_t flags;
     destructor_t p_finalize;
+#endif
 } obj_t;
 
+/* The reference count of this object is updated atomically */
+#define OBJ_SHARED 0x0001u
+/* This object lives in an arena and is reclaimed when the arena is */
+#define OBJ_ARENA  0x0002u
+/* The payload was over-aligned, so on the heap the header is preceded by the
+ * payload size and its offset from the start of the malloc'd block */
+#define OBJ_ALIGNED 0x0004u
+/* The object has a memory mapping of its own and the header is preceded by
+ * the payload size and the length of the mapping */
+#define OBJ_MAPPED 0x0008u
+
+/* Any count at or above this is saturated and the object is never reclaimed.
+ * Immortal objects start well above it so that racing retains and releases
+ * that read the count before it was set cannot bring it back down. */
+#define IMMORTAL_THRESHOLD (INT_MAX / 2)
+#define IMMORTAL_REFCOUNT  (IMMORTAL_THRESHOLD + (INT_MAX / 4))
+
+/* The alignment every payload gets without asking, given that malloc, slab
+ * blocks and arena records all start on a 16-byte boundary */
+#define OBJ_ALIGNMENT ((0 == (sizeof(obj_t) % 16u)) ? 16u : 8u)
+
+#if (MEM_COMPACT_HEADER > 0)
+#if ((MEM_DESTRUCTOR_TABLE_SIZE & (MEM_DESTRUCTOR_TABLE_SIZE - 1)) != 0) || (MEM_DESTRUCTOR_TABLE_SIZE > 65536)
+#error "MEM_DESTRUCTOR_TABLE_SIZE must be a power of two no larger than 65536"
+#endif
+
+/* Every destructor that has been used by a compact header. Slots are claimed
+ * once and never change afterwards so they can be read without locking. */
+static destructor_t Destructors[MEM_DESTRUCTOR_TABLE_SIZE];
+
+static uint16_t destructor_slot(destructor_t p_destruct_fn)
+{
+    size_t mask = MEM_DESTRUCTOR_TABLE_SIZE - 1u;
+    size_t slot = 0;
+    size_t probes = 0;
+    if (NULL != p_destruct_fn) {
+        slot = (((uintptr_t)p_destruct_fn >> 4) * 2654435761u) & mask;
+        while (true) {
+            destructor_t p_expected = NULL;
+            if (0 == slot)
+                slot = 1; /* reserved for objects without a destructor */
+            if (__atomic_load_n(&Destructors[slot], __ATOMIC_ACQUIRE) == p_destruct_fn)
+                break;
+            if (__atomic_compare_exchange_n(&Destructors[slot], &p_expected, p_destruct_fn,
+                                            false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+                || (p_expected == p_destruct_fn))
+                break;
+            probes++;
+            assert(probes < MEM_DESTRUCTOR_TABLE_SIZE);
+            slot = (slot + 1u) & mask;
+        }
+    }
+    return (uint16_t)slot;
+}
+
+static destructor_t obj_finalizer(obj_t* p_obj)
+{
+    return Destructors[p_obj->finalize];
+}
+
+static void obj_set_finalizer(obj_t* p_obj, destructor_t p_destruct_fn)
+{
+    p_obj->finalize = destructor_slot(p_destruct_fn);
+}
+#else
+static destructor_t obj_finalizer(obj_t* p_obj)
+{
+    return p_obj->p_finalize;
+}
+
+static void obj_set_finalizer(obj_t* p_obj, destructor_t p_destruct_fn)
+{
+    p_obj->p_finalize = p_destruct_fn;
+}
+#endif
+
+typedef struct arena_rec_t {
+    struct arena_rec_t* p_next; /* next arena object that has a destructor */
+    size_t size;                /* size of the object's payload */
+} arena_rec_t;
+
+typedef struct arena_chunk_t {
+    struct arena_chunk_t* p_next;
+    size_t pad;                 /* keeps the chunk data 16-byte aligned */
+} arena_chunk_t;
+
+struct mem_arena_t {
+    arena_chunk_t* p_chunks;    /* every chunk owned by the arena */
+    uint8_t* p_next;            /* bump pointer into the newest chunk */
+    uint8_t* p_end;             /* end of the newest chunk */
+    size_t chunk_size;          /* size of each regular chunk */
+    arena_rec_t* p_finalize;    /* arena objects that need destructing */
+    size_t num_objects;         /* number of objects allocated in the arena */
+    size_t num_bytes;           /* payload bytes allocated in the arena */
+    mem_arena_t* p_outer;       /* arena that was active before this one */
+};
+
+/* The arena that new objects are allocated from on this thread */
+static THREAD_LOCAL mem_arena_t* Mem_Arena = NULL;
+
+/* The number of queued objects held without allocating. Deeper graphs spill
+ * to the heap and the spill is freed once the queue empties again, so threads
+ * that exit after releasing objects leave nothing behind. */
+#define RELEASE_QUEUE_INLINE 32
+
+/* Objects whose last reference has been released but that have not yet been
+ * destructed. Destructors release into the queue rather than recursing. */
+typedef struct {
+    obj_t** p_objs; /* the inline slots, or a heap spill once those are full */
+    size_t count;
+    size_t capacity;
+    bool draining; /* a drain is in progress further up the stack */
+    bool deferred; /* only mem_drain may process the queue */
+    obj_t* inline_objs[RELEASE_QUEUE_INLINE];
+} release_queue_t;
+
+static THREAD_LOCAL release_queue_t Release_Queue = { NULL, 0, 0, false, false, { NULL } };
+
 typedef struct {
     intptr_t val;
 } box_t;
 
+#if (MEM_TAGGED_INTEGERS > 0)
+/* Object pointers are always aligned so only tagged immediates set bit 0 */
+#define IS_IMMEDIATE(p_obj) (0 != ((uintptr_t)(p_obj) & 1u))
+#else
+#define IS_IMMEDIATE(p_obj) false
+#endif
+
 #if (LEAK_DETECT_LEVEL > 0)
 bool Handler_Registered = false;
-size_t Num_Allocations = 0;
+
+/* Running totals. These only need to be atomic when objects may be released
+ * on another thread, otherwise plain adds keep them cheap. */
+#if (MEM_ATOMIC_REFCOUNT > 0) || (MEM_BIASED_REFCOUNT > 0)
+#define STATS_ADD(var, n) __atomic_add_fetch(&(var), (n), __ATOMIC_RELAXED)
+#define STATS_SUB(var, n) __atomic_sub_fetch(&(var), (n), __ATOMIC_RELAXED)
+#else
+#define STATS_ADD(var, n) ((var) += (n))
+#define STATS_SUB(var, n) ((var) -= (n))
+#endif
+
+static size_t Stats_Live_Bytes = 0;
+static size_t Stats_Peak_Bytes = 0;
+static size_t Stats_Allocations = 0;
+static size_t Stats_Frees = 0;
+
+/* Totals at the previous call to mem_stats, used to compute rates */
+static double Stats_Last_Time = 0;
+static size_t Stats_Last_Allocations = 0;
+static size_t Stats_Last_Frees = 0;
+#endif
+
+/* Set by the signal handler registered with mem_stats_dump_on_signal. The dump
+ * itself is not async-signal-safe, so it waits for the next allocation or call
+ * to mem_stats_poll. */
+static volatile sig_atomic_t Stats_Dump_Requested = 0;
+
+/* Type slot for objects that are not part of the per type breakdown */
+#define NO_TYPE ((size_t)-1)
+
+#if (LEAK_DETECT_LEVEL > 1)
+static mem_type_stats_t Stats_Types[MEM_STATS_MAX_TYPES];
+static bool Stats_Types_Lock = false;
 #endif
 
 #if (LEAK_DETECT_LEVEL > 0)
 void summarize_leaks(void) {
-    if(Num_Allocations > 0) {
+    if(Stats_Allocations > Stats_Frees) {
         puts("Warning: Memory leak(s) detected!");
+#if (LEAK_DETECT_LEVEL > 1)
+        fflush(stdout);
+        mem_stats_dump(STDOUT_FILENO);
+#else
         printf("\nFor more details set the LEAK_DETECT_LEVEL build option to 2 or run the executable in valgrind.\n");
+#endif
     }
 }
 #endif
 
-void* mem_allocate(size_t size, destructor_t p_destruct_fn)
+#if (LEAK_DETECT_LEVEL > 0)
+static double stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+#endif
+
+#if (LEAK_DETECT_LEVEL > 1)
+static size_t stats_type(destructor_t p_destruct_fn, const char* name, const char* file)
+{
+    /* The file name is a literal, so its address identifies the call site's
+     * translation unit without having to compare strings */
+    size_t hash = (((uintptr_t)p_destruct_fn >> 4) ^ ((uintptr_t)file >> 3)) % MEM_STATS_MAX_TYPES;
+    size_t type = NO_TYPE;
+    size_t i;
+    for (i = 0; (NO_TYPE == type) && (i < MEM_STATS_MAX_TYPES); i++) {
+        mem_type_stats_t* p_type = &Stats_Types[(hash + i) % MEM_STATS_MAX_TYPES];
+        const char* p_file = __atomic_load_n(&p_type->file, __ATOMIC_ACQUIRE);
+        if (NULL == p_file) {
+            /* Claim the empty slot, unless another thread beat us to it */
+            while (__atomic_test_and_set(&Stats_Types_Lock, __ATOMIC_ACQUIRE)) { }
+            if (NULL == p_type->file) {
+                p_type->p_finalize = p_destruct_fn;
+                p_type->name = name;
+                __atomic_store_n(&p_type->file, file, __ATOMIC_RELEASE);
+            }
+            __atomic_clear(&Stats_Types_Lock, __ATOMIC_RELEASE);
+            p_file = p_type->file;
+        }
+        if ((p_type->p_finalize == p_destruct_fn) && (p_file == file))
+            type = (hash + i) % MEM_STATS_MAX_TYPES;
+    }
+    return type;
+}
+#endif
+
+#if (LEAK_DETECT_LEVEL > 0)
+static void stats_allocated(obj_t* p_obj, size_t size, size_t type)
+{
+    size_t live = STATS_ADD(Stats_Live_Bytes, size);
+    /* Racing threads may under-report the peak slightly, which is fine */
+    if (live > __atomic_load_n(&Stats_Peak_Bytes, __ATOMIC_RELAXED))
+        __atomic_store_n(&Stats_Peak_Bytes, live, __ATOMIC_RELAXED);
+    STATS_ADD(Stats_Allocations, 1);
+    p_obj->size = size;
+    p_obj->type = type;
+#if (LEAK_DETECT_LEVEL > 1)
+    if (NO_TYPE != type) {
+        STATS_ADD(Stats_Types[type].live_objects, 1);
+        STATS_ADD(Stats_Types[type].live_bytes, size);
+        STATS_ADD(Stats_Types[type].allocations, 1);
+    }
+#endif
+    if (Stats_Dump_Requested)
+        mem_stats_poll();
+}
+
+static void stats_freed(size_t num_objects, size_t num_bytes, size_t type)
+{
+    STATS_SUB(Stats_Live_Bytes, num_bytes);
+    STATS_ADD(Stats_Frees, num_objects);
+#if (LEAK_DETECT_LEVEL > 1)
+    if (NO_TYPE != type) {
+        STATS_SUB(Stats_Types[type].live_objects, num_objects);
+        STATS_SUB(Stats_Types[type].live_bytes, num_bytes);
+    }
+#else
+    (void)type;
+#endif
+}
+#endif
+
+#if (MEM_SLAB_ALLOCATOR > 0)
+/* Size classes are spaced so that every payload keeps malloc's alignment */
+#define SLAB_GRANULE   16u
+#define SLAB_NUM_POOLS ((MEM_SLAB_MAX_SIZE + SLAB_GRANULE - 1) / SLAB_GRANULE)
+
+#if (MEM_COMPACT_HEADER > 0) && (SLAB_NUM_POOLS > 255)
+#error "MEM_SLAB_MAX_SIZE is too large for the pool index of the compact header"
+#endif
+
+/* A bounded stack of free blocks of one size class. Threads allocate from
+ * and release into their own magazines without locking, and only trade whole
+ * magazines with the depot, so blocks released on another thread find their
+ * way back in batches. */
+typedef struct slab_magazine_t {
+    struct slab_magazine_t* p_next;
+    size_t count;
+    obj_t* p_blocks[MEM_SLAB_MAGAZINE_SIZE];
+} slab_magazine_t;
+
+typedef struct {
+    slab_magazine_t* p_loaded;   /* the magazine blocks come from and go to */
+    slab_magazine_t* p_previous; /* a spare that is either full or empty */
+    uint8_t* p_next;             /* next never used block in the current chunk */
+    uint8_t* p_end;              /* end of the current chunk */
+} slab_pool_t;
+
+/* Magazines shared by every thread, one depot per size class */
+typedef struct {
+    bool lock;
+    slab_magazine_t* p_full;  /* magazines holding at least one block */
+    slab_magazine_t* p_empty; /* magazines kept for reuse */
+} slab_depot_t;
+
+/* Pool 0 is reserved to mark objects that came straight from malloc */
+static THREAD_LOCAL slab_pool_t Slab_Pools[SLAB_NUM_POOLS + 1];
+static THREAD_LOCAL bool Slab_Registered = false;
+static slab_depot_t Slab_Depots[SLAB_NUM_POOLS + 1];
+static pthread_key_t Slab_Exit_Key;
+static pthread_once_t Slab_Exit_Once = PTHREAD_ONCE_INIT;
+
+static size_t slab_block_size(uint16_t pool)
+{
+    return sizeof(obj_t) + (pool * SLAB_GRANULE);
+}
+
+static void slab_depot_lock(slab_depot_t* p_depot)
+{
+    while (__atomic_test_and_set(&p_depot->lock, __ATOMIC_ACQUIRE)) { }
+}
+
+static void slab_depot_unlock(slab_depot_t* p_depot)
+{
+    __atomic_clear(&p_depot->lock, __ATOMIC_RELEASE);
+}
+
+static void slab_depot_push(slab_depot_t* p_depot, slab_magazine_t* p_mag)
+{
+    slab_magazine_t** pp_list = (0 == p_mag->count) ? &p_depot->p_empty : &p_depot->p_full;
+    slab_depot_lock(p_depot);
+    p_mag->p_next = *pp_list;
+    *pp_list = p_mag;
+    slab_depot_unlock(p_depot);
+}
+
+static slab_magazine_t* slab_depot_pop(slab_depot_t* p_depot, bool full)
+{
+    slab_magazine_t** pp_list = full ? &p_depot->p_full : &p_depot->p_empty;
+    slab_magazine_t* p_mag;
+    slab_depot_lock(p_depot);
+    p_mag = *pp_list;
+    if (NULL != p_mag)
+        *pp_list = p_mag->p_next;
+    slab_depot_unlock(p_depot);
+    return p_mag;
+}
+
+/* Hands the exiting thread's magazines to the depots. Releasing an object
+ * from a later destructor registers the thread again, and POSIX then runs
+ * this once more. */
+static void slab_thread_exit(void* p_arg)
+{
+    slab_pool_t* p_pools = (slab_pool_t*)p_arg;
+    uint16_t pool;
+    Slab_Registered = false;
+    for (pool = 1; pool <= SLAB_NUM_POOLS; pool++) {
+        if (NULL != p_pools[pool].p_loaded)
+            slab_depot_push(&Slab_Depots[pool], p_pools[pool].p_loaded);
+        if (NULL != p_pools[pool].p_previous)
+            slab_depot_push(&Slab_Depots[pool], p_pools[pool].p_previous);
+        p_pools[pool].p_loaded   = NULL;
+        p_pools[pool].p_previous = NULL;
+    }
+}
+
+static void slab_create_exit_key(void)
+{
+    pthread_key_create(&Slab_Exit_Key, slab_thread_exit);
+}
+
+static slab_magazine_t* slab_magazine_new(void)
+{
+    slab_magazine_t* p_mag = (slab_magazine_t*)malloc(sizeof(slab_magazine_t));
+    assert(NULL != p_mag);
+    p_mag->p_next = NULL;
+    p_mag->count  = 0;
+    return p_mag;
+}
+
+static slab_pool_t* slab_pool(uint16_t pool)
+{
+    slab_pool_t* p_pool = &Slab_Pools[pool];
+    if (!Slab_Registered) {
+        pthread_once(&Slab_Exit_Once, slab_create_exit_key);
+        pthread_setspecific(Slab_Exit_Key, Slab_Pools);
+        Slab_Registered = true;
+    }
+    if (NULL == p_pool->p_loaded) {
+        p_pool->p_loaded   = slab_magazine_new();
+        p_pool->p_previous = slab_magazine_new();
+    }
+    return p_pool;
+}
+
+static obj_t* slab_carve(slab_pool_t* p_pool, uint16_t pool)
+{
+    size_t block_size = slab_block_size(pool);
+    obj_t* p_obj;
+    if ((size_t)(p_pool->p_end - p_pool->p_next) < block_size) {
+        /* Whatever is left of the old chunk is too small for a block */
+        size_t chunk_size = (MEM_SLAB_CHUNK_SIZE / block_size) * block_size;
+        if (chunk_size < block_size)
+            chunk_size = block_size;
+        p_pool->p_next = (uint8_t*)malloc(chunk_size);
+        assert(NULL != p_pool->p_next);
+        p_pool->p_end  = p_pool->p_next + chunk_size;
+    }
+    p_obj = (obj_t*)p_pool->p_next;
+    p_pool->p_next += block_size;
+    return p_obj;
+}
+
+static obj_t* slab_allocate(size_t size)
+{
+    uint16_t pool = (uint16_t)((size + SLAB_GRANULE - 1) / SLAB_GRANULE);
+    slab_pool_t* p_pool;
+    slab_magazine_t* p_mag;
+    obj_t* p_obj;
+    if (0 == pool)
+        pool = 1;
+    p_pool = slab_pool(pool);
+    if (0 == p_pool->p_loaded->count) {
+        p_mag = p_pool->p_previous;
+        if (0 == p_mag->count) {
+            /* Both are empty, so trade one for a full magazine if there is one */
+            p_mag = slab_depot_pop(&Slab_Depots[pool], true);
+            if (NULL != p_mag) {
+                slab_depot_push(&Slab_Depots[pool], p_pool->p_previous);
+            } else {
+                p_mag = p_pool->p_previous;
+            }
+        }
+        p_pool->p_previous = p_pool->p_loaded;
+        p_pool->p_loaded   = p_mag;
+    }
+    if (0 != p_pool->p_loaded->count)
+        p_obj = p_pool->p_loaded->p_blocks[--p_pool->p_loaded->count];
+    else
+        p_obj = slab_carve(p_pool, pool);
+    p_obj->pool  = pool;
+    p_obj->flags = 0;
+    return p_obj;
+}
+
+static void slab_free(obj_t* p_obj)
+{
+    uint16_t pool = p_obj->pool;
+    slab_pool_t* p_pool = slab_pool(pool);
+    slab_magazine_t* p_mag;
+    if (MEM_SLAB_MAGAZINE_SIZE == p_pool->p_loaded->count) {
+        p_mag = p_pool->p_previous;
+        if (0 != p_mag->count) {
+            /* Both are full, so hand one to the depot for other threads */
+            slab_depot_push(&Slab_Depots[pool], p_mag);
+            p_mag = slab_depot_pop(&Slab_Depots[pool], false);
+            if (NULL == p_mag)
+                p_mag = slab_magazine_new();
+        }
+        p_pool->p_previous = p_pool->p_loaded;
+        p_pool->p_loaded   = p_mag;
+    }
+    p_pool->p_loaded->p_blocks[p_pool->p_loaded->count++] = p_obj;
+}
+#endif
+
+#if (MEM_MMAP_THRESHOLD > 0)
+static size_t Mapped_Page_Size = 0;
+
+static size_t mapped_page_size(void)
+{
+    size_t page_size = __atomic_load_n(&Mapped_Page_Size, __ATOMIC_RELAXED);
+    if (0 == page_size) {
+        page_size = (size_t)sysconf(_SC_PAGESIZE);
+        __atomic_store_n(&Mapped_Page_Size, page_size, __ATOMIC_RELAXED);
+    }
+    return page_size;
+}
+
+static size_t mapped_length(size_t bytes)
+{
+    size_t page_size = mapped_page_size();
+#if (MEM_HUGE_PAGES > 0)
+    /* Whole huge pages, so the tail of the mapping is not left on small ones */
+    if (bytes >= MEM_HUGE_PAGE_SIZE)
+        page_size = MEM_HUGE_PAGE_SIZE;
+#endif
+    return (bytes + page_size - 1) & ~(page_size - 1);
+}
+
+static void mapped_advise(uint8_t* p_base, size_t length)
+{
+#if (MEM_HUGE_PAGES > 0) && defined(MADV_HUGEPAGE)
+    if (length >= MEM_HUGE_PAGE_SIZE)
+        (void)madvise(p_base, length, MADV_HUGEPAGE);
+#else
+    (void)p_base;
+    (void)length;
+#endif
+}
+
+/* The mapping starts in the page holding the sizes ahead of the header */
+static uint8_t* mapped_base(obj_t* p_obj)
+{
+    return (uint8_t*)((uintptr_t)&((size_t*)p_obj)[-2] & ~(uintptr_t)(mapped_page_size() - 1));
+}
+
+static uint8_t* mapped_map(size_t length)
+{
+    uint8_t* p_base;
+#if (MEM_HUGE_PAGES > 0)
+    /* Over-map and trim so the mapping starts on a huge page boundary */
+    if (length >= MEM_HUGE_PAGE_SIZE) {
+        uint8_t* p_map = (uint8_t*)mmap(NULL, length + MEM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        size_t head;
+        assert(MAP_FAILED != (void*)p_map);
+        p_base = (uint8_t*)(((uintptr_t)p_map + MEM_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(MEM_HUGE_PAGE_SIZE - 1));
+        head = (size_t)(p_base - p_map);
+        if (head > 0)
+            munmap(p_map, head);
+        munmap(p_base + length, MEM_HUGE_PAGE_SIZE - head);
+    } else
+#endif
+    {
+        p_base = (uint8_t*)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(MAP_FAILED != (void*)p_base);
+    }
+    mapped_advise(p_base, length);
+    return p_base;
+}
+
+static obj_t* mapped_allocate(size_t size, size_t align)
+{
+    size_t hdr_size = (2 * sizeof(size_t)) + sizeof(obj_t);
+    size_t prefix;
+    size_t length;
+    obj_t* p_obj;
+    align  = (align < OBJ_ALIGNMENT) ? OBJ_ALIGNMENT : align;
+    prefix = (hdr_size + align - 1) & ~(align - 1);
+    length = mapped_length(prefix + size);
+    p_obj = ((obj_t*)(mapped_map(length) + prefix)) - 1;
+    ((size_t*)p_obj)[-1] = length;
+    ((size_t*)p_obj)[-2] = size;
+    p_obj->pool  = 0;
+    p_obj->flags = OBJ_MAPPED;
+    return p_obj;
+}
+
+static obj_t* mapped_resize(obj_t* p_obj, size_t size)
+{
+    uint8_t* p_base = mapped_base(p_obj);
+    size_t prefix = (size_t)((uint8_t*)(p_obj+1) - p_base);
+    size_t old_length = ((size_t*)p_obj)[-1];
+    size_t length = mapped_length(prefix + size);
+    if (length != old_length) {
+#ifdef MREMAP_MAYMOVE
+        /* The kernel moves the pages themselves, so nothing is copied */
+        p_base = (uint8_t*)mremap(p_base, old_length, length, MREMAP_MAYMOVE);
+        assert(MAP_FAILED != (void*)p_base);
+        if (length > old_length)
+            mapped_advise(p_base, length);
+#else
+        uint8_t* p_new = mapped_map(length);
+        memcpy(p_new, p_base, (length < old_length) ? length : old_length);
+        munmap(p_base, old_length);
+        p_base = p_new;
+#endif
+        p_obj = ((obj_t*)(p_base + prefix)) - 1;
+        ((size_t*)p_obj)[-1] = length;
+    }
+    ((size_t*)p_obj)[-2] = size;
+    return p_obj;
+}
+
+static void mapped_free(obj_t* p_obj)
+{
+    munmap(mapped_base(p_obj), ((size_t*)p_obj)[-1]);
+}
+#endif
+
+static obj_t* obj_allocate(size_t size)
+{
+    obj_t* p_obj = NULL;
+#if (MEM_SLAB_ALLOCATOR > 0)
+    if (size <= MEM_SLAB_MAX_SIZE)
+        p_obj = slab_allocate(size);
+#endif
+#if (MEM_MMAP_THRESHOLD > 0)
+    if ((sizeof(obj_t) + size) >= MEM_MMAP_THRESHOLD)
+        p_obj = mapped_allocate(size, OBJ_ALIGNMENT);
+#endif
+    if (NULL == p_obj) {
+        p_obj = (obj_t*)malloc(sizeof(obj_t) + size);
+        assert(NULL != p_obj);
+        p_obj->pool  = 0;
+        p_obj->flags = 0;
+    }
+    return p_obj;
+}
+
+static obj_t* obj_allocate_aligned(size_t size, size_t align)
+{
+    size_t hdr_size = (2 * sizeof(size_t)) + sizeof(obj_t);
+    uint8_t* p_base;
+    uintptr_t payload;
+    obj_t* p_obj;
+    if (align <= OBJ_ALIGNMENT) {
+        p_obj = obj_allocate(size);
+#if (MEM_MMAP_THRESHOLD > 0)
+    } else if (((sizeof(obj_t) + size) >= MEM_MMAP_THRESHOLD) && (align <= mapped_page_size())) {
+        p_obj = mapped_allocate(size, align);
+#endif
+    } else {
+        p_base = (uint8_t*)malloc(hdr_size + (align - 1) + size);
+        assert(NULL != p_base);
+        payload = ((uintptr_t)(p_base + hdr_size) + (align - 1)) & ~(uintptr_t)(align - 1);
+        p_obj = ((obj_t*)payload) - 1;
+        ((size_t*)p_obj)[-1] = (size_t)((uint8_t*)p_obj - p_base);
+        ((size_t*)p_obj)[-2] = size;
+        p_obj->pool  = 0;
+        p_obj->flags = OBJ_ALIGNED;
+    }
+    return p_obj;
+}
+
+static void obj_free(obj_t* p_obj)
+{
+#if (MEM_SLAB_ALLOCATOR > 0)
+    if (0 != p_obj->pool)
+        slab_free(p_obj);
+    else
+#endif
+#if (MEM_MMAP_THRESHOLD > 0)
+    if (0 != (p_obj->flags & OBJ_MAPPED))
+        mapped_free(p_obj);
+    else
+#endif
+    if (0 != (p_obj->flags & OBJ_ALIGNED))
+        free((uint8_t*)p_obj - ((size_t*)p_obj)[-1]);
+    else
+        free(p_obj);
+}
+
+static uint8_t* arena_chunk_new(mem_arena_t* p_arena, size_t size)
+{
+    arena_chunk_t* p_chunk = (arena_chunk_t*)malloc(sizeof(arena_chunk_t) + size);
+    assert(NULL != p_chunk);
+    p_chunk->p_next = p_arena->p_chunks;
+    p_arena->p_chunks = p_chunk;
+    return (uint8_t*)(p_chunk+1);
+}
+
+static obj_t* arena_allocate(mem_arena_t* p_arena, size_t size, size_t align, destructor_t p_destruct_fn)
+{
+    size_t hdr_size = sizeof(arena_rec_t) + sizeof(obj_t);
+    size_t pad = (align > OBJ_ALIGNMENT) ? (align - 1) : 0;
+    /* Round up so the next record stays aligned like a malloc'd block */
+    size_t block_size = (hdr_size + pad + size + 15u) & ~(size_t)15u;
+    uint8_t* p_block;
+    arena_rec_t* p_rec;
+    obj_t* p_obj;
+    bool oversized = (block_size > (p_arena->chunk_size / 4));
+    if (oversized) {
+        /* Oversized objects get a chunk of their own so the current one is
+         * not abandoned half used */
+        p_block = arena_chunk_new(p_arena, block_size);
+    } else {
+        if ((size_t)(p_arena->p_end - p_arena->p_next) < block_size) {
+            p_arena->p_next = arena_chunk_new(p_arena, p_arena->chunk_size);
+            p_arena->p_end  = p_arena->p_next + p_arena->chunk_size;
+        }
+        p_block = p_arena->p_next;
+    }
+    if (0 != pad)
+        p_block = (uint8_t*)(((uintptr_t)(p_block + hdr_size + pad) & ~(uintptr_t)(align - 1)) - hdr_size);
+    p_rec = (arena_rec_t*)p_block;
+    if (!oversized)
+        p_arena->p_next = (uint8_t*)(((uintptr_t)(p_block + hdr_size + size) + 15u) & ~(uintptr_t)15u);
+    p_rec->size = size;
+    if (NULL != p_destruct_fn) {
+        p_rec->p_next = p_arena->p_finalize;
+        p_arena->p_finalize = p_rec;
+    }
+    p_arena->num_objects++;
+    p_arena->num_bytes += size;
+    p_obj = (obj_t*)(p_rec+1);
+    p_obj->pool  = 0;
+    p_obj->flags = (0 != pad) ? (OBJ_ARENA | OBJ_ALIGNED) : OBJ_ARENA;
+    return p_obj;
+}
+
+static void arena_free(void* p_obj)
+{
+    mem_arena_t* p_arena = (mem_arena_t*)p_obj;
+    arena_rec_t* p_rec;
+    arena_chunk_t* p_chunk;
+    assert(Mem_Arena != p_arena);
+    /* Destructors still run so that heap objects referenced from the arena
+     * are released, but releases of other arena objects are no-ops and the
+     * memory itself goes back a chunk at a time */
+    for (p_rec = p_arena->p_finalize; NULL != p_rec; p_rec = p_rec->p_next) {
+        obj_t* p_hdr = (obj_t*)(p_rec+1);
+        destructor_t p_finalize = obj_finalizer(p_hdr);
+        if (NULL != p_finalize)
+            p_finalize(p_hdr+1);
+    }
+    while (NULL != p_arena->p_chunks) {
+        p_chunk = p_arena->p_chunks;
+        p_arena->p_chunks = p_chunk->p_next;
+        free(p_chunk);
+    }
+#if (LEAK_DETECT_LEVEL > 0)
+    stats_freed(p_arena->num_objects, p_arena->num_bytes, NO_TYPE);
+#endif
+}
+
+#if (MEM_BIASED_REFCOUNT > 0)
+/* Biased reference counting. The thread that allocates an object owns it and
+ * counts its own references in obj_t.refcount without atomics. Every other
+ * thread counts in obj_t.shared, which holds the count shifted up past two
+ * flags. When the owner drops its last reference, or the shared count goes
+ * negative and the object is queued back to the owner, the two counts are
+ * merged and the object is counted only in shared from then on. */
+#define BRC_MERGED   0x1
+#define BRC_QUEUED   0x2
+#define BRC_ONE      4
+#define BRC_COUNT(shared) (((shared) & ~(BRC_MERGED | BRC_QUEUED)) / BRC_ONE)
+#define BRC_UNOWNED  0u
+#define BRC_NO_OWNER UINT32_MAX
+
+/* Objects queued back to a thread for merging, and whether it has exited */
+typedef struct {
+    bool lock;
+    bool pending;
+    bool exited;
+    obj_t** p_objs;
+    size_t count;
+    size_t capacity;
+} brc_thread_t;
+
+/* Thread ids are never reused, so a stale owner can only name an exited
+ * thread. Threads beyond the table simply never own objects. */
+static brc_thread_t* Brc_Threads[MEM_BRC_MAX_THREADS];
+static uint32_t Brc_Next_Id = 1;
+static pthread_key_t Brc_Exit_Key;
+static pthread_once_t Brc_Exit_Once = PTHREAD_ONCE_INIT;
+
+static THREAD_LOCAL uint32_t Brc_Id = BRC_NO_OWNER;
+static THREAD_LOCAL brc_thread_t* Brc_Self = NULL;
+static THREAD_LOCAL bool Brc_Registered = false;
+
+static void obj_reclaim(obj_t* p_hdr);
+
+/* Folds the owner's count into the shared count and returns whether no
+ * references remain. Only called by the owner or once the owner has exited. */
+static bool brc_merge(obj_t* p_hdr)
+{
+    int biased = p_hdr->refcount;
+    int shared = __atomic_load_n(&p_hdr->shared, __ATOMIC_RELAXED);
+    int merged;
+    __atomic_store_n(&p_hdr->owner, BRC_UNOWNED, __ATOMIC_RELAXED);
+    do {
+        merged = (0 != (shared & BRC_MERGED)) ? shared : (shared + (biased * BRC_ONE));
+        merged = (merged | BRC_MERGED) & ~BRC_QUEUED;
+    } while (!__atomic_compare_exchange_n(&p_hdr->shared, &shared, merged, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    p_hdr->refcount = 0;
+    return (0 == BRC_COUNT(merged));
+}
+
+static void brc_process_inbox(brc_thread_t* p_thread)
+{
+    obj_t** p_objs;
+    size_t count;
+    size_t i;
+    while (__atomic_test_and_set(&p_thread->lock, __ATOMIC_ACQUIRE)) { }
+    p_objs = p_thread->p_objs;
+    count  = p_thread->count;
+    p_thread->p_objs   = NULL;
+    p_thread->count    = 0;
+    p_thread->capacity = 0;
+    __atomic_store_n(&p_thread->pending, false, __ATOMIC_RELAXED);
+    __atomic_clear(&p_thread->lock, __ATOMIC_RELEASE);
+    for (i = 0; i < count; i++) {
+        if (brc_merge(p_objs[i]))
+            obj_reclaim(p_objs[i]);
+    }
+    free(p_objs);
+}
+
+/* Objects still owned by an exiting thread are merged by whichever thread
+ * next queues them */
+static void brc_thread_exit(void* p_arg)
+{
+    brc_thread_t* p_thread = (brc_thread_t*)p_arg;
+    Brc_Id = BRC_NO_OWNER;
+    Brc_Self = NULL;
+    while (__atomic_test_and_set(&p_thread->lock, __ATOMIC_ACQUIRE)) { }
+    p_thread->exited = true;
+    __atomic_clear(&p_thread->lock, __ATOMIC_RELEASE);
+    brc_process_inbox(p_thread);
+}
+
+static void brc_create_exit_key(void)
+{
+    pthread_key_create(&Brc_Exit_Key, brc_thread_exit);
+}
+
+static void brc_register(void)
+{
+    uint32_t id = __atomic_fetch_add(&Brc_Next_Id, 1, __ATOMIC_RELAXED);
+    Brc_Registered = true;
+    if (id < MEM_BRC_MAX_THREADS) {
+        brc_thread_t* p_thread = (brc_thread_t*)calloc(1, sizeof(brc_thread_t));
+        assert(NULL != p_thread);
+        __atomic_store_n(&Brc_Threads[id], p_thread, __ATOMIC_RELEASE);
+        pthread_once(&Brc_Exit_Once, brc_create_exit_key);
+        pthread_setspecific(Brc_Exit_Key, p_thread);
+        Brc_Id = id;
+        Brc_Self = p_thread;
+    }
+}
+
+static void brc_init(obj_t* p_hdr)
+{
+    if (!Brc_Registered)
+        brc_register();
+    else if ((NULL != Brc_Self) && __atomic_load_n(&Brc_Self->pending, __ATOMIC_RELAXED))
+        brc_process_inbox(Brc_Self);
+    if (BRC_NO_OWNER != Brc_Id) {
+        p_hdr->owner  = Brc_Id;
+        p_hdr->shared = 0;
+    } else {
+        p_hdr->owner    = BRC_UNOWNED;
+        p_hdr->refcount = 0;
+        p_hdr->shared   = BRC_ONE | BRC_MERGED;
+    }
+}
+
+static void brc_queue(obj_t* p_hdr, uint32_t owner)
+{
+    brc_thread_t* p_thread = __atomic_load_n(&Brc_Threads[owner], __ATOMIC_ACQUIRE);
+    bool exited;
+    while (__atomic_test_and_set(&p_thread->lock, __ATOMIC_ACQUIRE)) { }
+    exited = p_thread->exited;
+    if (!exited) {
+        if (p_thread->count == p_thread->capacity) {
+            p_thread->capacity = (0 == p_thread->capacity) ? 16 : (p_thread->capacity * 2);
+            p_thread->p_objs = (obj_t**)realloc(p_thread->p_objs, sizeof(obj_t*) * p_thread->capacity);
+            assert(NULL != p_thread->p_objs);
+        }
+        p_thread->p_objs[p_thread->count++] = p_hdr;
+        __atomic_store_n(&p_thread->pending, true, __ATOMIC_RELAXED);
+    }
+    __atomic_clear(&p_thread->lock, __ATOMIC_RELEASE);
+    if (exited && brc_merge(p_hdr))
+        obj_reclaim(p_hdr);
+}
+
+static void brc_retain(obj_t* p_hdr, int count)
+{
+    if (__atomic_load_n(&p_hdr->owner, __ATOMIC_RELAXED) == Brc_Id)
+        p_hdr->refcount += count;
+    else
+        __atomic_fetch_add(&p_hdr->shared, count * BRC_ONE, __ATOMIC_RELAXED);
+}
+
+/* Drops count references and returns whether they were the last ones */
+static bool brc_unref(obj_t* p_hdr, int count)
+{
+    uint32_t owner = __atomic_load_n(&p_hdr->owner, __ATOMIC_RELAXED);
+    int shared;
+    int next;
+    bool last;
+    if (owner == Brc_Id) {
+        p_hdr->refcount -= count;
+        if (p_hdr->refcount > 0) {
+            last = false;
+            if (__atomic_load_n(&Brc_Self->pending, __ATOMIC_RELAXED))
+                brc_process_inbox(Brc_Self);
+        } else {
+            /* The owner is done with it, so only the shared count matters.
+             * If it is queued the merge in the inbox will reclaim it. */
+            __atomic_store_n(&p_hdr->owner, BRC_UNOWNED, __ATOMIC_RELAXED);
+            shared = __atomic_fetch_or(&p_hdr->shared, BRC_MERGED, __ATOMIC_ACQ_REL);
+            last = (0 == BRC_COUNT(shared)) && (0 == (shared & BRC_QUEUED));
+        }
+    } else {
+        shared = __atomic_load_n(&p_hdr->shared, __ATOMIC_RELAXED);
+        do {
+            next = shared - (count * BRC_ONE);
+            /* A negative count means the owner holds the rest, so the owner
+             * is asked to merge. Only the first such release queues it. */
+            if ((BRC_COUNT(next) < 0) && (BRC_UNOWNED != owner) &&
+                (0 == (shared & (BRC_MERGED | BRC_QUEUED))))
+                next |= BRC_QUEUED;
+        } while (!__atomic_compare_exchange_n(&p_hdr->shared, &shared, next, true,
+                                              __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+        if ((0 != (next & BRC_QUEUED)) && (0 == (shared & BRC_QUEUED))) {
+            brc_queue(p_hdr, owner);
+            last = false;
+        } else {
+            last = (0 != (next & BRC_MERGED)) && (0 == (next & BRC_QUEUED)) && (0 == BRC_COUNT(next));
+        }
+    }
+    return last;
+}
+
+static int brc_refcount(obj_t* p_hdr)
+{
+    int shared = __atomic_load_n(&p_hdr->shared, __ATOMIC_RELAXED);
+    int count = BRC_COUNT(shared);
+    if (0 == (shared & BRC_MERGED))
+        count += p_hdr->refcount;
+    return count;
+}
+#endif
+
+static void* obj_init(obj_t* p_obj, size_t size, destructor_t p_destruct_fn, const char* name, const char* file)
 {
-    obj_t* p_obj = (obj_t*)malloc(sizeof(obj_t) + size);
     p_obj->refcount = 1;
-    p_obj->p_finalize = p_destruct_fn;
+#if (MEM_BIASED_REFCOUNT > 0)
+    brc_init(p_obj);
+#endif
+    obj_set_finalizer(p_obj, p_destruct_fn);
+#if (LEAK_DETECT_LEVEL > 1)
+    /* Arena objects are reclaimed in bulk so they only count in the totals */
+    stats_allocated(p_obj, size, (p_obj->flags & OBJ_ARENA) ? NO_TYPE : stats_type(p_destruct_fn, name, file));
+#elif (LEAK_DETECT_LEVEL > 0)
+    (void)name;
+    (void)file;
+    stats_allocated(p_obj, size, NO_TYPE);
+#else
+    (void)size;
+    (void)name;
+    (void)file;
+#endif
 #if (LEAK_DETECT_LEVEL > 0)
-    Num_Allocations++;
     /* If we haven't already, register an exit handler that will printout the
      * unfreed objects before the program quits */
     if(!Handler_Registered)
@@ -46,41 +976,466 @@ void* mem_allocate(size_t size, destructor_t p_destruct_fn)
     return (void*)(p_obj+1);
 }
 
-int mem_refcount(void* p_obj)
+void* (mem_allocate)(size_t size, destructor_t p_destruct_fn)
+{
+    return mem_allocate_at(size, p_destruct_fn, "mem_allocate", __FILE__);
+}
+
+void* mem_allocate_at(size_t size, destructor_t p_destruct_fn, const char* name, const char* file)
+{
+    obj_t* p_obj;
+    if (NULL != Mem_Arena) {
+        p_obj = arena_allocate(Mem_Arena, size, 0, p_destruct_fn);
+    } else {
+        p_obj = obj_allocate(size);
+    }
+    return obj_init(p_obj, size, p_destruct_fn, name, file);
+}
+
+void* (mem_allocate_aligned)(size_t size, size_t align, destructor_t p_destruct_fn)
+{
+    return mem_allocate_aligned_at(size, align, p_destruct_fn, "mem_allocate_aligned", __FILE__);
+}
+
+void* mem_allocate_aligned_at(size_t size, size_t align, destructor_t p_destruct_fn, const char* name, const char* file)
+{
+    obj_t* p_obj;
+    assert((0 != align) && (0 == (align & (align - 1))));
+    if (NULL != Mem_Arena)
+        p_obj = arena_allocate(Mem_Arena, size, align, p_destruct_fn);
+    else
+        p_obj = obj_allocate_aligned(size, align);
+    return obj_init(p_obj, size, p_destruct_fn, name, file);
+}
+
+mem_arena_t* mem_arena_new(size_t chunk_size)
+{
+    /* The arena itself always comes from the heap so that it can be released
+     * while an enclosing arena is still active */
+    obj_t* p_obj = obj_allocate(sizeof(mem_arena_t));
+    mem_arena_t* p_arena;
+    p_arena = (mem_arena_t*)obj_init(p_obj, sizeof(mem_arena_t), arena_free, "arena_free", __FILE__);
+    p_arena->p_chunks    = NULL;
+    p_arena->p_next      = NULL;
+    p_arena->p_end       = NULL;
+    p_arena->chunk_size  = (0 == chunk_size) ? MEM_ARENA_CHUNK_SIZE : chunk_size;
+    p_arena->p_finalize  = NULL;
+    p_arena->num_objects = 0;
+    p_arena->num_bytes   = 0;
+    p_arena->p_outer     = NULL;
+    return p_arena;
+}
+
+void mem_arena_enter(mem_arena_t* p_arena)
+{
+    assert(NULL != p_arena);
+    p_arena->p_outer = Mem_Arena;
+    Mem_Arena = p_arena;
+}
+
+void mem_arena_exit(mem_arena_t* p_arena)
+{
+    assert(Mem_Arena == p_arena);
+    Mem_Arena = p_arena->p_outer;
+    p_arena->p_outer = NULL;
+}
+
+mem_arena_t* mem_arena_current(void)
+{
+    return Mem_Arena;
+}
+
+/* The alignment a copy of the object must keep, which for over-aligned ones
+ * is at least the alignment the original was placed at */
+static size_t obj_alignment(obj_t* p_hdr)
+{
+    uintptr_t align = OBJ_ALIGNMENT;
+    if (0 != (p_hdr->flags & (OBJ_ALIGNED | OBJ_MAPPED))) {
+        align = (uintptr_t)(p_hdr+1) & (~(uintptr_t)(p_hdr+1) + 1u);
+        align = (align > 4096u) ? 4096u : align;
+    }
+    return (size_t)align;
+}
+
+void* mem_arena_promote(void* p_obj)
 {
     obj_t* p_hdr;
+    obj_t* p_copy;
+    arena_rec_t* p_rec;
+    void* p_ret = p_obj;
     assert(NULL != p_obj);
     p_hdr = (((obj_t*)p_obj)-1);
-    return p_hdr->refcount;
+    if (IS_IMMEDIATE(p_obj) || (0 == (p_hdr->flags & OBJ_ARENA))) {
+        mem_retain(p_obj);
+    } else {
+        p_rec = (((arena_rec_t*)p_hdr)-1);
+        p_copy = obj_allocate_aligned(p_rec->size, obj_alignment(p_hdr));
+        memcpy(p_copy+1, p_obj, p_rec->size);
+        /* The copy now owns whatever the original did, so the arena must not
+         * destruct the original as well */
+        p_ret = obj_init(p_copy, p_rec->size, obj_finalizer(p_hdr), "mem_arena_promote", __FILE__);
+        p_copy->flags |= (p_hdr->flags & OBJ_SHARED);
+        obj_set_finalizer(p_hdr, NULL);
+    }
+    return p_ret;
 }
 
-void* mem_retain(void* p_obj)
+#if (LEAK_DETECT_LEVEL > 0)
+static void stats_resized(obj_t* p_obj, size_t size)
+{
+    size_t live;
+    if (size > p_obj->size) {
+        live = STATS_ADD(Stats_Live_Bytes, size - p_obj->size);
+        if (live > __atomic_load_n(&Stats_Peak_Bytes, __ATOMIC_RELAXED))
+            __atomic_store_n(&Stats_Peak_Bytes, live, __ATOMIC_RELAXED);
+    } else {
+        STATS_SUB(Stats_Live_Bytes, p_obj->size - size);
+    }
+#if (LEAK_DETECT_LEVEL > 1)
+    if (NO_TYPE != p_obj->type) {
+        STATS_ADD(Stats_Types[p_obj->type].live_bytes, size);
+        STATS_SUB(Stats_Types[p_obj->type].live_bytes, p_obj->size);
+    }
+#endif
+    p_obj->size = size;
+}
+#endif
+
+/* Moves a heap object into a new block, header and all */
+static obj_t* obj_move(obj_t* p_hdr, size_t old_size, size_t size)
+{
+    obj_t* p_new = obj_allocate_aligned(size, obj_alignment(p_hdr));
+    obj_t hdr = *p_hdr;
+    hdr.pool  = p_new->pool;
+    hdr.flags = p_new->flags | (p_hdr->flags & OBJ_SHARED);
+    memcpy(p_new+1, p_hdr+1, (old_size < size) ? old_size : size);
+    *p_new = hdr;
+    obj_free(p_hdr);
+    return p_new;
+}
+
+/* Resizes a heap object the caller holds the only reference to */
+static obj_t* obj_reallocate(obj_t* p_hdr, size_t size)
+{
+#if (MEM_BIASED_REFCOUNT > 0)
+    /* The header must not be waiting in an inbox when it moves */
+    if ((NULL != Brc_Self) && __atomic_load_n(&Brc_Self->pending, __ATOMIC_RELAXED))
+        brc_process_inbox(Brc_Self);
+    assert(0 == (__atomic_load_n(&p_hdr->shared, __ATOMIC_RELAXED) & BRC_QUEUED));
+#endif
+#if (MEM_MMAP_THRESHOLD > 0)
+    if (0 != (p_hdr->flags & OBJ_MAPPED)) {
+        p_hdr = mapped_resize(p_hdr, size);
+    } else
+#endif
+    if (0 != (p_hdr->flags & OBJ_ALIGNED)) {
+        p_hdr = obj_move(p_hdr, ((size_t*)p_hdr)[-2], size);
+#if (MEM_SLAB_ALLOCATOR > 0)
+    } else if (0 != p_hdr->pool) {
+        p_hdr = obj_move(p_hdr, p_hdr->pool * SLAB_GRANULE, size);
+#endif
+#if (MEM_MMAP_THRESHOLD > 0) && defined(__GLIBC__)
+    } else if ((sizeof(obj_t) + size) >= MEM_MMAP_THRESHOLD) {
+        /* Copied once straight into the mapping. The old size is not recorded,
+         * so the copy covers all of the block malloc says is usable. */
+        p_hdr = obj_move(p_hdr, malloc_usable_size(p_hdr) - sizeof(obj_t), size);
+#endif
+    } else {
+        p_hdr = (obj_t*)realloc(p_hdr, sizeof(obj_t) + size);
+        assert(NULL != p_hdr);
+#if (MEM_MMAP_THRESHOLD > 0) && !defined(__GLIBC__)
+        /* Grown in place first, as the old size is not recorded */
+        if ((sizeof(obj_t) + size) >= MEM_MMAP_THRESHOLD)
+            p_hdr = obj_move(p_hdr, size, size);
+#endif
+    }
+#if (LEAK_DETECT_LEVEL > 0)
+    stats_resized(p_hdr, size);
+#endif
+    return p_hdr;
+}
+
+void* (mem_reallocate)(void* p_obj, size_t size)
+{
+    return mem_reallocate_at(p_obj, size, "mem_reallocate", __FILE__);
+}
+
+void* mem_reallocate_at(void* p_obj, size_t size, const char* name, const char* file)
 {
     obj_t* p_hdr;
+    arena_rec_t* p_rec;
+    void* p_ret;
+    if (NULL == p_obj) {
+        p_ret = obj_init(obj_allocate(size), size, NULL, name, file);
+    } else {
+        assert(!IS_IMMEDIATE(p_obj));
+        p_hdr = (((obj_t*)p_obj)-1);
+        if (0 != (p_hdr->flags & OBJ_ARENA)) {
+            /* Copied out like mem_arena_promote, with the arena left to
+             * reclaim the original */
+            p_rec = (((arena_rec_t*)p_hdr)-1);
+            p_ret = obj_init(obj_allocate_aligned(size, obj_alignment(p_hdr)), size, obj_finalizer(p_hdr), name, file);
+            memcpy(p_ret, p_obj, (p_rec->size < size) ? p_rec->size : size);
+            (((obj_t*)p_ret)-1)->flags |= (p_hdr->flags & OBJ_SHARED);
+            obj_set_finalizer(p_hdr, NULL);
+        } else {
+            assert(1 == mem_refcount(p_obj));
+            p_ret = (void*)(obj_reallocate(p_hdr, size)+1);
+        }
+    }
+    return p_ret;
+}
+
+static bool obj_immortal(obj_t* p_hdr)
+{
+#if (MEM_BIASED_REFCOUNT > 0)
+    /* Only the shared count is safe to read from any thread */
+    return (__atomic_load_n(&p_hdr->shared, __ATOMIC_RELAXED) >= IMMORTAL_THRESHOLD);
+#else
+    return (__atomic_load_n(&p_hdr->refcount, __ATOMIC_RELAXED) >= IMMORTAL_THRESHOLD);
+#endif
+}
+
+#if (MEM_BIASED_REFCOUNT == 0)
+static bool obj_shared(obj_t* p_hdr)
+{
+#if (MEM_ATOMIC_REFCOUNT > 0)
+    (void)p_hdr;
+    return true;
+#else
+    return (0 != (p_hdr->flags & OBJ_SHARED));
+#endif
+}
+#endif
+
+/* Drops count references and returns whether they were the last ones */
+static bool obj_unref(obj_t* p_hdr, int count)
+{
+    bool last;
+#if (MEM_BIASED_REFCOUNT > 0)
+    last = brc_unref(p_hdr, count);
+#else
+    if (obj_shared(p_hdr)) {
+        last = (__atomic_fetch_sub(&p_hdr->refcount, count, __ATOMIC_RELEASE) <= count);
+        /* Make every other thread's writes visible before finalizing */
+        if (last)
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } else {
+        p_hdr->refcount -= count;
+        last = (p_hdr->refcount < 1);
+    }
+#endif
+    return last;
+}
+
+int mem_refcount(void* p_obj)
+{
+    obj_t* p_hdr;
+    int refcount = 1;
     assert(NULL != p_obj);
-    p_hdr = (((obj_t*)p_obj)-1);
-    p_hdr->refcount += 1;
+    if (!IS_IMMEDIATE(p_obj)) {
+        p_hdr = (((obj_t*)p_obj)-1);
+#if (MEM_BIASED_REFCOUNT > 0)
+        refcount = brc_refcount(p_hdr);
+#else
+        refcount = obj_shared(p_hdr) ? __atomic_load_n(&p_hdr->refcount, __ATOMIC_RELAXED)
+                                     : p_hdr->refcount;
+#endif
+    }
+    return refcount;
+}
+
+static void obj_retain(obj_t* p_hdr, int count)
+{
+    /* Saturated counts are left alone */
+    if (!obj_immortal(p_hdr)) {
+#if (MEM_BIASED_REFCOUNT > 0)
+        brc_retain(p_hdr, count);
+#else
+        if (obj_shared(p_hdr))
+            __atomic_fetch_add(&p_hdr->refcount, count, __ATOMIC_RELAXED);
+        else
+            p_hdr->refcount += count;
+#endif
+    }
+}
+
+void* mem_retain(void* p_obj)
+{
+    assert(NULL != p_obj);
+    if (!IS_IMMEDIATE(p_obj))
+        obj_retain((((obj_t*)p_obj)-1), 1);
     return p_obj;
 }
 
+void* mem_retain_n(void* p_obj, size_t count)
+{
+    assert(NULL != p_obj);
+    assert(count < IMMORTAL_THRESHOLD);
+    if (!IS_IMMEDIATE(p_obj) && (count > 0))
+        obj_retain((((obj_t*)p_obj)-1), (int)count);
+    return p_obj;
+}
+
+void mem_retain_array(void** p_objs, size_t count)
+{
+    size_t i = 0;
+    size_t run;
+    assert((NULL != p_objs) || (0 == count));
+    while (i < count) {
+        void* p_obj = p_objs[i];
+        for (run = 1; ((i + run) < count) && (p_objs[i + run] == p_obj) && (run < (INT_MAX / 4)); run++) { }
+        i += run;
+        if (NULL != p_obj)
+            mem_retain_n(p_obj, run);
+    }
+}
+
+static void release_enqueue(obj_t* p_hdr)
+{
+    release_queue_t* p_queue = &Release_Queue;
+    if (NULL == p_queue->p_objs) {
+        p_queue->p_objs   = p_queue->inline_objs;
+        p_queue->capacity = RELEASE_QUEUE_INLINE;
+    } else if (p_queue->count == p_queue->capacity) {
+        obj_t** p_spill = (p_queue->p_objs == p_queue->inline_objs) ? NULL : p_queue->p_objs;
+        p_spill = (obj_t**)realloc(p_spill, sizeof(obj_t*) * p_queue->capacity * 2);
+        assert(NULL != p_spill);
+        if (p_queue->p_objs == p_queue->inline_objs)
+            memcpy(p_spill, p_queue->inline_objs, sizeof(obj_t*) * p_queue->count);
+        p_queue->p_objs    = p_spill;
+        p_queue->capacity *= 2;
+    }
+    p_queue->p_objs[p_queue->count++] = p_hdr;
+}
+
+static size_t release_drain(size_t budget)
+{
+    release_queue_t* p_queue = &Release_Queue;
+    size_t freed = 0;
+    if (!p_queue->draining) {
+        p_queue->draining = true;
+        /* Processed last in first out so the queue only grows with the depth
+         * of the object graph being torn down, not with its breadth */
+        while ((p_queue->count > 0) && (freed < budget)) {
+            obj_t* p_hdr = p_queue->p_objs[--p_queue->count];
+            destructor_t p_finalize = obj_finalizer(p_hdr);
+            if(p_finalize)
+            {
+                p_finalize(p_hdr+1);
+            }
+            obj_free(p_hdr);
+            freed++;
+        }
+        if ((0 == p_queue->count) && (p_queue->p_objs != p_queue->inline_objs)) {
+            free(p_queue->p_objs);
+            p_queue->p_objs   = p_queue->inline_objs;
+            p_queue->capacity = RELEASE_QUEUE_INLINE;
+        }
+        p_queue->draining = false;
+    }
+    return p_queue->count;
+}
+
+/* Queues an object whose last reference is gone for destruction */
+static void obj_enqueue(obj_t* p_hdr)
+{
+#if (LEAK_DETECT_LEVEL > 0)
+    stats_freed(1, p_hdr->size, p_hdr->type);
+#endif
+    release_enqueue(p_hdr);
+}
+
+/* Destructs and frees an object whose last reference is gone */
+static void obj_reclaim(obj_t* p_hdr)
+{
+    obj_enqueue(p_hdr);
+    if (!Release_Queue.deferred)
+        release_drain(SIZE_MAX);
+}
+
 void mem_release(void* p_obj)
 {
     obj_t* p_hdr;
-    if (NULL != p_obj) {
+    if ((NULL != p_obj) && !IS_IMMEDIATE(p_obj)) {
         p_hdr = (((obj_t*)p_obj)-1);
-        p_hdr->refcount -= 1;
-        if(p_hdr->refcount < 1)
-        {
-            #if (LEAK_DETECT_LEVEL > 0)
-            Num_Allocations--;
-            #endif
-            if(p_hdr->p_finalize)
-            {
-                p_hdr->p_finalize(p_obj);
+        /* Arena objects are reclaimed all at once with their arena */
+        if(0 == (p_hdr->flags & OBJ_ARENA) && !obj_immortal(p_hdr) && obj_unref(p_hdr, 1))
+            obj_reclaim(p_hdr);
+    }
+}
+
+void mem_release_array(void** p_objs, size_t count)
+{
+    size_t i = 0;
+    size_t run;
+    obj_t* p_hdr;
+    assert((NULL != p_objs) || (0 == count));
+    while (i < count) {
+        void* p_obj = p_objs[i];
+        /* Repeats of the same object are released with a single update */
+        for (run = 1; ((i + run) < count) && (p_objs[i + run] == p_obj) && (run < (INT_MAX / 4)); run++) { }
+        i += run;
+        if ((NULL != p_obj) && !IS_IMMEDIATE(p_obj)) {
+            p_hdr = (((obj_t*)p_obj)-1);
+            if(0 == (p_hdr->flags & OBJ_ARENA) && !obj_immortal(p_hdr) && obj_unref(p_hdr, (int)run)) {
+                /* Destructors run in batches once the inline queue fills, so
+                 * long arrays do not grow the queue onto the heap */
+                obj_enqueue(p_hdr);
+                if (!Release_Queue.deferred && (Release_Queue.count >= RELEASE_QUEUE_INLINE))
+                    release_drain(SIZE_MAX);
             }
-            free(p_hdr);
         }
     }
+    if (!Release_Queue.deferred)
+        release_drain(SIZE_MAX);
+}
+
+void mem_defer(bool enabled)
+{
+    Release_Queue.deferred = enabled;
+}
+
+size_t mem_drain(size_t budget)
+{
+    return release_drain(budget);
+}
+
+void* mem_share(void* p_obj)
+{
+    obj_t* p_hdr;
+    assert(NULL != p_obj);
+    if (!IS_IMMEDIATE(p_obj)) {
+        p_hdr = (((obj_t*)p_obj)-1);
+        p_hdr->flags |= OBJ_SHARED;
+    }
+    return p_obj;
+}
+
+void* mem_make_immortal(void* p_obj)
+{
+    obj_t* p_hdr;
+    assert(NULL != p_obj);
+    if (!IS_IMMEDIATE(p_obj)) {
+        p_hdr = (((obj_t*)p_obj)-1);
+        if (0 != (p_hdr->flags & OBJ_ARENA)) {
+            /* The arena would reclaim it regardless, so it lives on a copy */
+            p_obj = mem_arena_promote(p_obj);
+            p_hdr = (((obj_t*)p_obj)-1);
+        }
+        if (!obj_immortal(p_hdr)) {
+#if (LEAK_DETECT_LEVEL > 0)
+            /* It will never be reclaimed so it is not reported as a leak */
+            stats_freed(1, p_hdr->size, p_hdr->type);
+#endif
+#if (MEM_BIASED_REFCOUNT > 0)
+            __atomic_store_n(&p_hdr->shared, IMMORTAL_REFCOUNT, __ATOMIC_RELEASE);
+#else
+            __atomic_store_n(&p_hdr->refcount, IMMORTAL_REFCOUNT, __ATOMIC_RELEASE);
+#endif
+        }
+    }
+    return p_obj;
 }
 
 void mem_swap(void** loc, void* obj)
@@ -92,14 +1447,141 @@ void mem_swap(void** loc, void* obj)
 
 void* mem_box(intptr_t val)
 {
-    box_t* p_box = (box_t*)mem_allocate(sizeof(box_t), NULL);
-    p_box->val = val;
-    return (void*)p_box;
+    box_t* p_box;
+    void* p_ret;
+#if (MEM_TAGGED_INTEGERS > 0)
+    if ((val >= MEM_IMMEDIATE_MIN) && (val <= MEM_IMMEDIATE_MAX)) {
+        p_ret = (void*)(((uintptr_t)val << 1) | 1u);
+    } else
+#endif
+    {
+        p_box = (box_t*)mem_allocate(sizeof(box_t), NULL);
+        p_box->val = val;
+        p_ret = (void*)p_box;
+    }
+    return p_ret;
 }
 
 intptr_t mem_unbox(void* p_box)
 {
     assert(NULL != p_box);
-    return ((box_t*)p_box)->val;
+    /* Dropping the tag leaves twice the value, which divides back exactly */
+    return IS_IMMEDIATE(p_box) ? ((intptr_t)((uintptr_t)p_box - 1u) / 2)
+                               : ((box_t*)p_box)->val;
+}
+
+void mem_stats(mem_stats_t* p_stats)
+{
+    assert(NULL != p_stats);
+    memset(p_stats, 0, sizeof(mem_stats_t));
+#if (LEAK_DETECT_LEVEL > 0)
+    {
+        double now = stats_now();
+        double elapsed = now - Stats_Last_Time;
+        p_stats->live_bytes   = __atomic_load_n(&Stats_Live_Bytes, __ATOMIC_RELAXED);
+        p_stats->peak_bytes   = __atomic_load_n(&Stats_Peak_Bytes, __ATOMIC_RELAXED);
+        p_stats->allocations  = __atomic_load_n(&Stats_Allocations, __ATOMIC_RELAXED);
+        p_stats->frees        = __atomic_load_n(&Stats_Frees, __ATOMIC_RELAXED);
+        p_stats->live_objects = p_stats->allocations - p_stats->frees;
+        if ((Stats_Last_Time > 0) && (elapsed > 0)) {
+            p_stats->allocation_rate = (double)(p_stats->allocations - Stats_Last_Allocations) / elapsed;
+            p_stats->free_rate = (double)(p_stats->frees - Stats_Last_Frees) / elapsed;
+        }
+        Stats_Last_Time = now;
+        Stats_Last_Allocations = p_stats->allocations;
+        Stats_Last_Frees = p_stats->frees;
+    }
+#endif
+}
+
+size_t mem_type_stats(mem_type_stats_t* p_types, size_t max_types)
+{
+    size_t count = 0;
+#if (LEAK_DETECT_LEVEL > 1)
+    size_t i;
+    for (i = 0; (i < MEM_STATS_MAX_TYPES) && (count < max_types); i++) {
+        mem_type_stats_t* p_type = &Stats_Types[i];
+        if (NULL != __atomic_load_n(&p_type->file, __ATOMIC_ACQUIRE)) {
+            p_types[count].p_finalize   = p_type->p_finalize;
+            p_types[count].name         = p_type->name;
+            p_types[count].file         = p_type->file;
+            p_types[count].live_objects = __atomic_load_n(&p_type->live_objects, __ATOMIC_RELAXED);
+            p_types[count].live_bytes   = __atomic_load_n(&p_type->live_bytes, __ATOMIC_RELAXED);
+            p_types[count].allocations  = __atomic_load_n(&p_type->allocations, __ATOMIC_RELAXED);
+            count++;
+        }
+    }
+#else
+    (void)p_types;
+    (void)max_types;
+#endif
+    return count;
+}
+
+static void stats_write(int fd, char* buf, int len)
+{
+    if (len > 0)
+        (void)!write(fd, buf, (size_t)len);
+}
+
+void mem_stats_dump(int fd)
+{
+    char buf[256];
+    mem_stats_t stats;
+    mem_stats(&stats);
+    stats_write(fd, buf, snprintf(buf, sizeof(buf),
+        "\nMemory Statistics"
+        "\n-----------------"
+        "\nLive Objects: %zu"
+        "\nLive Bytes:   %zu"
+        "\nPeak Bytes:   %zu"
+        "\nAllocations:  %zu (%.0f/sec)"
+        "\nFrees:        %zu (%.0f/sec)\n",
+        stats.live_objects, stats.live_bytes, stats.peak_bytes,
+        stats.allocations, stats.allocation_rate, stats.frees, stats.free_rate));
+#if (LEAK_DETECT_LEVEL > 1)
+    {
+        mem_type_stats_t type;
+        size_t i;
+        stats_write(fd, buf, snprintf(buf, sizeof(buf), "\n%12s %12s %12s  %s\n",
+                                      "Live Objects", "Live Bytes", "Allocations", "Type"));
+        for (i = 0; i < MEM_STATS_MAX_TYPES; i++) {
+            if (NULL != __atomic_load_n(&Stats_Types[i].file, __ATOMIC_ACQUIRE)) {
+                type = Stats_Types[i];
+                stats_write(fd, buf, snprintf(buf, sizeof(buf), "%12zu %12zu %12zu  %s (%s)\n",
+                    type.live_objects, type.live_bytes, type.allocations,
+                    (NULL == type.name) ? "?" : ((type.name[0] == '&') ? type.name+1 : type.name),
+                    type.file));
+            }
+        }
+    }
+#endif
 }
 
+static void stats_dump_handler(int signum)
+{
+    (void)signum;
+    Stats_Dump_Requested = 1;
+}
+
+static void stats_dump_exit_handler(void)
+{
+    mem_stats_dump(STDERR_FILENO);
+}
+
+void mem_stats_dump_on_signal(int signum)
+{
+    signal(signum, stats_dump_handler);
+}
+
+void mem_stats_dump_on_exit(void)
+{
+    atexit(stats_dump_exit_handler);
+}
+
+void mem_stats_poll(void)
+{
+    /* Only one of several racing threads takes the request */
+    if (Stats_Dump_Requested && __atomic_exchange_n(&Stats_Dump_Requested, 0, __ATOMIC_RELAXED))
+        mem_stats_dump(STDERR_FILENO);
+}
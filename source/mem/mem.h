@@ -14,15 +14,149 @@ extern "C" {
 /** A function pointer for object destructors */
 typedef void (*destructor_t)(void* p_val);
 
-/** Unless otherwise specified, no leak detection will occur */
+/** A region that objects can be allocated from and then reclaimed in bulk */
+typedef struct mem_arena_t mem_arena_t;
+
+/** Unless otherwise specified, no leak detection will occur. Level 1 keeps
+ *  running allocation totals and warns about leaks at exit. Level 2 also
+ *  breaks the totals down by destructor and allocating source file. */
 #ifndef LEAK_DETECT_LEVEL
 #define LEAK_DETECT_LEVEL 0
 #endif
 
+/** The number of distinct types tracked by the level 2 statistics */
+#ifndef MEM_STATS_MAX_TYPES
+#define MEM_STATS_MAX_TYPES 256
+#endif
+
+/** Allocation totals reported by mem_stats */
+typedef struct {
+    size_t live_objects;    /**< Objects allocated but not yet reclaimed */
+    size_t live_bytes;      /**< Payload bytes held by the live objects */
+    size_t peak_bytes;      /**< The highest value live_bytes has reached */
+    size_t allocations;     /**< Objects allocated since the program started */
+    size_t frees;           /**< Objects reclaimed since the program started */
+    double allocation_rate; /**< Allocations per second since the last call */
+    double free_rate;       /**< Frees per second since the last call */
+} mem_stats_t;
+
+/** Allocation totals for a single type reported by mem_type_stats */
+typedef struct {
+    destructor_t p_finalize; /**< The destructor shared by objects of the type */
+    const char* name;        /**< The destructor as written where allocated */
+    const char* file;        /**< The source file that allocated the objects */
+    size_t live_objects;     /**< Objects allocated but not yet reclaimed */
+    size_t live_bytes;       /**< Payload bytes held by the live objects */
+    size_t allocations;      /**< Objects allocated since the program started */
+} mem_type_stats_t;
+
+/** Unless otherwise specified, every object is allocated directly with malloc */
+#ifndef MEM_SLAB_ALLOCATOR
+#define MEM_SLAB_ALLOCATOR 0
+#endif
+
+/** Unless otherwise specified, small integers are boxed as tagged immediates
+ *  that need no allocation */
+#ifndef MEM_TAGGED_INTEGERS
+#define MEM_TAGGED_INTEGERS 1
+#endif
+
+/** Unless otherwise specified, each object header holds its destructor
+ *  pointer directly. The compact header instead stores an index into a table
+ *  of destructors, halving the header to 8 bytes at the cost of payloads only
+ *  being 8-byte aligned. */
+#ifndef MEM_COMPACT_HEADER
+#define MEM_COMPACT_HEADER 0
+#endif
+
+/** The number of distinct destructors the compact header can refer to. Must
+ *  be a power of two no larger than 65536. */
+#ifndef MEM_DESTRUCTOR_TABLE_SIZE
+#define MEM_DESTRUCTOR_TABLE_SIZE 4096
+#endif
+
+/** The size of a cache line, for padding and aligning concurrent structures */
+#ifndef MEM_CACHE_LINE_SIZE
+#define MEM_CACHE_LINE_SIZE 64
+#endif
+
+/** The range of values that mem_box can return as tagged immediates */
+#define MEM_IMMEDIATE_MIN (INTPTR_MIN / 2)
+#define MEM_IMMEDIATE_MAX (INTPTR_MAX / 2)
+
+/** The default number of bytes in each chunk of a memory arena */
+#ifndef MEM_ARENA_CHUNK_SIZE
+#define MEM_ARENA_CHUNK_SIZE 65536
+#endif
+
+/** Unless otherwise specified, only objects passed to mem_share will use
+ *  atomic reference counting */
+#ifndef MEM_ATOMIC_REFCOUNT
+#define MEM_ATOMIC_REFCOUNT 0
+#endif
+
+/** Unless otherwise specified, objects not passed to mem_share may only be
+ *  retained and released by one thread at a time. Biased reference counting
+ *  makes every object safe to share: the allocating thread counts its own
+ *  references without atomics and other threads count theirs atomically. */
+#ifndef MEM_BIASED_REFCOUNT
+#define MEM_BIASED_REFCOUNT 0
+#endif
+
+#if (MEM_BIASED_REFCOUNT > 0) && (MEM_ATOMIC_REFCOUNT > 0)
+#error "MEM_BIASED_REFCOUNT and MEM_ATOMIC_REFCOUNT are mutually exclusive"
+#endif
+
+/** The number of threads that can own objects under biased reference
+ *  counting. Objects allocated by later threads are counted atomically. */
+#ifndef MEM_BRC_MAX_THREADS
+#define MEM_BRC_MAX_THREADS 4096
+#endif
+
+/** The largest object size (in bytes) that will be served from a slab */
+#ifndef MEM_SLAB_MAX_SIZE
+#define MEM_SLAB_MAX_SIZE 128
+#endif
+
+/** The number of bytes requested from malloc each time a slab runs dry */
+#ifndef MEM_SLAB_CHUNK_SIZE
+#define MEM_SLAB_CHUNK_SIZE 65536
+#endif
+
+/** The number of free blocks of one size class each thread caches in a
+ *  magazine before trading it with the other threads */
+#ifndef MEM_SLAB_MAGAZINE_SIZE
+#define MEM_SLAB_MAGAZINE_SIZE 64
+#endif
+
+/** Objects of at least this many bytes get a memory mapping of their own, so
+ *  that mem_reallocate can grow them without copying. Zero disables this. */
+#ifndef MEM_MMAP_THRESHOLD
+#define MEM_MMAP_THRESHOLD (256u * 1024u)
+#endif
+
+/** Unless otherwise specified, mapped objects use whatever pages the kernel
+ *  chooses. Enabling this asks for transparent huge pages on mappings of at
+ *  least MEM_HUGE_PAGE_SIZE bytes, which are placed on a huge page boundary. */
+#ifndef MEM_HUGE_PAGES
+#define MEM_HUGE_PAGES 0
+#endif
+
+/** The size of a transparent huge page */
+#ifndef MEM_HUGE_PAGE_SIZE
+#define MEM_HUGE_PAGE_SIZE (2u * 1024u * 1024u)
+#endif
+
 /**
  * @brief Allocates a new reference counted object of the given size which will
  *        be destructed with the given function before it's memory is reclaimed.
  *
+ * When MEM_SLAB_ALLOCATOR is enabled, objects no larger than MEM_SLAB_MAX_SIZE
+ * are carved out of per size class slabs and recycled through per thread
+ * magazines rather than being returned to malloc. Allocating and releasing
+ * on one thread takes no locks, and blocks released on other threads are
+ * passed back to the rest a magazine at a time.
+ *
  * @param size The number of bytes to allocate for this object.
  * @param p_destruct_fn The function to call when reclaiming this object.
  *
@@ -30,6 +164,95 @@ typedef void (*destructor_t)(void* p_val);
  */
 void* mem_allocate(size_t size, destructor_t p_destruct_fn);
 
+/**
+ * @brief Allocates a new reference counted object, recording the allocation
+ *        site for the per type statistics.
+ *
+ * When LEAK_DETECT_LEVEL is 2 or higher, mem_allocate is redirected here so
+ * that every call site is recorded without modification.
+ *
+ * @param size The number of bytes to allocate for this object.
+ * @param p_destruct_fn The function to call when reclaiming this object.
+ * @param name The name of the destructor at the allocation site.
+ * @param file The source file of the allocation site.
+ *
+ * @return Pointer to the newly allocated object
+ */
+void* mem_allocate_at(size_t size, destructor_t p_destruct_fn, const char* name, const char* file);
+
+/**
+ * @brief Allocates a new reference counted object whose payload starts on a
+ *        multiple of the given alignment.
+ *
+ * The object is retained, released and shared exactly like one returned by
+ * mem_allocate. Inside an arena scope it is allocated from the arena.
+ *
+ * @param size The number of bytes to allocate for this object.
+ * @param align The alignment of the payload in bytes. Must be a power of two,
+ *              eg. MEM_CACHE_LINE_SIZE to avoid false sharing.
+ * @param p_destruct_fn The function to call when reclaiming this object.
+ *
+ * @return Pointer to the newly allocated object
+ */
+void* mem_allocate_aligned(size_t size, size_t align, destructor_t p_destruct_fn);
+
+/**
+ * @brief Allocates a new aligned reference counted object, recording the
+ *        allocation site for the per type statistics.
+ *
+ * When LEAK_DETECT_LEVEL is 2 or higher, mem_allocate_aligned is redirected
+ * here so that every call site is recorded without modification.
+ *
+ * @param size The number of bytes to allocate for this object.
+ * @param align The alignment of the payload in bytes.
+ * @param p_destruct_fn The function to call when reclaiming this object.
+ * @param name The name of the destructor at the allocation site.
+ * @param file The source file of the allocation site.
+ *
+ * @return Pointer to the newly allocated object
+ */
+void* mem_allocate_aligned_at(size_t size, size_t align, destructor_t p_destruct_fn, const char* name, const char* file);
+
+/**
+ * @brief Changes the size of an object, keeping its contents up to the lesser
+ *        of the old and new sizes.
+ *
+ * The caller must hold the only reference to the object, as it may move.
+ * Mapped objects are resized with mremap so their contents are never copied,
+ * and other objects crossing MEM_MMAP_THRESHOLD are moved into a mapping.
+ * The result always lives on the heap, so an arena object is copied out of
+ * its arena, and passing NULL allocates a new heap object with no destructor
+ * even inside an arena scope. Over-aligned objects keep their alignment.
+ *
+ * @param p_obj The object to resize, or NULL.
+ * @param size The new size of the object in bytes.
+ *
+ * @return Pointer to the resized object
+ */
+void* mem_reallocate(void* p_obj, size_t size);
+
+/**
+ * @brief Changes the size of an object, recording the allocation site of any
+ *        new object for the per type statistics.
+ *
+ * When LEAK_DETECT_LEVEL is 2 or higher, mem_reallocate is redirected here so
+ * that the buffers each source file allocates are counted separately.
+ *
+ * @param p_obj The object to resize, or NULL.
+ * @param size The new size of the object in bytes.
+ * @param name The name to record for a new object.
+ * @param file The source file of the allocation site.
+ *
+ * @return Pointer to the resized object
+ */
+void* mem_reallocate_at(void* p_obj, size_t size, const char* name, const char* file);
+
+#if (LEAK_DETECT_LEVEL > 1)
+#define mem_allocate(size, fn) mem_allocate_at((size), (fn), #fn, __FILE__)
+#define mem_allocate_aligned(size, align, fn) mem_allocate_aligned_at((size), (align), (fn), #fn, __FILE__)
+#define mem_reallocate(p_obj, size) mem_reallocate_at((p_obj), (size), "mem_reallocate", __FILE__)
+#endif
+
 /**
  * @brief Returns the reference count for the given object.
  *
@@ -46,6 +269,26 @@ int mem_refcount(void* p_obj);
  */
 void* mem_retain(void* p_obj);
 
+/**
+ * @brief Increments the reference count for the given object several times
+ *        with a single update.
+ *
+ * @param p_obj The object to be retained.
+ * @param count The number of references to add.
+ */
+void* mem_retain_n(void* p_obj, size_t count);
+
+/**
+ * @brief Retains every object in an array.
+ *
+ * Consecutive entries holding the same object are retained with a single
+ * update. NULL entries are skipped.
+ *
+ * @param p_objs The objects to be retained.
+ * @param count  The number of entries in p_objs.
+ */
+void mem_retain_array(void** p_objs, size_t count);
+
 /**
  * @brief Decrements the reference count for a given object.
  *
@@ -53,6 +296,126 @@ void* mem_retain(void* p_obj);
  */
 void mem_release(void* p_obj);
 
+/**
+ * @brief Releases every object in an array.
+ *
+ * Consecutive entries holding the same object are released with a single
+ * update and the destructors of objects reclaimed along the way run in
+ * batches rather than one per release. NULL entries are skipped.
+ *
+ * @param p_objs The objects to be released.
+ * @param count  The number of entries in p_objs.
+ */
+void mem_release_array(void** p_objs, size_t count);
+
+/**
+ * @brief Enables or disables deferred reclamation on the calling thread.
+ *
+ * Objects whose last reference is released are queued and destructed
+ * iteratively, so tearing down a long list or a deep tree does not recurse.
+ * Normally the queue is emptied before the outermost mem_release returns.
+ * While deferred reclamation is enabled the queue is only processed by
+ * mem_drain, allowing the work to be spread out over time.
+ *
+ * @param enabled Whether reclamation should be deferred.
+ */
+void mem_defer(bool enabled);
+
+/**
+ * @brief Destructs and frees objects waiting in the calling thread's
+ *        reclamation queue.
+ *
+ * @param budget The maximum number of objects to free.
+ *
+ * @return The number of objects still waiting to be freed.
+ */
+size_t mem_drain(size_t budget);
+
+/**
+ * @brief Marks the object as shared between threads.
+ *
+ * The reference count of a shared object is updated atomically so it may be
+ * retained and released from any thread. Objects it references must either be
+ * shared as well or owned exclusively by it. When MEM_ATOMIC_REFCOUNT or
+ * MEM_BIASED_REFCOUNT is enabled every object is already safe to share and
+ * this call has no effect.
+ *
+ * @param p_obj The object to share.
+ *
+ * @return The shared object.
+ */
+void* mem_share(void* p_obj);
+
+/**
+ * @brief Makes the given object immortal so that it is never reclaimed.
+ *
+ * The reference count is saturated, after which mem_retain and mem_release
+ * return without writing to the object. This keeps long lived objects that
+ * are retained from hot paths, possibly on many threads, off the cache lines
+ * of their users. Objects retained INT_MAX / 2 times saturate the same way.
+ * An arena object is first promoted to the heap and the copy is returned.
+ *
+ * @param p_obj The object to make immortal.
+ *
+ * @return The immortal object.
+ */
+void* mem_make_immortal(void* p_obj);
+
+/**
+ * @brief Creates a new, inactive memory arena.
+ *
+ * The arena is itself a reference counted object. Releasing the last
+ * reference reclaims every object allocated from it in one pass over its
+ * chunks, regardless of their reference counts. Only the destructors of
+ * arena objects are run, so that heap objects they reference are released.
+ *
+ * @param chunk_size The number of bytes to reserve at a time, or 0 to use
+ *                   MEM_ARENA_CHUNK_SIZE.
+ *
+ * @return Pointer to the new arena.
+ */
+mem_arena_t* mem_arena_new(size_t chunk_size);
+
+/**
+ * @brief Makes the arena the source of all objects allocated by this thread
+ *        until mem_arena_exit is called.
+ *
+ * Arenas may be nested. Retaining or releasing an object allocated from an
+ * arena has no effect on when it is reclaimed.
+ *
+ * @param p_arena The arena to enter.
+ */
+void mem_arena_enter(mem_arena_t* p_arena);
+
+/**
+ * @brief Restores the arena that was active before the given arena was
+ *        entered.
+ *
+ * @param p_arena The arena to exit. Must be the innermost active arena.
+ */
+void mem_arena_exit(mem_arena_t* p_arena);
+
+/**
+ * @brief Returns the innermost arena this thread has entered.
+ *
+ * @return The active arena, or NULL if objects come from the heap.
+ */
+mem_arena_t* mem_arena_current(void);
+
+/**
+ * @brief Copies an object out of its arena so that it outlives the arena.
+ *
+ * The heap copy takes ownership of everything the original referenced and
+ * the original will no longer be destructed. References the object holds to
+ * other arena objects are not followed; those must be promoted separately.
+ *
+ * @param p_obj The object to promote.
+ *
+ * @return A heap allocated reference owned by the caller. Objects that are not
+ *         in an arena are simply retained.
+ */
+void* mem_arena_promote(void* p_obj);
+
 /**
  * @brief Replaces the object reference in the given location with the new
  *        object releasing the old one.
@@ -66,6 +429,11 @@ void mem_swap(void** loc, void* obj);
  * @brief Create a reference counted box holding the given value so that it can
  *        be placed in a container.
  *
+ * When MEM_TAGGED_INTEGERS is enabled, values between MEM_IMMEDIATE_MIN and
+ * MEM_IMMEDIATE_MAX are encoded in the returned pointer itself (with its low
+ * bit set) and nothing is allocated. mem_retain and mem_release ignore such
+ * immediates and mem_refcount always reports a single reference for them.
+ *
  * @param val The value to be boxed.
  *
  * @return The pointer to the newly allocated box.
@@ -79,6 +447,60 @@ void* mem_box(intptr_t val);
  */
 intptr_t mem_unbox(void* p_box);
 
+/**
+ * @brief Retrieves the allocation totals.
+ *
+ * The totals are only gathered when LEAK_DETECT_LEVEL is 1 or higher and are
+ * all zero otherwise. Objects allocated from an arena are included.
+ *
+ * @param p_stats Where to store the totals.
+ */
+void mem_stats(mem_stats_t* p_stats);
+
+/**
+ * @brief Retrieves the allocation totals broken down by type.
+ *
+ * A type is the combination of a destructor and the source file that
+ * allocated the object. The breakdown is only gathered when LEAK_DETECT_LEVEL
+ * is 2 or higher and does not include objects allocated from an arena.
+ *
+ * @param p_types Array in which to store the per type totals.
+ * @param max_types The number of entries available in p_types.
+ *
+ * @return The number of entries that were filled in.
+ */
+size_t mem_type_stats(mem_type_stats_t* p_types, size_t max_types);
+
+/**
+ * @brief Writes a human readable summary of the allocation statistics.
+ *
+ * @param fd The file descriptor to write the summary to.
+ */
+void mem_stats_dump(int fd);
+
+/**
+ * @brief Dumps the allocation statistics to stderr whenever the given signal
+ *        is received.
+ *
+ * The handler only records the request, since writing the dump is not
+ * async-signal-safe. The dump is written by the next allocation when
+ * LEAK_DETECT_LEVEL is enabled, or by the next call to mem_stats_poll.
+ *
+ * @param signum The signal that triggers the dump (e.g. SIGUSR1).
+ */
+void mem_stats_dump_on_signal(int signum);
+
+/**
+ * @brief Writes the dump requested by a signal registered with
+ *        mem_stats_dump_on_signal, if one is pending.
+ */
+void mem_stats_poll(void);
+
+/**
+ * @brief Dumps the allocation statistics to stderr when the program exits.
+ */
+void mem_stats_dump_on_exit(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,22 @@ static int rbt_default_compare(void* env, void* v_a, void* v_b){
     return (a == b ? 0 : (a<b ? -1 : 1 ));
 }
 
+//trees without a comparator of their own all share one that is never freed
+static cmp_t* Default_Comparator = NULL;
+
+static cmp_t* rbt_default_comparator(void){
+    cmp_t* cmp = __atomic_load_n(&Default_Comparator, __ATOMIC_ACQUIRE);
+    if(NULL == cmp){
+        cmp_t* expected = NULL;
+        cmp = mem_make_immortal(cmp_new(NULL, &rbt_default_compare));
+        //a thread that loses the race to publish leaks its (immortal) copy
+        if(!__atomic_compare_exchange_n(&Default_Comparator, &expected, cmp, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            cmp = expected;
+    }
+    return cmp;
+}
+
 /* -------------------------------- */
 /*    destructors / constructors    */
 /* -------------------------------- */
@@ -27,7 +43,7 @@ static void rbt_free(void* v_tree){
 rbt_t* rbt_new(cmp_t* cmp){
     rbt_t* tree = mem_allocate(sizeof(rbt_t), &rbt_free);
     tree->root = NULL;
-    tree->comp = cmp ? cmp : cmp_new(NULL, &rbt_default_compare);
+    tree->comp = cmp ? cmp : rbt_default_comparator();
     return tree;
 }
 
@@ -41,7 +41,8 @@ typedef struct {
 /**
  * @brief creates a new red-black tree
  *
- * @param cmp pointer to the comparator object
+ * @param cmp pointer to the comparator object, or NULL to compare contents
+ *            by address using a shared immortal comparator
  *
  * @return pointer to newly created tree
  */
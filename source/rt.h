@@ -12,6 +12,14 @@
 #include <stddef.h>
 #include <limits.h>
 #include <string.h>
+
+/* Storage class for library state that must be kept separately per thread */
+#if defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
 #include "exn.h"
 #include "mem.h"
 
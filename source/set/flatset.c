@@ -0,0 +1,85 @@
+/**
+  @file flatset.c
+  @brief See header for details
+  */
+#include "flatset.h"
+
+struct flatset_t {
+    cmp_t* cmp;
+    vec_t* values; /* sorted by cmp */
+};
+
+static void flatset_free(void* obj)
+{
+    mem_release(((flatset_t*)obj)->values);
+    mem_release(((flatset_t*)obj)->cmp);
+}
+
+static bool flatset_find(flatset_t* set, void* value, size_t* p_index)
+{
+    size_t index = vec_lower_bound(set->values, set->cmp, value);
+    *p_index = index;
+    return (index < vec_size(set->values)) && (0 == cmp_compare(set->cmp, value, vec_at(set->values, index)));
+}
+
+flatset_t* flatset_new(cmp_t* cmp)
+{
+    flatset_t* set = (flatset_t*)mem_allocate(sizeof(flatset_t), &flatset_free);
+    set->cmp    = cmp;
+    set->values = vec_new(0);
+    return set;
+}
+
+flatset_t* flatset_from_array(cmp_t* cmp, size_t count, void** values)
+{
+    flatset_t* set = (flatset_t*)mem_allocate(sizeof(flatset_t), &flatset_free);
+    void** members;
+    size_t i, num_members = 0;
+    set->cmp    = cmp;
+    set->values = vec_from_array(count, values);
+    /* A stable sort puts the first of any duplicates first, so the rest can
+     * be dropped as they are compacted */
+    vec_stable_sort(set->values, cmp);
+    members = set->values->p_buffer;
+    for (i = 0; i < count; i++) {
+        if ((num_members > 0) && (0 == cmp_compare(cmp, members[num_members - 1], members[i])))
+            mem_release(members[i]);
+        else
+            members[num_members++] = members[i];
+    }
+    set->values->size = num_members;
+    vec_shrink_to_fit(set->values);
+    return set;
+}
+
+bool flatset_contains(flatset_t* set, void* value)
+{
+    size_t index;
+    return flatset_find(set, value, &index);
+}
+
+size_t flatset_size(flatset_t* set)
+{
+    return vec_size(set->values);
+}
+
+void flatset_insert(flatset_t* set, void* value)
+{
+    size_t index;
+    if (!flatset_find(set, value, &index))
+        vec_insert_array(set->values, index, 1, &value);
+    else
+        mem_release(value);
+}
+
+void flatset_delete(flatset_t* set, void* value)
+{
+    size_t index;
+    if (flatset_find(set, value, &index))
+        vec_erase(set->values, index, index);
+}
+
+void* flatset_at(flatset_t* set, size_t index)
+{
+    return vec_at(set->values, index);
+}
@@ -0,0 +1,97 @@
+/**
+  @file flatset.h
+  @brief A set kept as a sorted array, for sets that are built once and then
+         mostly read.
+*/
+#ifndef FLATSET_H
+#define FLATSET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vec.h"
+
+/* Flatset data structure */
+struct flatset_t;
+
+/* Flatset structure type alias */
+typedef struct flatset_t flatset_t;
+
+/**
+ * @brief Initializes a new empty set ordered by the provided comparator.
+ *
+ * @param cmp The comparator ordering the members, released with the set.
+ *
+ * @return the newly constructed set.
+ */
+flatset_t* flatset_new(cmp_t* cmp);
+
+/**
+ * @brief Initializes a new set from an array of values in any order.
+ *
+ * The values are sorted once rather than inserted one at a time. Where a
+ * value appears more than once the first is kept and the others released.
+ *
+ * @param cmp The comparator ordering the members, released with the set.
+ * @param count The number of values.
+ * @param values The values, whose references are taken over by the set.
+ *
+ * @return the newly constructed set.
+ */
+flatset_t* flatset_from_array(cmp_t* cmp, size_t count, void** values);
+
+/**
+ * @brief Determines if the value is a member of the set with a binary search.
+ *
+ * @param set The set.
+ * @param value The value to find.
+ *
+ * @return True if the value is a member, false otherwise.
+ */
+bool flatset_contains(flatset_t* set, void* value);
+
+/**
+ * @brief Returns the number of members in the set.
+ *
+ * @param set The set.
+ *
+ * @return The number of members in the set.
+ */
+size_t flatset_size(flatset_t* set);
+
+/**
+ * @brief Insert a value into the set.
+ *
+ * Moves every greater member along, so building a large set this way takes
+ * quadratic time. Use flatset_from_array instead. If the value is already
+ * a member the given one is released.
+ *
+ * @param set The set.
+ * @param value The value to insert.
+ */
+void flatset_insert(flatset_t* set, void* value);
+
+/**
+ * @brief Delete a value from the set.
+ *
+ * @param set The set.
+ * @param value The value to delete.
+ */
+void flatset_delete(flatset_t* set, void* value);
+
+/**
+ * @brief Returns the member at the given position in ascending order.
+ *
+ * @param set The set.
+ * @param index The position of the member.
+ *
+ * @return The member or null if the index is out of range.
+ */
+void* flatset_at(flatset_t* set, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLATSET_H */
@@ -0,0 +1,188 @@
+/**
+  @file gapvec.c
+  @brief See header for details
+*/
+#include "gapvec.h"
+
+/* The number of free slots between the two halves */
+#define GAPVEC_GAP(p_vec) ((p_vec)->gap_end - (p_vec)->gap_start)
+
+static void gapvec_free(void* p_vec);
+
+static void** gapvec_slot(gapvec_t* p_vec, size_t index);
+
+static void gapvec_move_gap(gapvec_t* p_vec, size_t index);
+
+static void gapvec_grow(gapvec_t* p_vec, size_t size);
+
+gapvec_t* gapvec_new(void)
+{
+    gapvec_t* p_vec = (gapvec_t*)mem_allocate(sizeof(gapvec_t), gapvec_free);
+    assert(p_vec != NULL);
+    p_vec->capacity = DEFAULT_VEC_CAPACITY;
+    p_vec->gap_start = 0;
+    p_vec->gap_end = DEFAULT_VEC_CAPACITY;
+    p_vec->p_buffer = (void**)mem_allocate(sizeof(void*) * DEFAULT_VEC_CAPACITY, NULL);
+    assert(p_vec->p_buffer != NULL);
+    return p_vec;
+}
+
+size_t gapvec_size(gapvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->capacity - GAPVEC_GAP(p_vec);
+}
+
+bool gapvec_empty(gapvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return (0 == gapvec_size(p_vec));
+}
+
+size_t gapvec_capacity(gapvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->capacity;
+}
+
+void gapvec_reserve(gapvec_t* p_vec, size_t size)
+{
+    assert(NULL != p_vec);
+    if (size > p_vec->capacity)
+    {
+        size_t tail = p_vec->capacity - p_vec->gap_end;
+        void** p_buffer = (void**)mem_allocate(sizeof(void*) * size, NULL);
+        assert(p_buffer != NULL);
+        /* The gap widens where it is, so the tail goes to the end of the new
+         * buffer */
+        memcpy(p_buffer, p_vec->p_buffer, sizeof(void*) * p_vec->gap_start);
+        memcpy(&p_buffer[size - tail], &p_vec->p_buffer[p_vec->gap_end], sizeof(void*) * tail);
+        mem_release(p_vec->p_buffer);
+        p_vec->p_buffer = p_buffer;
+        p_vec->gap_end = size - tail;
+        p_vec->capacity = size;
+    }
+}
+
+size_t gapvec_cursor(gapvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->gap_start;
+}
+
+void* gapvec_at(gapvec_t* p_vec, size_t index)
+{
+    void** p_slot = gapvec_slot(p_vec, index);
+    return (NULL != p_slot) ? *p_slot : NULL;
+}
+
+bool gapvec_set(gapvec_t* p_vec, size_t index, void* data)
+{
+    void** p_slot = gapvec_slot(p_vec, index);
+    if (NULL != p_slot)
+        *p_slot = data;
+    return (NULL != p_slot);
+}
+
+bool gapvec_insert(gapvec_t* p_vec, size_t index, size_t num_elements, void** p_elements)
+{
+    bool ret = false;
+    if ((index <= gapvec_size(p_vec)) && (num_elements > 0))
+    {
+        gapvec_grow(p_vec, gapvec_size(p_vec) + num_elements);
+        gapvec_move_gap(p_vec, index);
+        memcpy(&p_vec->p_buffer[p_vec->gap_start], p_elements, sizeof(void*) * num_elements);
+        p_vec->gap_start += num_elements;
+        ret = true;
+    }
+    return ret;
+}
+
+bool gapvec_erase(gapvec_t* p_vec, size_t start_idx, size_t end_idx)
+{
+    bool ret = false;
+    size_t size = gapvec_size(p_vec);
+    if ((start_idx < size) && (end_idx < size) && (start_idx <= end_idx))
+    {
+        size_t count = (end_idx - start_idx) + 1;
+        gapvec_move_gap(p_vec, start_idx);
+        mem_release_array(&p_vec->p_buffer[p_vec->gap_end], count);
+        p_vec->gap_end += count;
+        ret = true;
+    }
+    return ret;
+}
+
+void gapvec_push_back(gapvec_t* p_vec, void* data)
+{
+    gapvec_insert(p_vec, gapvec_size(p_vec), 1, &data);
+}
+
+void gapvec_clear(gapvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    mem_release_array(p_vec->p_buffer, p_vec->gap_start);
+    mem_release_array(&p_vec->p_buffer[p_vec->gap_end], p_vec->capacity - p_vec->gap_end);
+    p_vec->gap_start = 0;
+    p_vec->gap_end = p_vec->capacity;
+}
+
+vec_t* gapvec_to_vec(gapvec_t* p_vec)
+{
+    size_t tail = p_vec->capacity - p_vec->gap_end;
+    vec_t* p_copy = vec_from_array(p_vec->gap_start, p_vec->p_buffer);
+    vec_append_array(p_copy, tail, &p_vec->p_buffer[p_vec->gap_end]);
+    mem_retain_array(p_copy->p_buffer, vec_size(p_copy));
+    return p_copy;
+}
+
+static void gapvec_free(void* p_vec)
+{
+    gapvec_t* p_vector = (gapvec_t*)p_vec;
+    assert(NULL != p_vector);
+    gapvec_clear(p_vector);
+    mem_release(p_vector->p_buffer);
+    p_vector->p_buffer = NULL;
+}
+
+/* Maps an index past the elements before the gap over the gap */
+static void** gapvec_slot(gapvec_t* p_vec, size_t index)
+{
+    void** p_ret = NULL;
+    if (index < gapvec_size(p_vec))
+    {
+        if (index >= p_vec->gap_start)
+            index += GAPVEC_GAP(p_vec);
+        p_ret = &p_vec->p_buffer[index];
+    }
+    return p_ret;
+}
+
+/* Moves the elements between the gap and the index across the gap */
+static void gapvec_move_gap(gapvec_t* p_vec, size_t index)
+{
+    if (index < p_vec->gap_start)
+    {
+        size_t count = p_vec->gap_start - index;
+        memmove(&p_vec->p_buffer[p_vec->gap_end - count], &p_vec->p_buffer[index], sizeof(void*) * count);
+        p_vec->gap_start -= count;
+        p_vec->gap_end -= count;
+    }
+    else if (index > p_vec->gap_start)
+    {
+        size_t count = index - p_vec->gap_start;
+        memmove(&p_vec->p_buffer[p_vec->gap_start], &p_vec->p_buffer[p_vec->gap_end], sizeof(void*) * count);
+        p_vec->gap_start += count;
+        p_vec->gap_end += count;
+    }
+}
+
+static void gapvec_grow(gapvec_t* p_vec, size_t size)
+{
+    size_t capacity;
+    if (size > p_vec->capacity)
+    {
+        capacity = ((p_vec->capacity / 100) * VEC_GROWTH_PERCENT) + (((p_vec->capacity % 100) * VEC_GROWTH_PERCENT) / 100);
+        gapvec_reserve(p_vec, (capacity > size) ? capacity : size);
+    }
+}
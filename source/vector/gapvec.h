@@ -0,0 +1,158 @@
+/**
+    @file gapvec.h
+    @brief A vector that keeps its free space at the last edit position.
+*/
+#ifndef GAPVEC_H
+#define GAPVEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vec.h"
+
+/** A vector whose unused slots form a gap that follows the edits. Elements
+ *  before the gap are at the start of the buffer and elements after it at
+ *  the end, so inserting or erasing where the gap already is moves nothing,
+ *  and moving the gap only moves the elements between the old and new
+ *  positions rather than the whole tail. */
+typedef struct {
+    size_t capacity;  /*< The number of slots in the buffer */
+    size_t gap_start; /*< The index of the first free slot */
+    size_t gap_end;   /*< The index of the first element after the gap */
+    void** p_buffer;  /*< The buffer holding the elements and the gap */
+} gapvec_t;
+
+/**
+ * @brief Creates a new empty gap vector with room for DEFAULT_VEC_CAPACITY
+ *        elements.
+ *
+ * @return Pointer to newly created vector.
+ */
+gapvec_t* gapvec_new(void);
+
+/**
+ * @brief Returns the number of items in the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The number of items in the vector.
+ */
+size_t gapvec_size(gapvec_t* p_vec);
+
+/**
+ * @brief Returns whether the vector is empty (size == 0) or not.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return Whether the vector is empty.
+ */
+bool gapvec_empty(gapvec_t* p_vec);
+
+/**
+ * @brief Returns the number of elements the buffer can hold.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The capacity of the vector.
+ */
+size_t gapvec_capacity(gapvec_t* p_vec);
+
+/**
+ * @brief Grows the buffer to hold at least the given number of elements.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param size The number of elements to reserve room for.
+ */
+void gapvec_reserve(gapvec_t* p_vec, size_t size);
+
+/**
+ * @brief Returns the index the gap is at, where the next edit is cheapest.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The index of the element that follows the gap.
+ */
+size_t gapvec_cursor(gapvec_t* p_vec);
+
+/**
+ * @brief Returns the item at the specified index.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the item to retrieve.
+ *
+ * @return The retrieved item or NULL if the index is out of range.
+ */
+void* gapvec_at(gapvec_t* p_vec, size_t index);
+
+/**
+ * @brief Sets the value of the element at the given index.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the element to set.
+ * @param data The new data for the indexed element.
+ *
+ * @return Whether the index was in range.
+ */
+bool gapvec_set(gapvec_t* p_vec, size_t index, void* data);
+
+/**
+ * @brief Inserts elements at the given index.
+ *
+ * The gap is moved to the index first, which moves the elements between it
+ * and the previous edit. Consecutive inserts at the same or adjacent
+ * positions therefore take amortized constant time each.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index at which to insert, at most the vector's size.
+ * @param num_elements The number of elements to insert.
+ * @param p_elements The elements, whose references are taken over by the
+ *                   vector.
+ *
+ * @return Whether the index was in range.
+ */
+bool gapvec_insert(gapvec_t* p_vec, size_t index, size_t num_elements, void** p_elements);
+
+/**
+ * @brief Erases elements from the vector.
+ *
+ * The erased elements are released and their slots joined to the gap, which
+ * is left where they were.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param start_idx The index of the first element to erase.
+ * @param end_idx The index of the last element to erase.
+ *
+ * @return Whether the range was valid.
+ */
+bool gapvec_erase(gapvec_t* p_vec, size_t start_idx, size_t end_idx);
+
+/**
+ * @brief Pushes the provided element on to the back of the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param data The data to push.
+ */
+void gapvec_push_back(gapvec_t* p_vec, void* data);
+
+/**
+ * @brief Erases all elements in the vector, keeping its buffer.
+ *
+ * @param p_vec Pointer to the vector.
+ */
+void gapvec_clear(gapvec_t* p_vec);
+
+/**
+ * @brief Copies the elements, in order, into a new vector.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return A new vector holding a reference to each element.
+ */
+vec_t* gapvec_to_vec(gapvec_t* p_vec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GAPVEC_H */
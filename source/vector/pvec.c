@@ -0,0 +1,347 @@
+/**
+  @file pvec.c
+  @brief See header for details
+*/
+#include "pvec.h"
+
+#define PVEC_MASK (PVEC_WIDTH - 1)
+
+struct pvec_t {
+    size_t size;    /* the number of elements */
+    size_t offset;  /* the trie index of element 0, non-zero for slices */
+    size_t shift;   /* the bits of an index consumed above the leaves */
+    void** p_root;  /* the trie holding every element before the tail */
+    void** p_tail;  /* the leaf holding the last 1 to PVEC_WIDTH elements */
+    bool transient; /* whether nodes only this vector references are written in place */
+};
+
+/* The trie index of the first element held in the tail. Elements are held
+ * at trie indices offset to offset + size. */
+static size_t pvec_tail_offset(size_t count)
+{
+    return (count < PVEC_WIDTH) ? 0 : (((count - 1) >> PVEC_BITS) << PVEC_BITS);
+}
+
+static void pvec_free(void* p_vec)
+{
+    pvec_t* p_vector = (pvec_t*)p_vec;
+    mem_release(p_vector->p_root);
+    mem_release(p_vector->p_tail);
+}
+
+static void pvec_node_free(void* p_node)
+{
+    mem_release_array((void**)p_node, PVEC_WIDTH);
+}
+
+static void** pvec_node_new(void)
+{
+    void** p_node = (void**)mem_allocate(sizeof(void*) * PVEC_WIDTH, &pvec_node_free);
+    assert(NULL != p_node);
+    memset(p_node, 0, sizeof(void*) * PVEC_WIDTH);
+    return p_node;
+}
+
+/* Copies the first count slots of a node, retaining what they hold */
+static void** pvec_node_copy(void** p_node, size_t count)
+{
+    void** p_copy = pvec_node_new();
+    memcpy(p_copy, p_node, sizeof(void*) * count);
+    mem_retain_array(p_copy, count);
+    return p_copy;
+}
+
+/* Returns a reference to a node that may be written in place of the given
+ * one, which is the node itself if a transient holds the only reference to
+ * it. Nodes are checked from the root down, so a node is only unshared if
+ * every node on the path to it is. */
+static void** pvec_node_edit(void** p_node, size_t count, bool in_place)
+{
+    return (in_place && (1 == mem_refcount(p_node))) ? (void**)mem_retain(p_node)
+                                                     : pvec_node_copy(p_node, count);
+}
+
+/* Replaces the contents of a slot, releasing what it held */
+static void pvec_node_store(void** p_node, size_t index, void* data)
+{
+    void* p_old = p_node[index];
+    p_node[index] = data;
+    mem_release(p_old);
+}
+
+/* Replaces one of the vector's nodes, releasing the old reference */
+static void pvec_swap(void*** pp_node, void** p_node)
+{
+    void** p_old = *pp_node;
+    *pp_node = p_node;
+    mem_release(p_old);
+}
+
+static pvec_t* pvec_alloc(pvec_t* p_vec, size_t offset, size_t size, void** p_tail)
+{
+    pvec_t* p_ret = (pvec_t*)mem_allocate(sizeof(pvec_t), &pvec_free);
+    assert(NULL != p_ret);
+    p_ret->size      = size;
+    p_ret->offset    = offset;
+    p_ret->shift     = p_vec->shift;
+    p_ret->p_root    = (void**)mem_retain(p_vec->p_root);
+    p_ret->p_tail    = p_tail;
+    p_ret->transient = false;
+    return p_ret;
+}
+
+/* Returns the leaf holding the element at the given trie index */
+static void** pvec_leaf(pvec_t* p_vec, size_t index)
+{
+    void** p_node = p_vec->p_tail;
+    size_t level;
+    if (index < pvec_tail_offset(p_vec->offset + p_vec->size))
+    {
+        p_node = p_vec->p_root;
+        for (level = p_vec->shift; level > 0; level -= PVEC_BITS)
+            p_node = (void**)p_node[(index >> level) & PVEC_MASK];
+    }
+    return p_node;
+}
+
+/* Wraps a node in enough single-child parents to hang it at the given level */
+static void** pvec_new_path(size_t shift, void** p_node)
+{
+    for (; shift > 0; shift -= PVEC_BITS)
+    {
+        void** p_parent = pvec_node_new();
+        p_parent[0] = p_node;
+        p_node = p_parent;
+    }
+    return p_node;
+}
+
+/* Hangs a full tail, ending at trie index count - 1, below the given node.
+ * Slots past the end of a slice may still hold nodes, which are replaced. */
+static void** pvec_push_tail(size_t count, size_t shift, void** p_parent, void** p_tail, bool in_place)
+{
+    void** p_ret = pvec_node_edit(p_parent, PVEC_WIDTH, in_place);
+    size_t index = ((count - 1) >> shift) & PVEC_MASK;
+    void** p_insert;
+    if (PVEC_BITS == shift)
+        p_insert = p_tail;
+    else if (NULL != p_ret[index])
+        p_insert = pvec_push_tail(count, shift - PVEC_BITS, (void**)p_ret[index], p_tail, in_place);
+    else
+        p_insert = pvec_new_path(shift - PVEC_BITS, p_tail);
+    pvec_node_store(p_ret, index, p_insert);
+    return p_ret;
+}
+
+/* Replaces the element at the given trie index below the given node */
+static void** pvec_assoc(size_t shift, void** p_node, size_t index, void* data, bool in_place)
+{
+    void** p_ret = pvec_node_edit(p_node, PVEC_WIDTH, in_place);
+    size_t slot = (index >> shift) & PVEC_MASK;
+    if (0 == shift)
+        pvec_node_store(p_ret, slot, data);
+    else
+        pvec_node_store(p_ret, slot, pvec_assoc(shift - PVEC_BITS, (void**)p_ret[slot], index, data, in_place));
+    return p_ret;
+}
+
+static void pvec_push_into(pvec_t* p_vec, void* data, bool in_place)
+{
+    size_t count = p_vec->offset + p_vec->size;
+    size_t used = count - pvec_tail_offset(count);
+    if (used < PVEC_WIDTH)
+    {
+        void** p_tail = pvec_node_edit(p_vec->p_tail, used, in_place);
+        pvec_node_store(p_tail, count & PVEC_MASK, data);
+        pvec_swap(&p_vec->p_tail, p_tail);
+    }
+    else
+    {
+        void** p_root;
+        /* Add a level when the trie is full, with the old root at slot 0 */
+        if ((count >> PVEC_BITS) > ((size_t)1 << p_vec->shift))
+        {
+            p_root = pvec_node_new();
+            p_root[0] = mem_retain(p_vec->p_root);
+            p_root[1] = pvec_new_path(p_vec->shift, (void**)mem_retain(p_vec->p_tail));
+            p_vec->shift += PVEC_BITS;
+        }
+        else
+        {
+            p_root = pvec_push_tail(count, p_vec->shift, p_vec->p_root, (void**)mem_retain(p_vec->p_tail), in_place);
+        }
+        pvec_swap(&p_vec->p_root, p_root);
+        pvec_swap(&p_vec->p_tail, pvec_node_new());
+        p_vec->p_tail[0] = data;
+    }
+    p_vec->size++;
+}
+
+static void pvec_set_into(pvec_t* p_vec, size_t index, void* data, bool in_place)
+{
+    size_t count = p_vec->offset + p_vec->size;
+    size_t tail_offset = pvec_tail_offset(count);
+    index += p_vec->offset;
+    if (index >= tail_offset)
+    {
+        void** p_tail = pvec_node_edit(p_vec->p_tail, count - tail_offset, in_place);
+        pvec_node_store(p_tail, index & PVEC_MASK, data);
+        pvec_swap(&p_vec->p_tail, p_tail);
+    }
+    else
+    {
+        pvec_swap(&p_vec->p_root, pvec_assoc(p_vec->shift, p_vec->p_root, index, data, in_place));
+    }
+}
+
+pvec_t* pvec_new(void)
+{
+    pvec_t* p_vec = (pvec_t*)mem_allocate(sizeof(pvec_t), &pvec_free);
+    assert(NULL != p_vec);
+    p_vec->size      = 0;
+    p_vec->offset    = 0;
+    p_vec->shift     = PVEC_BITS;
+    p_vec->p_root    = pvec_node_new();
+    p_vec->p_tail    = pvec_node_new();
+    p_vec->transient = false;
+    return p_vec;
+}
+
+pvec_t* pvec_from_array(size_t num_elements, void** p_elements)
+{
+    pvec_t* p_vec = pvec_new();
+    size_t i;
+    assert((NULL != p_elements) || (0 == num_elements));
+    p_vec->transient = true;
+    for (i = 0; i < num_elements; i++)
+        pvec_transient_push(p_vec, p_elements[i]);
+    return pvec_persistent(p_vec);
+}
+
+size_t pvec_size(pvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->size;
+}
+
+bool pvec_empty(pvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return (0 == p_vec->size);
+}
+
+void* pvec_at(pvec_t* p_vec, size_t index)
+{
+    void* p_ret = NULL;
+    assert(NULL != p_vec);
+    if (index < p_vec->size)
+    {
+        index += p_vec->offset;
+        p_ret = pvec_leaf(p_vec, index)[index & PVEC_MASK];
+    }
+    return p_ret;
+}
+
+pvec_t* pvec_set(pvec_t* p_vec, size_t index, void* data)
+{
+    pvec_t* p_ret = NULL;
+    assert(NULL != p_vec);
+    if (index < p_vec->size)
+    {
+        p_ret = pvec_alloc(p_vec, p_vec->offset, p_vec->size, (void**)mem_retain(p_vec->p_tail));
+        pvec_set_into(p_ret, index, data, false);
+    }
+    return p_ret;
+}
+
+pvec_t* pvec_push(pvec_t* p_vec, void* data)
+{
+    pvec_t* p_ret;
+    assert(NULL != p_vec);
+    p_ret = pvec_alloc(p_vec, p_vec->offset, p_vec->size, (void**)mem_retain(p_vec->p_tail));
+    pvec_push_into(p_ret, data, false);
+    return p_ret;
+}
+
+pvec_t* pvec_pop(pvec_t* p_vec)
+{
+    pvec_t* p_ret = NULL;
+    assert(NULL != p_vec);
+    if (p_vec->size > 0)
+        p_ret = pvec_slice(p_vec, 0, p_vec->size - 1);
+    return p_ret;
+}
+
+pvec_t* pvec_slice(pvec_t* p_vec, size_t start, size_t end)
+{
+    size_t count, tail_offset;
+    void** p_tail;
+    assert(NULL != p_vec);
+    assert(start <= end);
+    assert(end <= p_vec->size);
+    count = p_vec->offset + end;
+    tail_offset = pvec_tail_offset(p_vec->offset + p_vec->size);
+    /* The new tail is the old one cut short, or the leaf in the trie that
+     * holds the new last element */
+    if (count > tail_offset)
+        p_tail = pvec_node_copy(p_vec->p_tail, count - tail_offset);
+    else if (count > 0)
+        p_tail = (void**)mem_retain(pvec_leaf(p_vec, count - 1));
+    else
+        p_tail = pvec_node_new();
+    return pvec_alloc(p_vec, p_vec->offset + start, end - start, p_tail);
+}
+
+pvec_t* pvec_concat(pvec_t* p_vec1, pvec_t* p_vec2)
+{
+    pvec_t* p_ret = pvec_transient(p_vec1);
+    size_t index = p_vec2->offset;
+    size_t count = p_vec2->offset + p_vec2->size;
+    /* Copy the second vector out a leaf at a time */
+    while (index < count)
+    {
+        void** p_leaf = pvec_leaf(p_vec2, index);
+        size_t end = (index | PVEC_MASK) + 1;
+        if (end > count)
+            end = count;
+        for (; index < end; index++)
+            pvec_transient_push(p_ret, mem_retain(p_leaf[index & PVEC_MASK]));
+    }
+    return pvec_persistent(p_ret);
+}
+
+pvec_t* pvec_transient(pvec_t* p_vec)
+{
+    pvec_t* p_ret;
+    assert(NULL != p_vec);
+    p_ret = pvec_alloc(p_vec, p_vec->offset, p_vec->size, (void**)mem_retain(p_vec->p_tail));
+    p_ret->transient = true;
+    return p_ret;
+}
+
+bool pvec_transient_set(pvec_t* p_vec, size_t index, void* data)
+{
+    bool ret = false;
+    assert(NULL != p_vec);
+    assert(p_vec->transient);
+    if (index < p_vec->size)
+    {
+        pvec_set_into(p_vec, index, data, true);
+        ret = true;
+    }
+    return ret;
+}
+
+void pvec_transient_push(pvec_t* p_vec, void* data)
+{
+    assert(NULL != p_vec);
+    assert(p_vec->transient);
+    pvec_push_into(p_vec, data, true);
+}
+
+pvec_t* pvec_persistent(pvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    p_vec->transient = false;
+    return p_vec;
+}
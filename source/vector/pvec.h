@@ -0,0 +1,192 @@
+/**
+    @file pvec.h
+    @brief A persistent vector whose versions share their unchanged nodes.
+*/
+#ifndef PVEC_H
+#define PVEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "rt.h"
+
+/* pvec data structure */
+struct pvec_t;
+
+/** A vector that is never modified once built. Its elements are kept in a
+ *  trie of PVEC_WIDTH-way nodes plus a tail node for the last elements.
+ *  Deriving a new version copies only the path to the changed element, and
+ *  shares every other node with the original by reference counting. */
+typedef struct pvec_t pvec_t;
+
+/** The number of bits of an index consumed by each level of the trie */
+#ifndef PVEC_BITS
+#define PVEC_BITS 5u
+#endif
+
+/** The number of slots in each node of the trie */
+#define PVEC_WIDTH ((size_t)1 << PVEC_BITS)
+
+/**
+ * @brief Creates a new empty vector.
+ *
+ * @return Pointer to newly created vector.
+ */
+pvec_t* pvec_new(void);
+
+/**
+ * @brief Creates a new vector holding the elements of an array.
+ *
+ * The vector is built in place as a transient, without any intermediate
+ * versions. The vector takes over the caller's reference to each element.
+ *
+ * @param num_elements The number of elements in the array.
+ * @param p_elements The array of elements.
+ *
+ * @return Pointer to newly created vector.
+ */
+pvec_t* pvec_from_array(size_t num_elements, void** p_elements);
+
+/**
+ * @brief Returns the number of items in the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The number of items in the vector.
+ */
+size_t pvec_size(pvec_t* p_vec);
+
+/**
+ * @brief Returns whether the vector is empty (size == 0) or not.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return Whether the vector is empty.
+ */
+bool pvec_empty(pvec_t* p_vec);
+
+/**
+ * @brief Returns the item at the specified index.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the item to retrieve.
+ *
+ * @return The retrieved item or NULL if the index is out of range.
+ */
+void* pvec_at(pvec_t* p_vec, size_t index);
+
+/**
+ * @brief Creates a new version of the vector with the element at the given
+ *        index replaced.
+ *
+ * @param p_vec The vector to derive from, which is left unchanged.
+ * @param index The index of the element to replace.
+ * @param data The new element, whose reference is taken over by the new
+ *             version.
+ *
+ * @return The new version or NULL if the index is out of range.
+ */
+pvec_t* pvec_set(pvec_t* p_vec, size_t index, void* data);
+
+/**
+ * @brief Creates a new version of the vector with an element added to the
+ *        back.
+ *
+ * @param p_vec The vector to derive from, which is left unchanged.
+ * @param data The element to add, whose reference is taken over by the new
+ *             version.
+ *
+ * @return The new version.
+ */
+pvec_t* pvec_push(pvec_t* p_vec, void* data);
+
+/**
+ * @brief Creates a new version of the vector without its last element.
+ *
+ * @param p_vec The vector to derive from, which is left unchanged.
+ *
+ * @return The new version or NULL if the vector is empty.
+ */
+pvec_t* pvec_pop(pvec_t* p_vec);
+
+/**
+ * @brief Creates a new version of the vector holding a range of its elements.
+ *
+ * The range is from the start index up to, but not including, the end index.
+ * The slice shares the trie of the original, so the elements outside the
+ * range stay referenced for as long as the slice or its descendants use the
+ * nodes holding them.
+ *
+ * @param p_vec The vector to derive from, which is left unchanged.
+ * @param start The start index.
+ * @param end The end index.
+ *
+ * @return The new version.
+ */
+pvec_t* pvec_slice(pvec_t* p_vec, size_t start, size_t end);
+
+/**
+ * @brief Creates a new vector with the elements of the second vector after
+ *        those of the first.
+ *
+ * The nodes of the first vector are shared. The elements of the second are
+ * appended one at a time to a transient, so this takes time in proportion
+ * to the size of the second vector.
+ *
+ * @param p_vec1 The first vector.
+ * @param p_vec2 The second vector.
+ *
+ * @return The new vector.
+ */
+pvec_t* pvec_concat(pvec_t* p_vec1, pvec_t* p_vec2);
+
+/**
+ * @brief Creates a transient version of the vector for a batch of updates.
+ *
+ * A transient is updated in place by pvec_transient_set and
+ * pvec_transient_push. Nodes still shared with other versions are copied the
+ * first time they are written, after which the transient holds the only
+ * reference to them and writes go straight to the node. The caller must not
+ * share the transient until the batch is finished by pvec_persistent.
+ *
+ * @param p_vec The vector to derive from, which is left unchanged.
+ *
+ * @return The new transient version.
+ */
+pvec_t* pvec_transient(pvec_t* p_vec);
+
+/**
+ * @brief Replaces the element at the given index of a transient.
+ *
+ * @param p_vec The transient to update.
+ * @param index The index of the element to replace.
+ * @param data The new element, whose reference is taken over by the vector.
+ *
+ * @return Whether the index was in range.
+ */
+bool pvec_transient_set(pvec_t* p_vec, size_t index, void* data);
+
+/**
+ * @brief Adds an element to the back of a transient.
+ *
+ * @param p_vec The transient to update.
+ * @param data The element to add, whose reference is taken over by the
+ *             vector.
+ */
+void pvec_transient_push(pvec_t* p_vec, void* data);
+
+/**
+ * @brief Finishes a batch of updates, making the transient persistent again.
+ *
+ * @param p_vec The transient.
+ *
+ * @return The same vector, which may no longer be updated in place.
+ */
+pvec_t* pvec_persistent(pvec_t* p_vec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PVEC_H */
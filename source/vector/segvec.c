@@ -0,0 +1,174 @@
+/**
+  @file segvec.c
+  @brief See header for details
+*/
+#include "segvec.h"
+
+/* Splits an index into the chunk holding it and the offset within that */
+#define SEGVEC_CHUNK(index)  ((index) / SEGVEC_CHUNK_SIZE)
+#define SEGVEC_OFFSET(index) ((index) & (SEGVEC_CHUNK_SIZE - 1))
+
+static void segvec_free(void* p_vec);
+
+static void segvec_free_range(segvec_t* p_vec, size_t start_idx, size_t end_idx);
+
+static void segvec_add_chunk(segvec_t* p_vec);
+
+segvec_t* segvec_new(void)
+{
+    segvec_t* p_vec = (segvec_t*)mem_allocate(sizeof(segvec_t), segvec_free);
+    assert(p_vec != NULL);
+    p_vec->size = 0;
+    p_vec->num_chunks = 0;
+    p_vec->dir_capacity = 0;
+    p_vec->p_chunks = NULL;
+    return p_vec;
+}
+
+size_t segvec_size(segvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->size;
+}
+
+bool segvec_empty(segvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return (0 == segvec_size(p_vec));
+}
+
+size_t segvec_capacity(segvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->num_chunks * SEGVEC_CHUNK_SIZE;
+}
+
+void segvec_reserve(segvec_t* p_vec, size_t size)
+{
+    assert(NULL != p_vec);
+    while (segvec_capacity(p_vec) < size)
+        segvec_add_chunk(p_vec);
+}
+
+void segvec_shrink_to_fit(segvec_t* p_vec)
+{
+    size_t needed;
+    assert(NULL != p_vec);
+    needed = SEGVEC_CHUNK(p_vec->size + SEGVEC_CHUNK_SIZE - 1);
+    while (p_vec->num_chunks > needed)
+        mem_release(p_vec->p_chunks[--p_vec->num_chunks]);
+}
+
+void segvec_resize(segvec_t* p_vec, size_t size, void* data)
+{
+    assert(NULL != p_vec);
+    if (size > p_vec->size)
+    {
+        size_t added = size - p_vec->size;
+        segvec_reserve(p_vec, size);
+        for (; p_vec->size < size; p_vec->size++)
+            p_vec->p_chunks[SEGVEC_CHUNK(p_vec->size)][SEGVEC_OFFSET(p_vec->size)] = data;
+        /* The caller's reference is handed to the last new slot */
+        if ((NULL != data) && (added > 1))
+            mem_retain_n(data, added - 1);
+    }
+    else if (size < p_vec->size)
+    {
+        segvec_free_range(p_vec, size, p_vec->size);
+        p_vec->size = size;
+    }
+}
+
+void* segvec_at(segvec_t* p_vec, size_t index)
+{
+    void* p_ret = NULL;
+    if (index < p_vec->size)
+    {
+        p_ret = p_vec->p_chunks[SEGVEC_CHUNK(index)][SEGVEC_OFFSET(index)];
+    }
+    return p_ret;
+}
+
+void** segvec_slot(segvec_t* p_vec, size_t index)
+{
+    void** p_ret = NULL;
+    if (index < p_vec->size)
+    {
+        p_ret = &p_vec->p_chunks[SEGVEC_CHUNK(index)][SEGVEC_OFFSET(index)];
+    }
+    return p_ret;
+}
+
+bool segvec_set(segvec_t* p_vec, size_t index, void* data)
+{
+    bool ret = false;
+    if (index < p_vec->size)
+    {
+        p_vec->p_chunks[SEGVEC_CHUNK(index)][SEGVEC_OFFSET(index)] = data;
+        ret = true;
+    }
+    return ret;
+}
+
+void segvec_push_back(segvec_t* p_vec, void* data)
+{
+    if (p_vec->size == segvec_capacity(p_vec))
+        segvec_add_chunk(p_vec);
+    p_vec->p_chunks[SEGVEC_CHUNK(p_vec->size)][SEGVEC_OFFSET(p_vec->size)] = data;
+    p_vec->size++;
+}
+
+void* segvec_pop_back(segvec_t* p_vec)
+{
+    void* p_ret = NULL;
+    if (p_vec->size > 0)
+    {
+        p_vec->size = p_vec->size - 1;
+        p_ret = p_vec->p_chunks[SEGVEC_CHUNK(p_vec->size)][SEGVEC_OFFSET(p_vec->size)];
+    }
+    return p_ret;
+}
+
+void segvec_clear(segvec_t* p_vec)
+{
+    segvec_free_range(p_vec, 0, p_vec->size);
+    p_vec->size = 0;
+}
+
+static void segvec_free(void* p_vec)
+{
+    segvec_t* p_vector = (segvec_t*)p_vec;
+    assert(NULL != p_vector);
+    segvec_clear(p_vector);
+    segvec_shrink_to_fit(p_vector);
+    mem_release(p_vector->p_chunks);
+    p_vector->p_chunks = NULL;
+}
+
+/* Releases the elements in the range a chunk at a time */
+static void segvec_free_range(segvec_t* p_vec, size_t start_idx, size_t end_idx)
+{
+    while (start_idx < end_idx)
+    {
+        size_t count = SEGVEC_CHUNK_SIZE - SEGVEC_OFFSET(start_idx);
+        if (count > (end_idx - start_idx))
+            count = end_idx - start_idx;
+        mem_release_array(&p_vec->p_chunks[SEGVEC_CHUNK(start_idx)][SEGVEC_OFFSET(start_idx)], count);
+        start_idx += count;
+    }
+}
+
+/* The directory only holds one pointer per chunk, so doubling it copies a
+ * small fraction of what regrowing a flat array would */
+static void segvec_add_chunk(segvec_t* p_vec)
+{
+    if (p_vec->num_chunks == p_vec->dir_capacity)
+    {
+        p_vec->dir_capacity = (0 == p_vec->dir_capacity) ? 8 : (p_vec->dir_capacity * 2);
+        p_vec->p_chunks = (void***)mem_reallocate(p_vec->p_chunks, sizeof(void**) * p_vec->dir_capacity);
+        assert(NULL != p_vec->p_chunks);
+    }
+    p_vec->p_chunks[p_vec->num_chunks] = (void**)mem_allocate(sizeof(void*) * SEGVEC_CHUNK_SIZE, NULL);
+    assert(NULL != p_vec->p_chunks[p_vec->num_chunks]);
+    p_vec->num_chunks++;
+}
@@ -0,0 +1,156 @@
+/**
+    @file segvec.h
+    @brief A vector stored in fixed size chunks whose elements never move.
+*/
+#ifndef SEGVEC_H
+#define SEGVEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "rt.h"
+
+/** A vector that grows by adding chunks rather than reallocating one array,
+ *  so growing never copies elements and slot addresses stay valid */
+typedef struct {
+    size_t size;         /*< The number of elements currently in the vector */
+    size_t num_chunks;   /*< The number of chunks allocated */
+    size_t dir_capacity; /*< The number of chunks the directory has room for */
+    void*** p_chunks;    /*< The directory of chunks */
+} segvec_t;
+
+/** The number of elements in each chunk, a power of two */
+#ifndef SEGVEC_CHUNK_SIZE
+#define SEGVEC_CHUNK_SIZE 1024u
+#endif
+
+#if ((SEGVEC_CHUNK_SIZE & (SEGVEC_CHUNK_SIZE - 1)) != 0)
+#error "SEGVEC_CHUNK_SIZE must be a power of two"
+#endif
+
+/**
+ * @brief Creates a new empty segmented vector.
+ *
+ * @return Pointer to newly created vector.
+ */
+segvec_t* segvec_new(void);
+
+/**
+ * @brief Returns the number of items in the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The number of items in the vector.
+ */
+size_t segvec_size(segvec_t* p_vec);
+
+/**
+ * @brief Returns whether the vector is empty (size == 0) or not.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return Whether the vector is empty.
+ */
+bool segvec_empty(segvec_t* p_vec);
+
+/**
+ * @brief Returns the number of elements the allocated chunks can hold.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The capacity of the vector.
+ */
+size_t segvec_capacity(segvec_t* p_vec);
+
+/**
+ * @brief Allocates enough chunks to hold the given number of elements.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param size The number of elements to reserve room for.
+ */
+void segvec_reserve(segvec_t* p_vec, size_t size);
+
+/**
+ * @brief Frees the chunks beyond those holding elements.
+ *
+ * @param p_vec Pointer to the vector.
+ */
+void segvec_shrink_to_fit(segvec_t* p_vec);
+
+/**
+ * @brief Resizes the vector to contain the specified number of elements.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param size The target size of the vector.
+ * @param data The value of any newly created elements.
+ */
+void segvec_resize(segvec_t* p_vec, size_t size, void* data);
+
+/**
+ * @brief Returns the item at the specified index.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the item to retrieve.
+ *
+ * @return The retrieved item or NULL if the index is out of range.
+ */
+void* segvec_at(segvec_t* p_vec, size_t index);
+
+/**
+ * @brief Returns the address of the slot holding the element at the given
+ *        index.
+ *
+ * The address stays valid as the vector grows and shrinks, until the chunk
+ * holding it is freed by segvec_shrink_to_fit or with the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the slot.
+ *
+ * @return The slot's address or NULL if the index is out of range.
+ */
+void** segvec_slot(segvec_t* p_vec, size_t index);
+
+/**
+ * @brief Sets the value of the element at the given index.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the element to set.
+ * @param data The new data for the indexed element.
+ *
+ * @return Whether the index was in range.
+ */
+bool segvec_set(segvec_t* p_vec, size_t index, void* data);
+
+/**
+ * @brief Pushes the provided element on to the back of the vector.
+ *
+ * At most one chunk is allocated, plus the directory doubling once every
+ * time the number of chunks does, so no push copies any elements.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param data The data to push.
+ */
+void segvec_push_back(segvec_t* p_vec, void* data);
+
+/**
+ * @brief Erases and returns the last element in the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The element that was removed.
+ */
+void* segvec_pop_back(segvec_t* p_vec);
+
+/**
+ * @brief Erases all elements in the vector, keeping its chunks.
+ *
+ * @param p_vec Pointer to the vector.
+ */
+void segvec_clear(segvec_t* p_vec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEGVEC_H */
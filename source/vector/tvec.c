@@ -0,0 +1,252 @@
+/**
+  @file tvec.c
+  @brief See header for details
+*/
+#include "tvec.h"
+
+static void tvec_free(void* p_vec);
+
+static void tvec_free_range(tvec_t* p_vec, size_t start_idx, size_t end_idx);
+
+static void tvec_grow(tvec_t* p_vec, size_t size);
+
+static uint8_t* tvec_buffer_resize(tvec_t* p_vec, size_t num_elements);
+
+tvec_t* tvec_new(size_t elem_size, destructor_t p_destruct, size_t num_elements, const void* p_elements)
+{
+    tvec_t* p_vec;
+    assert(elem_size > 0);
+
+    /* Allocate and construct the vector object */
+    p_vec = (tvec_t*)mem_allocate(sizeof(tvec_t), tvec_free);
+    assert(p_vec != NULL);
+    p_vec->size = num_elements;
+    p_vec->capacity = (0 == num_elements) ? DEFAULT_VEC_CAPACITY : num_elements;
+    p_vec->p_buffer = NULL;
+    p_vec->growth = 0;
+    p_vec->elem_size = elem_size;
+    p_vec->p_destruct = p_destruct;
+    p_vec->p_buffer = tvec_buffer_resize(p_vec, p_vec->capacity);
+
+    /* Populate the array with the elements */
+    if (NULL != p_elements)
+        memcpy(p_vec->p_buffer, p_elements, elem_size * num_elements);
+    else
+        memset(p_vec->p_buffer, 0, elem_size * num_elements);
+
+    return p_vec;
+}
+
+size_t tvec_size(tvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->size;
+}
+
+size_t tvec_max_size(tvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return (size_t)-1 / p_vec->elem_size;
+}
+
+bool tvec_empty(tvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return (0 == tvec_size(p_vec));
+}
+
+void tvec_resize(tvec_t* p_vec, size_t size, const void* p_data)
+{
+    assert(NULL != p_vec);
+    if (size > p_vec->size)
+    {
+        tvec_grow(p_vec, size);
+        if (NULL == p_data)
+        {
+            memset(&p_vec->p_buffer[p_vec->size * p_vec->elem_size], 0,
+                   (size - p_vec->size) * p_vec->elem_size);
+            p_vec->size = size;
+        }
+        for (; p_vec->size < size; p_vec->size++)
+            memcpy(&p_vec->p_buffer[p_vec->size * p_vec->elem_size], p_data, p_vec->elem_size);
+    }
+    else if (size < p_vec->size)
+    {
+        tvec_free_range(p_vec, size, p_vec->size);
+        p_vec->size = size;
+    }
+}
+
+void tvec_set_growth(tvec_t* p_vec, unsigned percent)
+{
+    assert((NULL != p_vec) && (percent > 100));
+    p_vec->growth = percent;
+}
+
+void tvec_shrink_to_fit(tvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    p_vec->p_buffer = tvec_buffer_resize(p_vec, p_vec->size);
+    p_vec->capacity = p_vec->size;
+}
+
+size_t tvec_capacity(tvec_t* p_vec)
+{
+    return p_vec->capacity;
+}
+
+void tvec_reserve(tvec_t* p_vec, size_t size)
+{
+    assert(p_vec != NULL);
+    if (size > p_vec->capacity)
+    {
+        p_vec->p_buffer = tvec_buffer_resize(p_vec, size);
+        p_vec->capacity = size;
+    }
+}
+
+void* tvec_at(tvec_t* p_vec, size_t index)
+{
+    void* p_ret = NULL;
+    if (index < p_vec->size)
+    {
+        p_ret = &p_vec->p_buffer[index * p_vec->elem_size];
+    }
+    return p_ret;
+}
+
+void* tvec_data(tvec_t* p_vec)
+{
+    assert(NULL != p_vec);
+    return p_vec->p_buffer;
+}
+
+bool tvec_set(tvec_t* p_vec, size_t index, const void* p_data)
+{
+    bool ret = false;
+    if (index < p_vec->size)
+    {
+        tvec_free_range(p_vec, index, index + 1);
+        memcpy(&p_vec->p_buffer[index * p_vec->elem_size], p_data, p_vec->elem_size);
+        ret = true;
+    }
+    return ret;
+}
+
+bool tvec_insert(tvec_t* p_vec, size_t index, size_t num_elements, const void* p_elements)
+{
+    bool ret = false;
+    size_t elem_size = p_vec->elem_size;
+    if ((index <= p_vec->size) && (num_elements > 0))
+    {
+        /* Make room for the new contents */
+        tvec_grow(p_vec, p_vec->size + num_elements);
+        /* Move the displaced elements to the end */
+        memmove(&p_vec->p_buffer[(index + num_elements) * elem_size],
+                &p_vec->p_buffer[index * elem_size],
+                (p_vec->size - index) * elem_size);
+        /* Copy in the new elements */
+        memcpy(&p_vec->p_buffer[index * elem_size], p_elements, num_elements * elem_size);
+        p_vec->size += num_elements;
+        ret = true;
+    }
+    return ret;
+}
+
+bool tvec_erase(tvec_t* p_vec, size_t start_idx, size_t end_idx)
+{
+    bool ret = false;
+    size_t elem_size = p_vec->elem_size;
+    /* if the range is valid */
+    if ((start_idx < p_vec->size) && (end_idx < p_vec->size) && (start_idx <= end_idx))
+    {
+        /* Destruct the range of elements */
+        tvec_free_range(p_vec, start_idx, end_idx + 1);
+        /* Compact the remaining elements */
+        memmove(&p_vec->p_buffer[start_idx * elem_size],
+                &p_vec->p_buffer[(end_idx + 1) * elem_size],
+                (p_vec->size - end_idx - 1) * elem_size);
+        /* Shrink the size */
+        p_vec->size = p_vec->size - ((end_idx - start_idx) + 1);
+        ret = true;
+    }
+    return ret;
+}
+
+void tvec_push_back(tvec_t* p_vec, const void* p_data)
+{
+    if (p_vec->size == p_vec->capacity)
+        tvec_grow(p_vec, p_vec->size+1);
+    memcpy(&p_vec->p_buffer[p_vec->size * p_vec->elem_size], p_data, p_vec->elem_size);
+    p_vec->size++;
+}
+
+bool tvec_pop_back(tvec_t* p_vec, void* p_out)
+{
+    bool ret = false;
+    if (p_vec->size > 0)
+    {
+        if (NULL != p_out)
+            memcpy(p_out, &p_vec->p_buffer[(p_vec->size - 1) * p_vec->elem_size], p_vec->elem_size);
+        else
+            tvec_free_range(p_vec, p_vec->size - 1, p_vec->size);
+        p_vec->size = p_vec->size - 1;
+        ret = true;
+    }
+    return ret;
+}
+
+void tvec_clear(tvec_t* p_vec)
+{
+    tvec_free_range(p_vec, 0, p_vec->size);
+    p_vec->size = 0;
+}
+
+static void tvec_free(void* p_vec)
+{
+    tvec_t* p_vector = (tvec_t*)p_vec;
+    assert(NULL != p_vector);
+    assert(NULL != p_vector->p_buffer);
+    tvec_clear(p_vector);
+    mem_release(p_vector->p_buffer);
+    p_vector->p_buffer = NULL;
+}
+
+static void tvec_free_range(tvec_t* p_vec, size_t start_idx, size_t end_idx)
+{
+    size_t index;
+    if (NULL != p_vec->p_destruct)
+    {
+        for (index = start_idx; index < end_idx; index++)
+            p_vec->p_destruct(&p_vec->p_buffer[index * p_vec->elem_size]);
+    }
+}
+
+/* Makes room for at least size elements, growing the capacity geometrically
+ * as vec_grow does */
+static void tvec_grow(tvec_t* p_vec, size_t size)
+{
+    size_t percent = (0 == p_vec->growth) ? VEC_GROWTH_PERCENT : p_vec->growth;
+    size_t capacity;
+    if (size > p_vec->capacity)
+    {
+        capacity = ((p_vec->capacity / 100) * percent) + (((p_vec->capacity % 100) * percent) / 100);
+        tvec_reserve(p_vec, (capacity > size) ? capacity : size);
+    }
+}
+
+static uint8_t* tvec_buffer_resize(tvec_t* p_vec, size_t num_elements)
+{
+    uint8_t* p_buffer = p_vec->p_buffer;
+    assert(num_elements <= tvec_max_size(p_vec));
+#if (VEC_BUFFER_ALIGNMENT > 0)
+    if (NULL == p_buffer)
+        p_buffer = (uint8_t*)mem_allocate_aligned(p_vec->elem_size * num_elements, VEC_BUFFER_ALIGNMENT, NULL);
+    else
+        p_buffer = (uint8_t*)mem_reallocate(p_buffer, p_vec->elem_size * num_elements);
+#else
+    p_buffer = (uint8_t*)mem_reallocate(p_buffer, p_vec->elem_size * num_elements);
+#endif
+    assert(p_buffer != NULL);
+    return p_buffer;
+}
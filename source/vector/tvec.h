@@ -0,0 +1,202 @@
+/**
+    @file tvec.h
+    @brief A vector storing fixed size elements by value.
+*/
+#ifndef TVEC_H
+#define TVEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vec.h"
+
+/** A vector whose elements are copied into one contiguous array rather than
+ *  referenced through pointers to separately allocated objects */
+typedef struct {
+    size_t size;              /*< The number of elements currently in the array */
+    size_t capacity;          /*< The number of elements the internal array holds */
+    uint8_t* p_buffer;        /*< Pointer to the array */
+    unsigned growth;          /*< Capacity after growing as a percentage of before, 0 for the default */
+    size_t elem_size;         /*< The size of each element in bytes */
+    destructor_t p_destruct;  /*< Called on each element as it is removed, may be NULL */
+} tvec_t;
+
+/**
+ * @brief Creates a new vector of elements of the given size.
+ *
+ * The destructor, if any, is passed a pointer to an element inside the
+ * internal array whenever that element is erased, overwritten or released
+ * with the vector. It must not free the pointer it is given.
+ *
+ * @param elem_size The size of each element in bytes.
+ * @param p_destruct Function to call on each removed element, or NULL.
+ * @param num_elements The number of elements to be put into the vector.
+ * @param p_elements Array of num_elements elements to copy in, or NULL to
+ *                   zero them instead.
+ *
+ * @return Pointer to newly created vector.
+ */
+tvec_t* tvec_new(size_t elem_size, destructor_t p_destruct, size_t num_elements, const void* p_elements);
+
+/**
+ * @brief Returns the number of elements in the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The number of elements in the vector.
+ */
+size_t tvec_size(tvec_t* p_vec);
+
+/**
+ * @brief Returns the maximum number of elements the vector could contain.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The maximum size of the vector.
+ */
+size_t tvec_max_size(tvec_t* p_vec);
+
+/**
+ * @brief Returns whether the vector is empty (size == 0) or not.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return Whether the vector is empty.
+ */
+bool tvec_empty(tvec_t* p_vec);
+
+/**
+ * @brief Resizes the vector to contain the specified number of elements.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param size The target size of the vector.
+ * @param p_data The element copied into each new slot, or NULL to zero them.
+ */
+void tvec_resize(tvec_t* p_vec, size_t size, const void* p_data);
+
+/**
+ * @brief Sets the factor by which the vector's capacity grows when an
+ *        element is added to it while it is full. See vec_set_growth.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param percent The new capacity as a percentage of the old, greater than 100.
+ */
+void tvec_set_growth(tvec_t* p_vec, unsigned percent);
+
+/**
+ * @brief Shrinks the vector's capacity to equal it's size.
+ *
+ * @param p_vec Pointer to the vector.
+ */
+void tvec_shrink_to_fit(tvec_t* p_vec);
+
+/**
+ * @brief Returns the number of elements the internal array can hold.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return The capacity of the internal array.
+ */
+size_t tvec_capacity(tvec_t* p_vec);
+
+/**
+ * @brief Sets the minimum storage capacity of the vector to the given size.
+ *
+ * The capacity is never reduced, use tvec_shrink_to_fit for that.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param size The number of elements to reserve room for.
+ */
+void tvec_reserve(tvec_t* p_vec, size_t size);
+
+/**
+ * @brief Returns a pointer to the element at the specified index.
+ *
+ * The pointer is invalidated by anything that grows or shrinks the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the element to retrieve.
+ *
+ * @return Pointer to the element or NULL if the index is out of range.
+ */
+void* tvec_at(tvec_t* p_vec, size_t index);
+
+/**
+ * @brief Returns a pointer to the first element of the internal array.
+ *
+ * @param p_vec Pointer to the vector.
+ *
+ * @return Pointer to the contiguous elements.
+ */
+void* tvec_data(tvec_t* p_vec);
+
+/**
+ * @brief Overwrites the element at the given index with a copy of the data,
+ *        destructing the element it replaces.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index The index of the element to set.
+ * @param p_data The new value of the indexed element.
+ *
+ * @return Whether the index was in range.
+ */
+bool tvec_set(tvec_t* p_vec, size_t index, const void* p_data);
+
+/**
+ * @brief Inserts copies of the provided elements at the given index.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index Index at which the elements should be inserted, up to and
+ *              including the size of the vector.
+ * @param num_elements The number of elements to insert.
+ * @param p_elements Array of num_elements elements to insert.
+ *
+ * @return Whether the elements were inserted.
+ */
+bool tvec_insert(tvec_t* p_vec, size_t index, size_t num_elements, const void* p_elements);
+
+/**
+ * @brief Erases elements from the vector that fall into the given range.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param start_idx The start of the range.
+ * @param end_idx The end of the range, inclusive.
+ *
+ * @return Whether the operation was successful.
+ */
+bool tvec_erase(tvec_t* p_vec, size_t start_idx, size_t end_idx);
+
+/**
+ * @brief Copies the provided element on to the back of the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_data The element to push.
+ */
+void tvec_push_back(tvec_t* p_vec, const void* p_data);
+
+/**
+ * @brief Removes the last element in the vector.
+ *
+ * The element is moved into p_out without being destructed, which hands
+ * whatever it owns to the caller. It is destructed if p_out is NULL.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_out Where to copy the removed element, or NULL.
+ *
+ * @return Whether there was an element to remove.
+ */
+bool tvec_pop_back(tvec_t* p_vec, void* p_out);
+
+/**
+ * @brief Erases all elements in the vector.
+ *
+ * @param p_vec Pointer to the vector.
+ */
+void tvec_clear(tvec_t* p_vec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TVEC_H */
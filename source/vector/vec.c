@@ -3,11 +3,113 @@
   @brief See header for details
 */
 #include "vec.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* Inline slots would not honour the buffer alignment */
+#if (VEC_BUFFER_ALIGNMENT > 0)
+#define VEC_INLINE_SLOTS 0
+#else
+#define VEC_INLINE_SLOTS VEC_INLINE_CAPACITY
+#endif
+
+/* Ranges shorter than this are sorted by insertion */
+#define SORT_INSERTION_MAX 16
+
+#define SORT_LESS(p_cmp, p_a, p_b) ((p_cmp)->fn((p_cmp)->env, (p_a), (p_b)) < 0)
+
+/* A chunk to sort, or two adjacent sorted runs to merge, on one thread */
+typedef struct {
+    cmp_t* p_cmp;
+    void** p_src;  /* The elements to sort or the runs to merge */
+    void** p_dst;  /* Scratch space when sorting, the destination when merging */
+    size_t count;  /* The number of elements */
+    size_t split;  /* The length of the first run when merging */
+    bool stable;   /* Whether equal elements must keep their order */
+} sort_task_t;
+
+/* A range of elements visited by one thread in a bulk operation */
+typedef struct {
+    void** p_elems;         /* The first element of the range */
+    size_t start;           /* The index of the first element */
+    size_t count;           /* The number of elements */
+    void* env;
+    vec_applyfn_t p_apply;
+    vec_mapfn_t p_map;
+    vec_predfn_t p_pred;
+    vec_reducefn_t p_reduce;
+    void** p_out;           /* Where mapped or kept elements are written */
+    size_t num_out;         /* The number of elements kept */
+    void* p_acc;            /* The accumulator when reducing */
+    size_t* p_found;        /* The lowest index matched by any range */
+} bulk_task_t;
+
+/* The most tasks run at once by a sort or bulk operation */
+#define VEC_MAX_TASKS ((VEC_SORT_MAX_THREADS > VEC_PARALLEL_MAX_THREADS) ? VEC_SORT_MAX_THREADS : VEC_PARALLEL_MAX_THREADS)
+
+/* The tasks of one sort or bulk operation, claimed in turn by the calling
+ * thread and the pool's workers */
+typedef struct {
+    uint8_t* p_tasks;
+    size_t task_size;
+    size_t num_tasks;
+    void* (*p_fn)(void*);
+    size_t next;            /* The next task to be claimed */
+    size_t running;         /* The tasks claimed but not yet finished */
+} task_batch_t;
+
+/* Worker threads started by the first operation to run tasks in parallel and
+ * kept waiting for the next one, as starting a thread per task costs more
+ * than many operations save */
+static pthread_once_t Task_Pool_Once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t Task_Pool_Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Task_Pool_Wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t Task_Pool_Done = PTHREAD_COND_INITIALIZER;
+static task_batch_t* Task_Pool_Batch = NULL;
+static size_t Task_Pool_Workers = 0;
+
+static vec_t* vec_alloc(size_t size, size_t capacity);
+
+static bool vec_is_inline(vec_t* p_vec);
 
 static void vec_free(void* p_vec);
 
 static void vec_free_range(void** p_buffer, size_t start_idx, size_t end_idx);
 
+static void vec_grow(vec_t* p_vec, size_t size);
+
+static void** vec_buffer_resize(void** p_buffer, size_t num_elements);
+
+static void vec_buffer_free(void** p_buffer);
+
+static void vec_sort_elements(vec_t* p_vec, cmp_t* p_cmp, bool stable);
+
+static void sort_insertion(void** p_elems, size_t count, cmp_t* p_cmp);
+
+static void sort_heap(void** p_elems, size_t count, cmp_t* p_cmp);
+
+static void sort_intro(void** p_elems, size_t count, size_t depth, cmp_t* p_cmp);
+
+static void sort_merge(void** p_dst, void** p_left, size_t num_left, void** p_right, size_t num_right, cmp_t* p_cmp);
+
+static void sort_stable(void** p_elems, void** p_tmp, size_t count, cmp_t* p_cmp);
+
+static void sort_parallel(void** p_elems, size_t count, cmp_t* p_cmp, bool stable, size_t threads);
+
+static void run_tasks(void* p_tasks, size_t task_size, size_t num_tasks, void* (*p_fn)(void*));
+
+static size_t bulk_split(bulk_task_t* p_tasks, vec_t* p_vec, size_t threads);
+
+static void* bulk_foreach_task(void* p_arg);
+
+static void* bulk_map_task(void* p_arg);
+
+static void* bulk_filter_task(void* p_arg);
+
+static void* bulk_reduce_task(void* p_arg);
+
+static void* bulk_find_task(void* p_arg);
+
 vec_t* vec_new(size_t num_elements, ...)
 {
     vec_t* p_vec;
@@ -15,12 +117,7 @@ vec_t* vec_new(size_t num_elements, ...)
     size_t index;
 
     /* Allocate and construct the vector object */
-    p_vec = (vec_t*)mem_allocate(sizeof(vec_t), vec_free);
-    assert(p_vec != NULL);
-    p_vec->size = num_elements;
-    p_vec->capacity = (0 == num_elements) ? DEFAULT_VEC_CAPACITY : num_elements;
-    p_vec->p_buffer = (void**)calloc( sizeof(void*), p_vec->capacity );
-    assert(p_vec->p_buffer != NULL);
+    p_vec = vec_alloc(num_elements, (0 == num_elements) ? DEFAULT_VEC_CAPACITY : num_elements);
 
     /* Populate the array with the elements list */
     va_start(elements, num_elements);
@@ -33,6 +130,21 @@ vec_t* vec_new(size_t num_elements, ...)
     return p_vec;
 }
 
+vec_t* vec_from_array(size_t num_elements, void** p_elements)
+{
+    vec_t* p_vec;
+    assert((NULL != p_elements) || (0 == num_elements));
+
+    /* Allocate and construct the vector object */
+    p_vec = vec_alloc(num_elements, (0 == num_elements) ? DEFAULT_VEC_CAPACITY : num_elements);
+
+    /* Copy the elements in as one block */
+    if (num_elements > 0)
+        memcpy(p_vec->p_buffer, p_elements, sizeof(void*) * num_elements);
+
+    return p_vec;
+}
+
 size_t vec_size(vec_t* p_vec)
 {
     assert(NULL != p_vec);
@@ -55,13 +167,13 @@ void vec_resize(vec_t* p_vec, size_t size, void* data)
     assert(NULL != p_vec);
     if (size > p_vec->size)
     {
-        vec_reserve(p_vec,vec_next_capacity(size+1));
+        size_t added = size - p_vec->size;
+        vec_grow(p_vec, size);
         for (; p_vec->size < size; p_vec->size++)
-        {
             p_vec->p_buffer[ p_vec->size ] = data;
-            if((NULL != data) && ((size - p_vec->size) > 1))
-                mem_retain(data);
-        }
+        /* The caller's reference is handed to the last new slot */
+        if((NULL != data) && (added > 1))
+            mem_retain_n(data, added - 1);
     }
     else if (size < p_vec->size)
     {
@@ -87,11 +199,17 @@ size_t vec_next_capacity(size_t req_size)
     return next_power;
 }
 
+void vec_set_growth(vec_t* p_vec, unsigned percent)
+{
+    assert((NULL != p_vec) && (percent > 100));
+    p_vec->growth = percent;
+}
+
 void vec_shrink_to_fit(vec_t* p_vec)
 {
     assert(NULL != p_vec);
-    p_vec->p_buffer = realloc( p_vec->p_buffer, sizeof(void*) * p_vec->size );
-    assert(p_vec->p_buffer != NULL);
+    if (!vec_is_inline(p_vec))
+        p_vec->p_buffer = vec_buffer_resize(p_vec->p_buffer, p_vec->size);
     p_vec->capacity = p_vec->size;
 }
 
@@ -103,9 +221,21 @@ size_t vec_capacity(vec_t* p_vec)
 void vec_reserve(vec_t* p_vec, size_t size)
 {
     assert(p_vec != NULL);
-    p_vec->p_buffer = realloc( p_vec->p_buffer, sizeof(void*) * size );
-    assert(p_vec->p_buffer != NULL);
-    p_vec->capacity = size;
+    if (size > p_vec->capacity)
+    {
+        if (vec_is_inline(p_vec))
+        {
+            /* Move the elements out of the vector object */
+            void** p_buffer = vec_buffer_resize(NULL, size);
+            memcpy(p_buffer, p_vec->p_buffer, sizeof(void*) * p_vec->size);
+            p_vec->p_buffer = p_buffer;
+        }
+        else
+        {
+            p_vec->p_buffer = vec_buffer_resize(p_vec->p_buffer, size);
+        }
+        p_vec->capacity = size;
+    }
 }
 
 void* vec_at(vec_t* p_vec, size_t index)
@@ -134,6 +264,7 @@ bool vec_insert(vec_t* p_vec, size_t index, size_t num_elements, ...)
     bool ret = false;
     va_list elements;
     size_t new_size;
+    size_t old_size = p_vec->size;
     if ((index < p_vec->size) && (num_elements > 0))
     {
         /* Resize the vector to fit the new contents */
@@ -141,7 +272,7 @@ bool vec_insert(vec_t* p_vec, size_t index, size_t num_elements, ...)
         /* Move the displaced items to the end */
         memmove(&(p_vec->p_buffer[index + num_elements]),
                 &(p_vec->p_buffer[index]),
-                sizeof(void*) * (p_vec->size - index));
+                sizeof(void*) * (old_size - index));
         /* insert the new items */
         va_start(elements, num_elements);
         new_size = index + num_elements;
@@ -155,6 +286,41 @@ bool vec_insert(vec_t* p_vec, size_t index, size_t num_elements, ...)
     return ret;
 }
 
+bool vec_insert_array(vec_t* p_vec, size_t index, size_t num_elements, void** p_elements)
+{
+    bool ret = false;
+    if ((index <= p_vec->size) && (num_elements > 0))
+    {
+        assert(NULL != p_elements);
+        vec_grow(p_vec, p_vec->size + num_elements);
+        /* Move the displaced items to the end */
+        memmove(&(p_vec->p_buffer[index + num_elements]),
+                &(p_vec->p_buffer[index]),
+                sizeof(void*) * (p_vec->size - index));
+        memcpy(&(p_vec->p_buffer[index]), p_elements, sizeof(void*) * num_elements);
+        p_vec->size += num_elements;
+        ret = true;
+    }
+    return ret;
+}
+
+void vec_append_array(vec_t* p_vec, size_t num_elements, void** p_elements)
+{
+    assert(NULL != p_vec);
+    (void)vec_insert_array(p_vec, p_vec->size, num_elements, p_elements);
+}
+
+void vec_extend(vec_t* p_vec, vec_t* p_src)
+{
+    size_t num_elements;
+    assert((NULL != p_vec) && (NULL != p_src));
+    num_elements = p_src->size;
+    /* Grow first, as the source may be the destination itself */
+    vec_grow(p_vec, p_vec->size + num_elements);
+    mem_retain_array(p_src->p_buffer, num_elements);
+    vec_append_array(p_vec, num_elements, p_src->p_buffer);
+}
+
 bool vec_erase(vec_t* p_vec, size_t start_idx, size_t end_idx)
 {
     bool ret = false;
@@ -176,7 +342,9 @@ bool vec_erase(vec_t* p_vec, size_t start_idx, size_t end_idx)
 
 void vec_push_back(vec_t* p_vec, void* data)
 {
-    vec_resize(p_vec, p_vec->size+1, data);
+    if (p_vec->size == p_vec->capacity)
+        vec_grow(p_vec, p_vec->size+1);
+    p_vec->p_buffer[p_vec->size++] = data;
 }
 
 void* vec_pop_back(vec_t* p_vec)
@@ -196,27 +364,707 @@ void vec_clear(vec_t* p_vec)
     p_vec->size = 0;
 }
 
+void vec_sort(vec_t* p_vec, cmp_t* p_cmp)
+{
+    vec_sort_elements(p_vec, p_cmp, false);
+}
+
+void vec_stable_sort(vec_t* p_vec, cmp_t* p_cmp)
+{
+    vec_sort_elements(p_vec, p_cmp, true);
+}
+
+size_t vec_lower_bound(vec_t* p_vec, cmp_t* p_cmp, void* p_value)
+{
+    size_t first = 0;
+    size_t count = p_vec->size;
+    assert(NULL != p_cmp);
+    while (count > 0)
+    {
+        size_t half = count / 2;
+        if (SORT_LESS(p_cmp, p_vec->p_buffer[first + half], p_value))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+size_t vec_upper_bound(vec_t* p_vec, cmp_t* p_cmp, void* p_value)
+{
+    size_t first = 0;
+    size_t count = p_vec->size;
+    assert(NULL != p_cmp);
+    while (count > 0)
+    {
+        size_t half = count / 2;
+        if (!SORT_LESS(p_cmp, p_value, p_vec->p_buffer[first + half]))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+bool vec_binary_search(vec_t* p_vec, cmp_t* p_cmp, void* p_value)
+{
+    size_t index = vec_lower_bound(p_vec, p_cmp, p_value);
+    return (index < p_vec->size) && !SORT_LESS(p_cmp, p_value, p_vec->p_buffer[index]);
+}
+
+void vec_foreach(vec_t* p_vec, vec_applyfn_t p_fn, void* env)
+{
+    vec_parallel_foreach(p_vec, p_fn, env, 1);
+}
+
+vec_t* vec_map(vec_t* p_vec, vec_mapfn_t p_fn, void* env)
+{
+    return vec_parallel_map(p_vec, p_fn, env, 1);
+}
+
+vec_t* vec_filter(vec_t* p_vec, vec_predfn_t p_fn, void* env)
+{
+    return vec_parallel_filter(p_vec, p_fn, env, 1);
+}
+
+void* vec_reduce(vec_t* p_vec, vec_reducefn_t p_fn, void* env, void* p_init)
+{
+    return vec_parallel_reduce(p_vec, p_fn, p_fn, env, p_init, 1);
+}
+
+size_t vec_find_if(vec_t* p_vec, vec_predfn_t p_fn, void* env)
+{
+    return vec_parallel_find_if(p_vec, p_fn, env, 1);
+}
+
+void vec_parallel_foreach(vec_t* p_vec, vec_applyfn_t p_fn, void* env, size_t threads)
+{
+    bulk_task_t tasks[VEC_PARALLEL_MAX_THREADS];
+    size_t i, num_tasks;
+    assert(NULL != p_fn);
+    num_tasks = bulk_split(tasks, p_vec, threads);
+    for (i = 0; i < num_tasks; i++)
+    {
+        tasks[i].env = env;
+        tasks[i].p_apply = p_fn;
+    }
+    run_tasks(tasks, sizeof(bulk_task_t), num_tasks, bulk_foreach_task);
+}
+
+vec_t* vec_parallel_map(vec_t* p_vec, vec_mapfn_t p_fn, void* env, size_t threads)
+{
+    bulk_task_t tasks[VEC_PARALLEL_MAX_THREADS];
+    vec_t* p_ret;
+    size_t i, num_tasks;
+    assert(NULL != p_fn);
+    p_ret = vec_alloc(p_vec->size, (0 == p_vec->size) ? DEFAULT_VEC_CAPACITY : p_vec->size);
+    num_tasks = bulk_split(tasks, p_vec, threads);
+    for (i = 0; i < num_tasks; i++)
+    {
+        tasks[i].env = env;
+        tasks[i].p_map = p_fn;
+        tasks[i].p_out = &p_ret->p_buffer[tasks[i].start];
+    }
+    run_tasks(tasks, sizeof(bulk_task_t), num_tasks, bulk_map_task);
+    return p_ret;
+}
+
+vec_t* vec_parallel_filter(vec_t* p_vec, vec_predfn_t p_fn, void* env, size_t threads)
+{
+    bulk_task_t tasks[VEC_PARALLEL_MAX_THREADS];
+    vec_t* p_ret;
+    size_t i, num_tasks;
+    assert(NULL != p_fn);
+    p_ret = vec_alloc(0, (0 == p_vec->size) ? DEFAULT_VEC_CAPACITY : p_vec->size);
+    num_tasks = bulk_split(tasks, p_vec, threads);
+    for (i = 0; i < num_tasks; i++)
+    {
+        tasks[i].env = env;
+        tasks[i].p_pred = p_fn;
+        tasks[i].p_out = &p_ret->p_buffer[tasks[i].start];
+    }
+    run_tasks(tasks, sizeof(bulk_task_t), num_tasks, bulk_filter_task);
+    /* Each range kept its elements at its own start, so close up the gaps */
+    for (i = 0; i < num_tasks; i++)
+    {
+        memmove(&p_ret->p_buffer[p_ret->size], tasks[i].p_out, sizeof(void*) * tasks[i].num_out);
+        p_ret->size += tasks[i].num_out;
+    }
+    /* Sized to the elements kept rather than to the input */
+    vec_shrink_to_fit(p_ret);
+    mem_retain_array(p_ret->p_buffer, p_ret->size);
+    return p_ret;
+}
+
+void* vec_parallel_reduce(vec_t* p_vec, vec_reducefn_t p_fn, vec_reducefn_t p_combine, void* env,
+                          void* p_init, size_t threads)
+{
+    bulk_task_t tasks[VEC_PARALLEL_MAX_THREADS];
+    void* p_acc;
+    size_t i, num_tasks;
+    assert((NULL != p_fn) && (NULL != p_combine));
+    num_tasks = bulk_split(tasks, p_vec, threads);
+    for (i = 0; i < num_tasks; i++)
+    {
+        tasks[i].env = env;
+        tasks[i].p_reduce = p_fn;
+        tasks[i].p_acc = p_init;
+    }
+    run_tasks(tasks, sizeof(bulk_task_t), num_tasks, bulk_reduce_task);
+    p_acc = tasks[0].p_acc;
+    for (i = 1; i < num_tasks; i++)
+        p_acc = p_combine(env, p_acc, tasks[i].p_acc);
+    return p_acc;
+}
+
+size_t vec_parallel_find_if(vec_t* p_vec, vec_predfn_t p_fn, void* env, size_t threads)
+{
+    bulk_task_t tasks[VEC_PARALLEL_MAX_THREADS];
+    size_t found = p_vec->size;
+    size_t i, num_tasks;
+    assert(NULL != p_fn);
+    num_tasks = bulk_split(tasks, p_vec, threads);
+    for (i = 0; i < num_tasks; i++)
+    {
+        tasks[i].env = env;
+        tasks[i].p_pred = p_fn;
+        tasks[i].p_found = &found;
+    }
+    run_tasks(tasks, sizeof(bulk_task_t), num_tasks, bulk_find_task);
+    return found;
+}
+
+/* Allocates a vector with room for capacity elements, the first size of
+ * which the caller fills in and the rest of which are zeroed */
+static vec_t* vec_alloc(size_t size, size_t capacity)
+{
+    vec_t* p_vec;
+    /* An arena vector may be copied out by mem_arena_promote, which would
+     * leave inline slots behind in the arena */
+    if ((capacity <= VEC_INLINE_SLOTS) && (NULL == mem_arena_current()))
+    {
+        p_vec = (vec_t*)mem_allocate(sizeof(vec_t) + (sizeof(void*) * capacity), vec_free);
+        assert(p_vec != NULL);
+        p_vec->p_buffer = (void**)(p_vec + 1);
+    }
+    else
+    {
+        p_vec = (vec_t*)mem_allocate(sizeof(vec_t), vec_free);
+        assert(p_vec != NULL);
+        p_vec->p_buffer = vec_buffer_resize(NULL, capacity);
+    }
+    p_vec->size = size;
+    p_vec->capacity = capacity;
+    p_vec->growth = 0;
+    memset(&p_vec->p_buffer[size], 0, sizeof(void*) * (capacity - size));
+    return p_vec;
+}
+
+static bool vec_is_inline(vec_t* p_vec)
+{
+    return (p_vec->p_buffer == (void**)(p_vec + 1));
+}
+
 static void vec_free(void* p_vec)
 {
     vec_t* p_vector = (vec_t*)p_vec;
     assert(NULL != p_vector);
     assert(NULL != p_vector->p_buffer);
     vec_clear(p_vector);
-    free(p_vector->p_buffer);
+    if (!vec_is_inline(p_vector))
+        vec_buffer_free(p_vector->p_buffer);
     p_vector->p_buffer = NULL;
 }
 
 static void vec_free_range(void** p_buffer, size_t start_idx, size_t end_idx)
 {
-    size_t i;
     assert(NULL != p_buffer);
-    for(i = start_idx; i < end_idx; i++)
+    if (start_idx < end_idx)
+    {
+        mem_release_array(&p_buffer[start_idx], end_idx - start_idx);
+        memset(&p_buffer[start_idx], 0, sizeof(void*) * (end_idx - start_idx));
+    }
+}
+
+
+/* Makes room for at least size elements, growing the capacity geometrically
+ * so that filling the vector one element at a time reallocates O(log n) times */
+static void vec_grow(vec_t* p_vec, size_t size)
+{
+    size_t percent = (0 == p_vec->growth) ? VEC_GROWTH_PERCENT : p_vec->growth;
+    size_t capacity;
+    if (size > p_vec->capacity)
+    {
+        capacity = ((p_vec->capacity / 100) * percent) + (((p_vec->capacity % 100) * percent) / 100);
+        vec_reserve(p_vec, (capacity > size) ? capacity : size);
+    }
+}
+
+static void** vec_buffer_resize(void** p_buffer, size_t num_elements)
+{
+    /* Large buffers are memory mapped, so growing them does not copy */
+#if (VEC_BUFFER_ALIGNMENT > 0)
+    if (NULL == p_buffer)
+        p_buffer = (void**)mem_allocate_aligned(sizeof(void*) * num_elements, VEC_BUFFER_ALIGNMENT, NULL);
+    else
+        p_buffer = (void**)mem_reallocate(p_buffer, sizeof(void*) * num_elements);
+#else
+    p_buffer = (void**)mem_reallocate(p_buffer, sizeof(void*) * num_elements);
+#endif
+    assert(p_buffer != NULL);
+    return p_buffer;
+}
+
+static void vec_buffer_free(void** p_buffer)
+{
+    mem_release(p_buffer);
+}
+
+static void vec_sort_elements(vec_t* p_vec, cmp_t* p_cmp, bool stable)
+{
+    long cpus = (VEC_SORT_THREADS > 0) ? VEC_SORT_THREADS : sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = 1;
+    size_t depth = 0;
+    size_t count;
+    assert((NULL != p_vec) && (NULL != p_cmp));
+    if (p_vec->size >= VEC_SORT_PARALLEL_THRESHOLD)
+    {
+        while (((threads * 2) <= (size_t)cpus) && ((threads * 2) <= VEC_SORT_MAX_THREADS))
+            threads *= 2;
+    }
+    if (threads > 1)
+    {
+        sort_parallel(p_vec->p_buffer, p_vec->size, p_cmp, stable, threads);
+    }
+    else if (stable)
+    {
+        void** p_tmp = (void**)malloc(sizeof(void*) * p_vec->size);
+        assert((NULL != p_tmp) || (0 == p_vec->size));
+        sort_stable(p_vec->p_buffer, p_tmp, p_vec->size, p_cmp);
+        free(p_tmp);
+    }
+    else
+    {
+        /* Quicksort gives way to heapsort after 2 log2(n) bad partitions */
+        for (count = p_vec->size; count > 1; count /= 2)
+            depth += 2;
+        sort_intro(p_vec->p_buffer, p_vec->size, depth, p_cmp);
+    }
+}
+
+static void sort_insertion(void** p_elems, size_t count, cmp_t* p_cmp)
+{
+    size_t i, j;
+    for (i = 1; i < count; i++)
+    {
+        void* p_elem = p_elems[i];
+        for (j = i; (j > 0) && SORT_LESS(p_cmp, p_elem, p_elems[j - 1]); j--)
+            p_elems[j] = p_elems[j - 1];
+        p_elems[j] = p_elem;
+    }
+}
+
+static void sort_sift_down(void** p_elems, size_t root, size_t count, cmp_t* p_cmp)
+{
+    void* p_elem = p_elems[root];
+    size_t child;
+    while ((child = (2 * root) + 1) < count)
+    {
+        if (((child + 1) < count) && SORT_LESS(p_cmp, p_elems[child], p_elems[child + 1]))
+            child++;
+        if (!SORT_LESS(p_cmp, p_elem, p_elems[child]))
+            break;
+        p_elems[root] = p_elems[child];
+        root = child;
+    }
+    p_elems[root] = p_elem;
+}
+
+static void sort_heap(void** p_elems, size_t count, cmp_t* p_cmp)
+{
+    size_t i;
+    for (i = count / 2; i > 0; i--)
+        sort_sift_down(p_elems, i - 1, count, p_cmp);
+    for (i = count; i > 1; i--)
+    {
+        void* p_top = p_elems[0];
+        p_elems[0] = p_elems[i - 1];
+        p_elems[i - 1] = p_top;
+        sort_sift_down(p_elems, 0, i - 1, p_cmp);
+    }
+}
+
+static void sort_swap(void** p_elems, size_t a, size_t b)
+{
+    void* p_elem = p_elems[a];
+    p_elems[a] = p_elems[b];
+    p_elems[b] = p_elem;
+}
+
+static void sort_intro(void** p_elems, size_t count, size_t depth, cmp_t* p_cmp)
+{
+    while (count > SORT_INSERTION_MAX)
+    {
+        size_t mid = (count - 1) / 2;
+        size_t lo = 0, hi = count - 1;
+        void* p_pivot;
+        if (0 == depth--)
+        {
+            sort_heap(p_elems, count, p_cmp);
+            return;
+        }
+        /* Take the median of the first, middle and last elements as pivot */
+        if (SORT_LESS(p_cmp, p_elems[mid], p_elems[0]))
+            sort_swap(p_elems, 0, mid);
+        if (SORT_LESS(p_cmp, p_elems[count - 1], p_elems[mid]))
+        {
+            sort_swap(p_elems, mid, count - 1);
+            if (SORT_LESS(p_cmp, p_elems[mid], p_elems[0]))
+                sort_swap(p_elems, 0, mid);
+        }
+        p_pivot = p_elems[mid];
+        /* Hoare partition into [0, hi] <= pivot <= [hi + 1, count) */
+        for (;;)
+        {
+            while (SORT_LESS(p_cmp, p_elems[lo], p_pivot))
+                lo++;
+            while (SORT_LESS(p_cmp, p_pivot, p_elems[hi]))
+                hi--;
+            if (lo >= hi)
+                break;
+            sort_swap(p_elems, lo++, hi--);
+        }
+        /* Recurse into the smaller side so the stack stays O(log n) deep */
+        if ((hi + 1) < (count - hi - 1))
+        {
+            sort_intro(p_elems, hi + 1, depth, p_cmp);
+            p_elems += hi + 1;
+            count -= hi + 1;
+        }
+        else
+        {
+            sort_intro(&p_elems[hi + 1], count - hi - 1, depth, p_cmp);
+            count = hi + 1;
+        }
+    }
+    sort_insertion(p_elems, count, p_cmp);
+}
+
+/* Takes from the left run on ties, which keeps the merge stable */
+static void sort_merge(void** p_dst, void** p_left, size_t num_left, void** p_right, size_t num_right, cmp_t* p_cmp)
+{
+    while ((num_left > 0) && (num_right > 0))
+    {
+        if (SORT_LESS(p_cmp, *p_right, *p_left))
+        {
+            *(p_dst++) = *(p_right++);
+            num_right--;
+        }
+        else
+        {
+            *(p_dst++) = *(p_left++);
+            num_left--;
+        }
+    }
+    memcpy(p_dst, p_left, sizeof(void*) * num_left);
+    memcpy(p_dst + num_left, p_right, sizeof(void*) * num_right);
+}
+
+/* Bottom up merge sort of runs first sorted by insertion */
+static void sort_stable(void** p_elems, void** p_tmp, size_t count, cmp_t* p_cmp)
+{
+    void** p_src = p_elems;
+    void** p_dst = p_tmp;
+    size_t width, i;
+    for (i = 0; i < count; i += SORT_INSERTION_MAX)
+        sort_insertion(&p_elems[i], ((count - i) < SORT_INSERTION_MAX) ? (count - i) : SORT_INSERTION_MAX, p_cmp);
+    for (width = SORT_INSERTION_MAX; width < count; width *= 2)
+    {
+        void** p_swap;
+        for (i = 0; i < count; i += 2 * width)
+        {
+            size_t mid = ((count - i) < width) ? count : (i + width);
+            size_t end = ((count - mid) < width) ? count : (mid + width);
+            sort_merge(&p_dst[i], &p_src[i], mid - i, &p_src[mid], end - mid, p_cmp);
+        }
+        p_swap = p_src;
+        p_src = p_dst;
+        p_dst = p_swap;
+    }
+    if (p_src != p_elems)
+        memcpy(p_elems, p_src, sizeof(void*) * count);
+}
+
+static void* sort_chunk_task(void* p_arg)
+{
+    sort_task_t* p_task = (sort_task_t*)p_arg;
+    size_t depth = 0;
+    size_t count;
+    if (p_task->stable)
+    {
+        sort_stable(p_task->p_src, p_task->p_dst, p_task->count, p_task->p_cmp);
+    }
+    else
+    {
+        for (count = p_task->count; count > 1; count /= 2)
+            depth += 2;
+        sort_intro(p_task->p_src, p_task->count, depth, p_task->p_cmp);
+    }
+    return NULL;
+}
+
+static void* sort_merge_task(void* p_arg)
+{
+    sort_task_t* p_task = (sort_task_t*)p_arg;
+    sort_merge(p_task->p_dst, p_task->p_src, p_task->split,
+               &p_task->p_src[p_task->split], p_task->count - p_task->split, p_task->p_cmp);
+    return NULL;
+}
+
+/* Claims and runs tasks from the batch until none are left unclaimed. Called
+ * and returns with the pool locked. */
+static void task_batch_run(task_batch_t* p_batch)
+{
+    while (p_batch->next < p_batch->num_tasks)
+    {
+        size_t i = p_batch->next++;
+        p_batch->running++;
+        pthread_mutex_unlock(&Task_Pool_Lock);
+        p_batch->p_fn(&p_batch->p_tasks[i * p_batch->task_size]);
+        pthread_mutex_lock(&Task_Pool_Lock);
+        if (0 == --p_batch->running)
+            pthread_cond_broadcast(&Task_Pool_Done);
+    }
+}
+
+static void* task_pool_worker(void* p_arg)
+{
+    (void)p_arg;
+    pthread_mutex_lock(&Task_Pool_Lock);
+    for (;;)
+    {
+        while ((NULL == Task_Pool_Batch) || (Task_Pool_Batch->next == Task_Pool_Batch->num_tasks))
+            pthread_cond_wait(&Task_Pool_Wake, &Task_Pool_Lock);
+        task_batch_run(Task_Pool_Batch);
+    }
+    return NULL;
+}
+
+/* Starts one worker fewer than the most tasks run at once, as the calling
+ * thread runs tasks too */
+static void task_pool_start(void)
+{
+    pthread_t thread;
+    size_t i;
+    for (i = 0; (i + 1) < VEC_MAX_TASKS; i++)
     {
-        if (NULL != p_buffer[i])
+        if (0 != pthread_create(&thread, NULL, task_pool_worker, NULL))
+            break;
+        pthread_detach(thread);
+    }
+    Task_Pool_Workers = i;
+}
+
+/* Runs the tasks on the pool's workers and the calling thread, returning once
+ * all have finished. The tasks run on the calling thread alone when the pool
+ * is busy with another operation, including the one calling, or has no
+ * workers. */
+static void run_tasks(void* p_tasks, size_t task_size, size_t num_tasks, void* (*p_fn)(void*))
+{
+    task_batch_t batch = { (uint8_t*)p_tasks, task_size, num_tasks, p_fn, 0, 0 };
+    assert(num_tasks <= VEC_MAX_TASKS);
+    if (num_tasks > 1)
+        pthread_once(&Task_Pool_Once, task_pool_start);
+    pthread_mutex_lock(&Task_Pool_Lock);
+    if ((num_tasks > 1) && (NULL == Task_Pool_Batch) && (Task_Pool_Workers > 0))
+    {
+        Task_Pool_Batch = &batch;
+        pthread_cond_broadcast(&Task_Pool_Wake);
+        task_batch_run(&batch);
+        while (batch.running > 0)
+            pthread_cond_wait(&Task_Pool_Done, &Task_Pool_Lock);
+        Task_Pool_Batch = NULL;
+        pthread_mutex_unlock(&Task_Pool_Lock);
+    }
+    else
+    {
+        pthread_mutex_unlock(&Task_Pool_Lock);
+        for (; batch.next < num_tasks; batch.next++)
+            p_fn(&batch.p_tasks[batch.next * task_size]);
+    }
+}
+
+/* Sorts one chunk per thread, then merges neighbouring chunks pairwise with
+ * half as many threads each round. The thread count is a power of two. */
+static void sort_parallel(void** p_elems, size_t count, cmp_t* p_cmp, bool stable, size_t threads)
+{
+    sort_task_t tasks[VEC_SORT_MAX_THREADS];
+    size_t bounds[VEC_SORT_MAX_THREADS + 1];
+    void** p_tmp = (void**)malloc(sizeof(void*) * count);
+    void** p_src = p_elems;
+    void** p_dst = p_tmp;
+    size_t i, width, num_tasks;
+    assert(NULL != p_tmp);
+    for (i = 0; i < threads; i++)
+        bounds[i] = (count / threads) * i;
+    bounds[threads] = count;
+    for (i = 0; i < threads; i++)
+    {
+        tasks[i].p_cmp  = p_cmp;
+        tasks[i].p_src  = &p_elems[bounds[i]];
+        tasks[i].p_dst  = &p_tmp[bounds[i]];
+        tasks[i].count  = bounds[i + 1] - bounds[i];
+        tasks[i].split  = 0;
+        tasks[i].stable = stable;
+    }
+    run_tasks(tasks, sizeof(sort_task_t), threads, sort_chunk_task);
+    for (width = 1; width < threads; width *= 2)
+    {
+        void** p_swap;
+        num_tasks = 0;
+        for (i = 0; i < threads; i += 2 * width)
         {
-            mem_release(p_buffer[i]);
-            p_buffer[i] = NULL;
+            tasks[num_tasks].p_src = &p_src[bounds[i]];
+            tasks[num_tasks].p_dst = &p_dst[bounds[i]];
+            tasks[num_tasks].count = bounds[i + (2 * width)] - bounds[i];
+            tasks[num_tasks].split = bounds[i + width] - bounds[i];
+            num_tasks++;
         }
+        run_tasks(tasks, sizeof(sort_task_t), num_tasks, sort_merge_task);
+        p_swap = p_src;
+        p_src = p_dst;
+        p_dst = p_swap;
     }
+    if (p_src != p_elems)
+        memcpy(p_elems, p_src, sizeof(void*) * count);
+    free(p_tmp);
 }
 
+/* Starts loading the object the visit will reach a few elements later.
+ * Prefetching never faults, so tagged integers and NULL are harmless. */
+static void bulk_prefetch(void** p_elems, size_t index, size_t count)
+{
+#if defined(__GNUC__) && (VEC_PREFETCH_DISTANCE > 0)
+    if ((index + VEC_PREFETCH_DISTANCE) < count)
+        __builtin_prefetch(p_elems[index + VEC_PREFETCH_DISTANCE]);
+#else
+    (void)p_elems;
+    (void)index;
+    (void)count;
+#endif
+}
+
+/* Splits the vector into one range per thread and returns the number of
+ * ranges, which is always at least one */
+static size_t bulk_split(bulk_task_t* p_tasks, vec_t* p_vec, size_t threads)
+{
+    long cpus;
+    size_t i;
+    assert(NULL != p_vec);
+    if (0 == threads)
+    {
+        cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (size_t)cpus : 1;
+    }
+    if (threads > VEC_PARALLEL_MAX_THREADS)
+        threads = VEC_PARALLEL_MAX_THREADS;
+    if (threads > (p_vec->size / VEC_PARALLEL_MIN_CHUNK))
+        threads = p_vec->size / VEC_PARALLEL_MIN_CHUNK;
+    if (0 == threads)
+        threads = 1;
+    memset(p_tasks, 0, sizeof(bulk_task_t) * threads);
+    for (i = 0; i < threads; i++)
+    {
+        p_tasks[i].start = (p_vec->size / threads) * i;
+        p_tasks[i].p_elems = &p_vec->p_buffer[p_tasks[i].start];
+    }
+    for (i = 0; (i + 1) < threads; i++)
+        p_tasks[i].count = p_tasks[i + 1].start - p_tasks[i].start;
+    p_tasks[threads - 1].count = p_vec->size - p_tasks[threads - 1].start;
+    return threads;
+}
+
+static void* bulk_foreach_task(void* p_arg)
+{
+    bulk_task_t* p_task = (bulk_task_t*)p_arg;
+    size_t i;
+    for (i = 0; i < p_task->count; i++)
+    {
+        bulk_prefetch(p_task->p_elems, i, p_task->count);
+        p_task->p_apply(p_task->env, p_task->p_elems[i]);
+    }
+    return NULL;
+}
+
+static void* bulk_map_task(void* p_arg)
+{
+    bulk_task_t* p_task = (bulk_task_t*)p_arg;
+    size_t i;
+    for (i = 0; i < p_task->count; i++)
+    {
+        bulk_prefetch(p_task->p_elems, i, p_task->count);
+        p_task->p_out[i] = p_task->p_map(p_task->env, p_task->p_elems[i]);
+    }
+    return NULL;
+}
+
+static void* bulk_filter_task(void* p_arg)
+{
+    bulk_task_t* p_task = (bulk_task_t*)p_arg;
+    size_t i;
+    for (i = 0; i < p_task->count; i++)
+    {
+        bulk_prefetch(p_task->p_elems, i, p_task->count);
+        if (p_task->p_pred(p_task->env, p_task->p_elems[i]))
+            p_task->p_out[p_task->num_out++] = p_task->p_elems[i];
+    }
+    return NULL;
+}
+
+static void* bulk_reduce_task(void* p_arg)
+{
+    bulk_task_t* p_task = (bulk_task_t*)p_arg;
+    void* p_acc = p_task->p_acc;
+    size_t i;
+    for (i = 0; i < p_task->count; i++)
+    {
+        bulk_prefetch(p_task->p_elems, i, p_task->count);
+        p_acc = p_task->p_reduce(p_task->env, p_acc, p_task->p_elems[i]);
+    }
+    p_task->p_acc = p_acc;
+    return NULL;
+}
+
+/* Lowers the shared index to the first match in the range. The range gives
+ * up once a range before it has matched, checking every few elements. */
+static void* bulk_find_task(void* p_arg)
+{
+    bulk_task_t* p_task = (bulk_task_t*)p_arg;
+    size_t found;
+    size_t i;
+    for (i = 0; i < p_task->count; i++)
+    {
+        if ((0 == (i % 64)) && (__atomic_load_n(p_task->p_found, __ATOMIC_RELAXED) < p_task->start))
+            break;
+        bulk_prefetch(p_task->p_elems, i, p_task->count);
+        if (p_task->p_pred(p_task->env, p_task->p_elems[i]))
+        {
+            found = __atomic_load_n(p_task->p_found, __ATOMIC_RELAXED);
+            while (((p_task->start + i) < found) &&
+                   !__atomic_compare_exchange_n(p_task->p_found, &found, p_task->start + i, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+            break;
+        }
+    }
+    return NULL;
+}
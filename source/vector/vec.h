@@ -10,6 +10,7 @@ extern "C" {
 #endif
 
 #include "rt.h"
+#include "cmp.h"
 #include <stdarg.h>
 
 /** A vector implementation */
@@ -17,14 +18,78 @@ typedef struct {
     size_t size;       /*< The number of elements currently in the array */
     size_t capacity;   /*< The size of the internal array */
     void** p_buffer;   /*< Pointer to the array */
+    unsigned growth;   /*< Capacity after growing as a percentage of before, 0 for the default */
 } vec_t;
 
+/** Functions called on each element by the bulk operations, with an
+ *  additional environment pointer */
+typedef void (*vec_applyfn_t)(void* env, void* p_elem);
+typedef void* (*vec_mapfn_t)(void* env, void* p_elem);
+typedef bool (*vec_predfn_t)(void* env, void* p_elem);
+typedef void* (*vec_reducefn_t)(void* env, void* p_acc, void* p_elem);
+
 /** The default capacity of the vector if no initializing elements have been
  *  provided. */
 #ifndef DEFAULT_VEC_CAPACITY
 #define DEFAULT_VEC_CAPACITY (size_t)8
 #endif
 
+/** The factor, as a percentage, by which a full vector's capacity grows
+ *  unless a different one was set with vec_set_growth */
+#ifndef VEC_GROWTH_PERCENT
+#define VEC_GROWTH_PERCENT 200u
+#endif
+
+/** Vectors created with at most this capacity keep their elements in slots
+ *  at the end of the vector object, so creating one makes a single
+ *  allocation. The elements move to a separate buffer once it outgrows them.
+ *  Zero, or a non-zero VEC_BUFFER_ALIGNMENT, always uses a separate buffer,
+ *  as do vectors created inside an arena scope, since mem_arena_promote
+ *  copies the vector without moving its buffer pointer. */
+#ifndef VEC_INLINE_CAPACITY
+#define VEC_INLINE_CAPACITY 8
+#endif
+
+/** Unless otherwise specified, the internal array is allocated on the heap
+ *  with mem_reallocate, which grows it without copying once it is memory
+ *  mapped. A non-zero value first allocates it with mem_allocate_aligned at
+ *  that alignment instead, eg. MEM_CACHE_LINE_SIZE. */
+#ifndef VEC_BUFFER_ALIGNMENT
+#define VEC_BUFFER_ALIGNMENT 0
+#endif
+
+/** Vectors with at least this many elements are sorted by several threads */
+#ifndef VEC_SORT_PARALLEL_THRESHOLD
+#define VEC_SORT_PARALLEL_THRESHOLD ((size_t)1 << 16)
+#endif
+
+/** The number of threads that sort a large vector, rounded down to a power of
+ *  two. Unless otherwise specified, one per online processor up to
+ *  VEC_SORT_MAX_THREADS. */
+#ifndef VEC_SORT_THREADS
+#define VEC_SORT_THREADS 0
+#endif
+
+#ifndef VEC_SORT_MAX_THREADS
+#define VEC_SORT_MAX_THREADS 8
+#endif
+
+/** The bulk operations start loading the object this many elements ahead of
+ *  the one being visited. Zero disables prefetching. */
+#ifndef VEC_PREFETCH_DISTANCE
+#define VEC_PREFETCH_DISTANCE 8
+#endif
+
+/** The parallel bulk operations give each thread at least this many
+ *  elements, so small vectors are processed on the calling thread alone */
+#ifndef VEC_PARALLEL_MIN_CHUNK
+#define VEC_PARALLEL_MIN_CHUNK ((size_t)1 << 14)
+#endif
+
+#ifndef VEC_PARALLEL_MAX_THREADS
+#define VEC_PARALLEL_MAX_THREADS 8
+#endif
+
 /**
  * @brief Creates a new vector initialized with the given elements.
  *
@@ -35,6 +100,19 @@ typedef struct {
  */
 vec_t* vec_new(size_t num_elements, ...);
 
+/**
+ * @brief Creates a new vector holding the elements of an array.
+ *
+ * The vector takes over the caller's reference to each element, as vec_new
+ * does.
+ *
+ * @param num_elements The number of elements in the array.
+ * @param p_elements The array of elements.
+ *
+ * @return Pointer to newly created vector.
+ */
+vec_t* vec_from_array(size_t num_elements, void** p_elements);
+
 /**
  * @brief Returns the number of items in the vector.
  *
@@ -78,6 +156,19 @@ void vec_resize(vec_t* p_vec, size_t size, void* data);
  */
 size_t vec_next_capacity(size_t req_size);
 
+/**
+ * @brief Sets the factor by which the vector's capacity grows when an
+ *        element is added to it while it is full.
+ *
+ * Capacity grows geometrically so that pushing n elements costs O(n)
+ * amortized. A factor of 150 percent wastes less memory than the default of
+ * 200 percent at the cost of growing more often.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param percent The new capacity as a percentage of the old, greater than 100.
+ */
+void vec_set_growth(vec_t* p_vec, unsigned percent);
+
 /**
  * @brief Shrinks the vector's capacity to equal it's size.
  *
@@ -97,6 +188,8 @@ size_t vec_capacity(vec_t* p_vec);
 /**
  * @brief Sets the minimum storage capacity of the vector to the given size.
  *
+ * The capacity is never reduced, use vec_shrink_to_fit for that.
+ *
  * @param p_vec Pointer to the vector.
  * @param size The size to reserve.
  */
@@ -131,9 +224,49 @@ bool vec_set(vec_t* p_vec, size_t index, void* data);
  */
 bool vec_insert(vec_t* p_vec, size_t index, size_t num_elements, ...);
 
+/**
+ * @brief Inserts the elements of an array at the given index.
+ *
+ * The buffer grows at most once and the elements are copied as one block.
+ * The vector takes over the caller's reference to each element.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param index Index at which the elements should be inserted, up to and
+ *              including the size of the vector.
+ * @param num_elements The number of elements in the array.
+ * @param p_elements The array of elements to insert.
+ *
+ * @return Whether the elements were inserted.
+ */
+bool vec_insert_array(vec_t* p_vec, size_t index, size_t num_elements, void** p_elements);
+
+/**
+ * @brief Appends the elements of an array to the end of the vector.
+ *
+ * Equivalent to vec_insert_array at the vector's size.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param num_elements The number of elements in the array.
+ * @param p_elements The array of elements to append.
+ */
+void vec_append_array(vec_t* p_vec, size_t num_elements, void** p_elements);
+
+/**
+ * @brief Appends every element of another vector to the end of the vector.
+ *
+ * The source vector is left unchanged and each element gains a reference for
+ * the destination. A vector may be extended with itself.
+ *
+ * @param p_vec Pointer to the destination vector.
+ * @param p_src Pointer to the vector whose elements are appended.
+ */
+void vec_extend(vec_t* p_vec, vec_t* p_src);
+
 /**
  * @brief Erases elements from the vector that fall into the given range.
  *
+ * The erased elements are released together with mem_release_array.
+ *
  * @param p_vec Pointer to the vector.
  * @param start_idx The start of the range.
  * @param end_idx The end of the range.
@@ -159,6 +292,208 @@ void vec_push_back(vec_t* p_vec, void* data);
  */
 void* vec_pop_back(vec_t* p_vec);
 
+/**
+ * @brief Sorts the vector in ascending order.
+ *
+ * Uses an introsort, which is O(n log n) in the worst case but does not
+ * keep equal elements in their original order. Vectors of at least
+ * VEC_SORT_PARALLEL_THRESHOLD elements are split into chunks sorted on
+ * separate threads and then merged, so the comparator must be safe to call
+ * concurrently.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_cmp The comparator ordering the elements. It is not released.
+ */
+void vec_sort(vec_t* p_vec, cmp_t* p_cmp);
+
+/**
+ * @brief Sorts the vector in ascending order, keeping equal elements in
+ *        their original order.
+ *
+ * Uses a merge sort with a temporary array the size of the vector, in
+ * parallel above the same threshold as vec_sort.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_cmp The comparator ordering the elements. It is not released.
+ */
+void vec_stable_sort(vec_t* p_vec, cmp_t* p_cmp);
+
+/**
+ * @brief Returns the index of the first element in a sorted vector that does
+ *        not compare less than the given value.
+ *
+ * @param p_vec Pointer to the vector, sorted by p_cmp.
+ * @param p_cmp The comparator the vector is sorted by.
+ * @param p_value The value to search for.
+ *
+ * @return The index found, or the vector's size if every element is less.
+ */
+size_t vec_lower_bound(vec_t* p_vec, cmp_t* p_cmp, void* p_value);
+
+/**
+ * @brief Returns the index of the first element in a sorted vector that
+ *        compares greater than the given value.
+ *
+ * @param p_vec Pointer to the vector, sorted by p_cmp.
+ * @param p_cmp The comparator the vector is sorted by.
+ * @param p_value The value to search for.
+ *
+ * @return The index found, or the vector's size if no element is greater.
+ */
+size_t vec_upper_bound(vec_t* p_vec, cmp_t* p_cmp, void* p_value);
+
+/**
+ * @brief Returns whether a sorted vector holds an element equal to the value.
+ *
+ * @param p_vec Pointer to the vector, sorted by p_cmp.
+ * @param p_cmp The comparator the vector is sorted by.
+ * @param p_value The value to search for.
+ *
+ * @return Whether an equal element was found.
+ */
+bool vec_binary_search(vec_t* p_vec, cmp_t* p_cmp, void* p_value);
+
+/**
+ * @brief Calls a function on every element in order.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The function to call.
+ * @param env The environment passed to the function.
+ */
+void vec_foreach(vec_t* p_vec, vec_applyfn_t p_fn, void* env);
+
+/**
+ * @brief Creates a new vector of the results of a function on every element.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The function to call, whose result's reference is taken over
+ *             by the new vector.
+ * @param env The environment passed to the function.
+ *
+ * @return The new vector, the same size as the input.
+ */
+vec_t* vec_map(vec_t* p_vec, vec_mapfn_t p_fn, void* env);
+
+/**
+ * @brief Creates a new vector of the elements that satisfy a predicate.
+ *
+ * The kept elements are retained by the new vector, which has room for every
+ * element of the input.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The predicate.
+ * @param env The environment passed to the predicate.
+ *
+ * @return The new vector.
+ */
+vec_t* vec_filter(vec_t* p_vec, vec_predfn_t p_fn, void* env);
+
+/**
+ * @brief Folds the elements in order into an accumulator.
+ *
+ * Each call is passed the previous call's result, or p_init for the first
+ * element. The accumulator is only passed through, so any references it
+ * holds are for the function to manage.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The function combining the accumulator with an element.
+ * @param env The environment passed to the function.
+ * @param p_init The initial accumulator.
+ *
+ * @return The final accumulator, or p_init if the vector is empty.
+ */
+void* vec_reduce(vec_t* p_vec, vec_reducefn_t p_fn, void* env, void* p_init);
+
+/**
+ * @brief Returns the index of the first element that satisfies a predicate.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The predicate.
+ * @param env The environment passed to the predicate.
+ *
+ * @return The index found, or the vector's size if no element matches.
+ */
+size_t vec_find_if(vec_t* p_vec, vec_predfn_t p_fn, void* env);
+
+/**
+ * @brief Calls a function on every element, split across several threads.
+ *
+ * The vector is split into one contiguous range per thread, each of at least
+ * VEC_PARALLEL_MIN_CHUNK elements, and the calls within a range are made in
+ * order. The function must be safe to call concurrently. This applies to
+ * each of the parallel bulk operations. The ranges are run by the calling
+ * thread and a pool of worker threads, started by the first operation to
+ * need them and kept for later ones, and all have finished before it
+ * returns. An operation that starts while the pool is busy with another,
+ * such as one called from within a range, runs on the calling thread alone.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The function to call.
+ * @param env The environment passed to the function.
+ * @param threads The number of threads to use, or 0 for one per online
+ *                processor, up to VEC_PARALLEL_MAX_THREADS.
+ */
+void vec_parallel_foreach(vec_t* p_vec, vec_applyfn_t p_fn, void* env, size_t threads);
+
+/**
+ * @brief The parallel version of vec_map.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The function to call.
+ * @param env The environment passed to the function.
+ * @param threads The number of threads to use, or 0 for the default.
+ *
+ * @return The new vector, the same size as the input.
+ */
+vec_t* vec_parallel_map(vec_t* p_vec, vec_mapfn_t p_fn, void* env, size_t threads);
+
+/**
+ * @brief The parallel version of vec_filter.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The predicate.
+ * @param env The environment passed to the predicate.
+ * @param threads The number of threads to use, or 0 for the default.
+ *
+ * @return The new vector, with the kept elements in their original order.
+ */
+vec_t* vec_parallel_filter(vec_t* p_vec, vec_predfn_t p_fn, void* env, size_t threads);
+
+/**
+ * @brief The parallel version of vec_reduce.
+ *
+ * Each range is folded from p_init with p_fn, so p_init must leave any
+ * accumulator it is combined with unchanged. The results of the ranges are
+ * then folded in order with p_combine on the calling thread.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The function combining an accumulator with an element.
+ * @param p_combine The function combining two accumulators.
+ * @param env The environment passed to both functions.
+ * @param p_init The initial accumulator for each range.
+ * @param threads The number of threads to use, or 0 for the default.
+ *
+ * @return The final accumulator, or p_init if the vector is empty.
+ */
+void* vec_parallel_reduce(vec_t* p_vec, vec_reducefn_t p_fn, vec_reducefn_t p_combine, void* env,
+                          void* p_init, size_t threads);
+
+/**
+ * @brief The parallel version of vec_find_if.
+ *
+ * A range stops early once a match is found in a range before it, so the
+ * predicate may be called on elements after the first match.
+ *
+ * @param p_vec Pointer to the vector.
+ * @param p_fn The predicate.
+ * @param env The environment passed to the predicate.
+ * @param threads The number of threads to use, or 0 for the default.
+ *
+ * @return The index of the first match, or the vector's size if no element
+ *         matches.
+ */
+size_t vec_parallel_find_if(vec_t* p_vec, vec_predfn_t p_fn, void* env, size_t threads);
+
 /**
  * @brief Erases all elements in the vector.
  *
@@ -4,7 +4,13 @@ int main(int argc, char** argv)
 {
     (void)argc;
     (void)argv;
+    RUN_TEST_SUITE(Mem);
+    RUN_TEST_SUITE(Epoch);
     RUN_TEST_SUITE(Vector);
+    RUN_TEST_SUITE(TypedVector);
+    RUN_TEST_SUITE(SegVector);
+    RUN_TEST_SUITE(GapVector);
+    RUN_TEST_SUITE(PersistentVector);
     RUN_TEST_SUITE(List);
     RUN_TEST_SUITE(Buffer);
     RUN_TEST_SUITE(String);
@@ -12,5 +18,7 @@ int main(int argc, char** argv)
     RUN_TEST_SUITE(Exn);
     RUN_TEST_SUITE(Set);
     RUN_TEST_SUITE(Map);
+    RUN_TEST_SUITE(FlatMap);
+    RUN_TEST_SUITE(FlatSet);
     return PRINT_TEST_RESULTS();
 }
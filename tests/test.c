@@ -5,6 +5,7 @@
   $HeadURL$
   */
 #include "test.h"
+#include "mem.h"
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,6 +14,7 @@ jmp_buf Landing_Pad;
 int Loop_Var;
 char* Curr_Test;
 test_results_t Test_Results = {0,0,0};
+int Num_Destructed;
 
 static const char* Results_String =
 "\nUnit Test Summary"
@@ -44,7 +46,9 @@ static void handle_signal(int sig) {
 }
 
 int test_start(void) {
-    int rval = setjmp(Landing_Pad);
+    int rval;
+    Num_Destructed = 0;
+    rval = setjmp(Landing_Pad);
     if(0 == rval) {
         signal(SIGABRT, handle_signal);
         signal(SIGBUS,  handle_signal);
@@ -71,3 +75,11 @@ void test_fail(char* expr, char* file, int line) {
     printf("%s:%d:0:%s:FAIL\n\t%s\n", file, line, Curr_Test, expr); \
 }
 
+void count_destructor(void* p_obj) {
+    (void)p_obj;
+    __atomic_add_fetch(&Num_Destructed, 1, __ATOMIC_RELAXED);
+}
+
+void* counted_object(void) {
+    return mem_allocate(sizeof(int), count_destructor);
+}
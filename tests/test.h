@@ -46,4 +46,13 @@ int test_start(void);
 int test_print_results(void);
 void test_fail(char* expr, char* file, int line);
 
+/* The number of objects count_destructor has finalized, reset before each
+ * test */
+extern int Num_Destructed;
+
+void count_destructor(void* p_obj);
+
+/* Allocates an object finalized by count_destructor */
+void* counted_object(void);
+
 #endif /* TEST_H */
@@ -25,6 +25,15 @@ TEST_SUITE(Buffer) {
         mem_release(buf);
     }
 
+#if (BUF_BUFFER_ALIGNMENT > 0)
+    TEST(Verify_buf_new_aligns_the_buffer)
+    {
+        buf_t* buf = buf_new(5);
+        CHECK( 0 == ((uintptr_t)buf->buffer % BUF_BUFFER_ALIGNMENT) );
+        mem_release(buf);
+    }
+#endif
+
     TEST(Verify_buf_new_returns_null_if_passed_a_size_of_0)
     {
         CHECK( NULL == buf_new(0) );
@@ -91,6 +100,29 @@ TEST_SUITE(Buffer) {
         mem_release(buf);
     }
 
+    TEST(Verify_buf_clear_frees_contents_that_wrap_around_the_end)
+    {
+        buf_t* buf = buf_new(3);
+        void* p_objs[3];
+        int refcounts[3];
+        int i;
+        for (i = 0; i < 3; i++)
+            p_objs[i] = mem_retain(mem_allocate(sizeof(int), NULL));
+        buf_write( buf, mem_allocate(sizeof(int), NULL) );
+        mem_release( buf_read( buf ) );
+        for (i = 0; i < 3; i++)
+            buf_write( buf, p_objs[i] );
+        buf_clear( buf );
+        for (i = 0; i < 3; i++) {
+            refcounts[i] = mem_refcount(p_objs[i]);
+            mem_release(p_objs[i]);
+        }
+        mem_release(buf);
+        CHECK( 1 == refcounts[0] );
+        CHECK( 1 == refcounts[1] );
+        CHECK( 1 == refcounts[2] );
+    }
+
     //-------------------------------------------------------------------------
     // Test buf_read function
     //-------------------------------------------------------------------------
@@ -0,0 +1,175 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "epoch.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_READERS 3
+#define NUM_SWAPS 20000
+#define OBJ_ALIVE 0x600DF00Du
+
+typedef struct {
+    unsigned int magic;
+} guarded_t;
+
+static guarded_t* Shared_Obj = NULL;
+static bool Done = false;
+static bool Reader_Inside = false;
+static bool Reader_Leave = false;
+static size_t Num_Dead_Reads = 0;
+
+static void test_setup(void) {
+    Num_Dead_Reads = 0;
+    Done = false;
+    Reader_Inside = false;
+    Reader_Leave = false;
+}
+
+static void guarded_destructor(void* p_obj) {
+    ((guarded_t*)p_obj)->magic = 0;
+}
+
+static guarded_t* guarded_new(void) {
+    guarded_t* p_obj = (guarded_t*)mem_allocate(sizeof(guarded_t), guarded_destructor);
+    p_obj->magic = OBJ_ALIVE;
+    return p_obj;
+}
+
+/* Stays inside a critical section until told to leave */
+static void* pinning_reader(void* p_arg) {
+    (void)p_arg;
+    mem_epoch_register();
+    mem_epoch_enter();
+    __atomic_store_n(&Reader_Inside, true, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&Reader_Leave, __ATOMIC_ACQUIRE))
+        sched_yield();
+    mem_epoch_exit();
+    mem_epoch_unregister();
+    return NULL;
+}
+
+/* Repeatedly reads the shared object, counting any it finds destructed */
+static void* checking_reader(void* p_arg) {
+    (void)p_arg;
+    mem_epoch_register();
+    while (!__atomic_load_n(&Done, __ATOMIC_ACQUIRE)) {
+        guarded_t* p_obj;
+        mem_epoch_enter();
+        p_obj = __atomic_load_n(&Shared_Obj, __ATOMIC_ACQUIRE);
+        if (OBJ_ALIVE != __atomic_load_n(&p_obj->magic, __ATOMIC_RELAXED))
+            __atomic_add_fetch(&Num_Dead_Reads, 1, __ATOMIC_RELAXED);
+        mem_epoch_exit();
+    }
+    mem_epoch_unregister();
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(Epoch) {
+    //-------------------------------------------------------------------------
+    // Test mem_retire function
+    //-------------------------------------------------------------------------
+    TEST(Verify_retired_objects_are_released_after_a_barrier)
+    {
+        int destructed;
+        mem_epoch_register();
+        mem_retire(counted_object());
+        destructed = Num_Destructed;
+        mem_epoch_barrier();
+        mem_epoch_unregister();
+        CHECK( 0 == destructed );
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_retire_only_releases_the_callers_reference)
+    {
+        void* p_obj = counted_object();
+        mem_epoch_register();
+        mem_retain(p_obj);
+        mem_retire(p_obj);
+        mem_epoch_barrier();
+        mem_epoch_unregister();
+        CHECK( 1 == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+    }
+
+    TEST(Verify_unregister_releases_pending_objects)
+    {
+        int i;
+        mem_epoch_register();
+        for (i = 0; i < 10; i++)
+            mem_retire(counted_object());
+        mem_epoch_unregister();
+        CHECK( 10 == Num_Destructed );
+    }
+
+    TEST(Verify_objects_are_not_released_while_a_reader_is_inside)
+    {
+        pthread_t reader;
+        size_t pending;
+        int destructed;
+        int i;
+        mem_epoch_register();
+        pthread_create(&reader, NULL, pinning_reader, NULL);
+        while (!__atomic_load_n(&Reader_Inside, __ATOMIC_ACQUIRE))
+            sched_yield();
+        mem_retire(counted_object());
+        for (i = 0; i < 10; i++)
+            mem_epoch_collect();
+        pending = mem_epoch_collect();
+        destructed = __atomic_load_n(&Num_Destructed, __ATOMIC_RELAXED);
+        __atomic_store_n(&Reader_Leave, true, __ATOMIC_RELEASE);
+        pthread_join(reader, NULL);
+        mem_epoch_barrier();
+        mem_epoch_unregister();
+        CHECK( 1 == pending );
+        CHECK( 0 == destructed );
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_nested_critical_sections_pin_until_the_outermost_exit)
+    {
+        size_t pending;
+        mem_epoch_register();
+        mem_epoch_enter();
+        mem_epoch_enter();
+        mem_retire(counted_object());
+        mem_epoch_exit();
+        mem_epoch_collect();
+        mem_epoch_collect();
+        pending = mem_epoch_collect();
+        mem_epoch_exit();
+        mem_epoch_barrier();
+        mem_epoch_unregister();
+        CHECK( 1 == pending );
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_readers_never_see_a_reclaimed_object_under_stress)
+    {
+        pthread_t readers[NUM_READERS];
+        int i;
+        mem_epoch_register();
+        Shared_Obj = guarded_new();
+        for (i = 0; i < NUM_READERS; i++)
+            pthread_create(&readers[i], NULL, checking_reader, NULL);
+        for (i = 0; i < NUM_SWAPS; i++) {
+            guarded_t* p_old = __atomic_exchange_n(&Shared_Obj, guarded_new(), __ATOMIC_ACQ_REL);
+            mem_retire(p_old);
+            if (0 == (i % 64))
+                sched_yield();
+        }
+        __atomic_store_n(&Done, true, __ATOMIC_RELEASE);
+        for (i = 0; i < NUM_READERS; i++)
+            pthread_join(readers[i], NULL);
+        mem_retire(Shared_Obj);
+        Shared_Obj = NULL;
+        mem_epoch_unregister();
+        CHECK( 0 == Num_Dead_Reads );
+    }
+}
@@ -0,0 +1,162 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "flatmap.h"
+
+static void test_setup(void) { }
+
+static int cmp_int(void* env, void* obja, void* objb) {
+    intptr_t inta = mem_unbox(obja);
+    intptr_t intb = mem_unbox(objb);
+    (void)env;
+    if (inta < intb)
+        return -1;
+    else if (intb < inta)
+        return 1;
+    else
+        return 0;
+}
+
+static flatmap_t* squares_map(void) {
+    void* keys[5]   = { mem_box(3), mem_box(1), mem_box(4), mem_box(0), mem_box(2) };
+    void* values[5] = { mem_box(9), mem_box(1), mem_box(16), mem_box(0), mem_box(4) };
+    return flatmap_from_arrays(cmp_new(NULL, cmp_int), 5, keys, values);
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(FlatMap) {
+    //-------------------------------------------------------------------------
+    // Test flatmap_new and flatmap_from_arrays functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatmap_new_returns_an_empty_map)
+    {
+        flatmap_t* map = flatmap_new(cmp_new(NULL, cmp_int));
+        CHECK(0 == flatmap_size(map));
+        CHECK(NULL == flatmap_key_at(map, 0));
+        mem_release(map);
+    }
+
+    TEST(Verify_flatmap_from_arrays_sorts_the_pairs_by_key)
+    {
+        flatmap_t* map = squares_map();
+        bool sorted = true;
+        intptr_t i;
+        for (i = 0; i < 5; i++) {
+            sorted = sorted && (i == mem_unbox(flatmap_key_at(map, (size_t)i)));
+            sorted = sorted && ((i * i) == mem_unbox(flatmap_value_at(map, (size_t)i)));
+        }
+        CHECK(sorted);
+        CHECK(5 == flatmap_size(map));
+        mem_release(map);
+    }
+
+    TEST(Verify_flatmap_from_arrays_keeps_the_first_of_duplicate_keys)
+    {
+        void* p_dup = counted_object();
+        void* keys[4]   = { mem_box(2), mem_box(1), mem_box(2), mem_box(1) };
+        void* values[4] = { mem_box(20), mem_box(10), p_dup, mem_box(11) };
+        flatmap_t* map = flatmap_from_arrays(cmp_new(NULL, cmp_int), 4, keys, values);
+        CHECK(2 == flatmap_size(map));
+        CHECK(10 == mem_unbox(flatmap_value_at(map, 0)));
+        CHECK(20 == mem_unbox(flatmap_value_at(map, 1)));
+        CHECK(1 == Num_Destructed);
+        mem_release(map);
+    }
+
+    TEST(Verify_flatmap_from_arrays_builds_an_empty_map)
+    {
+        flatmap_t* map = flatmap_from_arrays(cmp_new(NULL, cmp_int), 0, NULL, NULL);
+        void* key = mem_box(1);
+        CHECK(0 == flatmap_size(map));
+        flatmap_insert(map, mem_box(1), mem_box(2));
+        CHECK(2 == mem_unbox(flatmap_lookup(map, key)));
+        mem_release(key);
+        mem_release(map);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test flatmap_has_key and flatmap_lookup functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatmap_lookup_finds_the_value_for_each_key)
+    {
+        flatmap_t* map = squares_map();
+        bool found = true;
+        intptr_t i;
+        for (i = 0; i < 5; i++)
+        {
+            void* key = mem_box(i);
+            found = found && flatmap_has_key(map, key) &&
+                    ((i * i) == mem_unbox(flatmap_lookup(map, key)));
+            mem_release(key);
+        }
+        CHECK(found);
+        mem_release(map);
+    }
+
+    TEST(Verify_flatmap_lookup_returns_null_for_a_missing_key)
+    {
+        flatmap_t* map = squares_map();
+        void* missing = mem_box(5);
+        void* negative = mem_box(-1);
+        CHECK(!flatmap_has_key(map, missing));
+        CHECK(NULL == flatmap_lookup(map, missing));
+        CHECK(NULL == flatmap_lookup(map, negative));
+        mem_release(missing);
+        mem_release(negative);
+        mem_release(map);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test flatmap_insert function
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatmap_insert_keeps_the_keys_sorted)
+    {
+        flatmap_t* map = flatmap_new(cmp_new(NULL, cmp_int));
+        flatmap_insert(map, mem_box(5), mem_box(50));
+        flatmap_insert(map, mem_box(1), mem_box(10));
+        flatmap_insert(map, mem_box(3), mem_box(30));
+        CHECK(3 == flatmap_size(map));
+        CHECK(1 == mem_unbox(flatmap_key_at(map, 0)));
+        CHECK(3 == mem_unbox(flatmap_key_at(map, 1)));
+        CHECK(50 == mem_unbox(flatmap_value_at(map, 2)));
+        mem_release(map);
+    }
+
+    TEST(Verify_flatmap_insert_releases_the_pair_if_the_key_exists)
+    {
+        flatmap_t* map = squares_map();
+        void* key = mem_box(2);
+        flatmap_insert(map, mem_box(2), counted_object());
+        CHECK(5 == flatmap_size(map));
+        CHECK(4 == mem_unbox(flatmap_lookup(map, key)));
+        CHECK(1 == Num_Destructed);
+        mem_release(key);
+        mem_release(map);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test flatmap_delete function
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatmap_delete_removes_the_pair)
+    {
+        flatmap_t* map = squares_map();
+        void* key7 = mem_box(7);
+        void* key2 = mem_box(2);
+        void* key42 = mem_box(42);
+        flatmap_insert(map, mem_box(7), counted_object());
+        flatmap_delete(map, key7);
+        flatmap_delete(map, key2);
+        flatmap_delete(map, key42);
+        CHECK(4 == flatmap_size(map));
+        CHECK(!flatmap_has_key(map, key2));
+        CHECK(3 == mem_unbox(flatmap_key_at(map, 2)));
+        CHECK(1 == Num_Destructed);
+        mem_release(key7);
+        mem_release(key2);
+        mem_release(key42);
+        mem_release(map);
+    }
+}
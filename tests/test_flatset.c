@@ -0,0 +1,122 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "flatset.h"
+
+static void test_setup(void) { }
+
+static int cmp_int(void* env, void* obja, void* objb) {
+    intptr_t inta = mem_unbox(obja);
+    intptr_t intb = mem_unbox(objb);
+    (void)env;
+    if (inta < intb)
+        return -1;
+    else if (intb < inta)
+        return 1;
+    else
+        return 0;
+}
+
+/* Orders counted objects by address so duplicates can be told apart */
+static int cmp_ptr(void* env, void* obja, void* objb) {
+    (void)env;
+    return (obja == objb) ? 0 : (((uintptr_t)obja < (uintptr_t)objb) ? -1 : 1);
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(FlatSet) {
+    //-------------------------------------------------------------------------
+    // Test flatset_new and flatset_from_array functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatset_new_returns_an_empty_set)
+    {
+        flatset_t* set = flatset_new(cmp_new(NULL, cmp_int));
+        CHECK(0 == flatset_size(set));
+        CHECK(NULL == flatset_at(set, 0));
+        mem_release(set);
+    }
+
+    TEST(Verify_flatset_from_array_sorts_and_removes_duplicates)
+    {
+        void* values[6] = { mem_box(3), mem_box(1), mem_box(3), mem_box(2), mem_box(1), mem_box(0) };
+        flatset_t* set = flatset_from_array(cmp_new(NULL, cmp_int), 6, values);
+        bool sorted = true;
+        intptr_t i;
+        for (i = 0; i < 4; i++)
+            sorted = sorted && (i == mem_unbox(flatset_at(set, (size_t)i)));
+        CHECK(sorted);
+        CHECK(4 == flatset_size(set));
+        mem_release(set);
+    }
+
+    TEST(Verify_flatset_from_array_releases_duplicates)
+    {
+        void* p_obj = counted_object();
+        void* values[3] = { p_obj, mem_retain(p_obj), mem_retain(p_obj) };
+        flatset_t* set = flatset_from_array(cmp_new(NULL, cmp_ptr), 3, values);
+        int refcount = mem_refcount(p_obj);
+        CHECK(1 == flatset_size(set));
+        CHECK(1 == refcount);
+        mem_release(set);
+        CHECK(1 == Num_Destructed);
+    }
+
+    TEST(Verify_flatset_from_array_builds_an_empty_set)
+    {
+        flatset_t* set = flatset_from_array(cmp_new(NULL, cmp_int), 0, NULL);
+        void* value = mem_box(1);
+        CHECK(0 == flatset_size(set));
+        flatset_insert(set, mem_box(1));
+        CHECK(flatset_contains(set, value));
+        mem_release(value);
+        mem_release(set);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test flatset_contains function
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatset_contains_finds_only_members)
+    {
+        void* values[3] = { mem_box(30), mem_box(10), mem_box(20) };
+        flatset_t* set = flatset_from_array(cmp_new(NULL, cmp_int), 3, values);
+        void* probes[5] = { mem_box(10), mem_box(30), mem_box(15), mem_box(40), mem_box(0) };
+        CHECK(flatset_contains(set, probes[0]));
+        CHECK(flatset_contains(set, probes[1]));
+        CHECK(!flatset_contains(set, probes[2]));
+        CHECK(!flatset_contains(set, probes[3]));
+        CHECK(!flatset_contains(set, probes[4]));
+        mem_release_array(probes, 5);
+        mem_release(set);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test flatset_insert and flatset_delete functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_flatset_insert_keeps_the_members_sorted)
+    {
+        flatset_t* set = flatset_new(cmp_new(NULL, cmp_int));
+        flatset_insert(set, mem_box(5));
+        flatset_insert(set, mem_box(1));
+        flatset_insert(set, mem_box(3));
+        flatset_insert(set, mem_box(3));
+        CHECK(3 == flatset_size(set));
+        CHECK(1 == mem_unbox(flatset_at(set, 0)));
+        CHECK(3 == mem_unbox(flatset_at(set, 1)));
+        CHECK(5 == mem_unbox(flatset_at(set, 2)));
+        mem_release(set);
+    }
+
+    TEST(Verify_flatset_delete_removes_the_member)
+    {
+        void* p_obj = counted_object();
+        flatset_t* set = flatset_new(cmp_new(NULL, cmp_ptr));
+        flatset_insert(set, p_obj);
+        flatset_delete(set, p_obj);
+        CHECK(0 == flatset_size(set));
+        CHECK(1 == Num_Destructed);
+        mem_release(set);
+    }
+}
@@ -0,0 +1,235 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "gapvec.h"
+
+static void test_setup(void) { }
+
+static gapvec_t* counting_vec(size_t num_elements) {
+    gapvec_t* p_vec = gapvec_new();
+    size_t i;
+    for (i = 0; i < num_elements; i++)
+        gapvec_push_back(p_vec, counted_object());
+    return p_vec;
+}
+
+static gapvec_t* boxed_vec(size_t num_elements) {
+    gapvec_t* p_vec = gapvec_new();
+    size_t i;
+    for (i = 0; i < num_elements; i++)
+        gapvec_push_back(p_vec, mem_box((intptr_t)i));
+    return p_vec;
+}
+
+static intptr_t unbox_at(gapvec_t* p_vec, size_t index) {
+    return mem_unbox(gapvec_at(p_vec, index));
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(GapVector) {
+    //-------------------------------------------------------------------------
+    // Test gapvec_new function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_new_returns_an_empty_vector_with_default_capacity)
+    {
+        gapvec_t* p_vec = gapvec_new();
+        CHECK(NULL != p_vec);
+        CHECK(gapvec_empty(p_vec));
+        CHECK(DEFAULT_VEC_CAPACITY == gapvec_capacity(p_vec));
+        CHECK(0 == gapvec_cursor(p_vec));
+        CHECK(NULL == gapvec_at(p_vec, 0));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_push_back and gapvec_at functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_push_back_grows_the_capacity_geometrically)
+    {
+        gapvec_t* p_vec = boxed_vec(1000);
+        bool stored = true;
+        size_t i;
+        for (i = 0; i < 1000; i++)
+            stored = stored && ((intptr_t)i == unbox_at(p_vec, i));
+        CHECK(stored);
+        CHECK(1000 == gapvec_size(p_vec));
+        CHECK(1024 == gapvec_capacity(p_vec));
+        CHECK(NULL == gapvec_at(p_vec, 1000));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_insert function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_insert_inserts_elements_at_the_given_index)
+    {
+        gapvec_t* p_vec = boxed_vec(4);
+        void* elems[] = { mem_box(10), mem_box(11) };
+        CHECK(gapvec_insert(p_vec, 1, 2, elems));
+        CHECK(6 == gapvec_size(p_vec));
+        CHECK(3 == gapvec_cursor(p_vec));
+        CHECK(0 == unbox_at(p_vec, 0));
+        CHECK(10 == unbox_at(p_vec, 1));
+        CHECK(11 == unbox_at(p_vec, 2));
+        CHECK(1 == unbox_at(p_vec, 3));
+        CHECK(3 == unbox_at(p_vec, 5));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_gapvec_insert_follows_a_moving_cursor)
+    {
+        gapvec_t* p_vec = boxed_vec(10);
+        void* elem;
+        elem = mem_box(20);
+        CHECK(gapvec_insert(p_vec, 8, 1, &elem));
+        elem = mem_box(21);
+        CHECK(gapvec_insert(p_vec, 2, 1, &elem));
+        elem = mem_box(22);
+        CHECK(gapvec_insert(p_vec, 3, 1, &elem));
+        elem = mem_box(23);
+        CHECK(gapvec_insert(p_vec, 13, 1, &elem));
+        CHECK(14 == gapvec_size(p_vec));
+        CHECK(1 == unbox_at(p_vec, 1));
+        CHECK(21 == unbox_at(p_vec, 2));
+        CHECK(22 == unbox_at(p_vec, 3));
+        CHECK(2 == unbox_at(p_vec, 4));
+        CHECK(7 == unbox_at(p_vec, 9));
+        CHECK(20 == unbox_at(p_vec, 10));
+        CHECK(9 == unbox_at(p_vec, 12));
+        CHECK(23 == unbox_at(p_vec, 13));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_gapvec_insert_grows_the_gap_where_it_is)
+    {
+        gapvec_t* p_vec = boxed_vec(DEFAULT_VEC_CAPACITY);
+        void* elem = mem_box(42);
+        CHECK(gapvec_insert(p_vec, 1, 1, &elem));
+        CHECK(gapvec_capacity(p_vec) > DEFAULT_VEC_CAPACITY);
+        CHECK(2 == gapvec_cursor(p_vec));
+        CHECK(0 == unbox_at(p_vec, 0));
+        CHECK(42 == unbox_at(p_vec, 1));
+        CHECK(1 == unbox_at(p_vec, 2));
+        CHECK((intptr_t)(DEFAULT_VEC_CAPACITY - 1) == unbox_at(p_vec, DEFAULT_VEC_CAPACITY));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_gapvec_insert_should_do_nothing_if_index_out_of_range)
+    {
+        gapvec_t* p_vec = boxed_vec(2);
+        void* elem = NULL;
+        CHECK(!gapvec_insert(p_vec, 3, 1, &elem));
+        CHECK(2 == gapvec_size(p_vec));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_erase function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_erase_releases_and_removes_the_range)
+    {
+        gapvec_t* p_vec = counting_vec(5);
+        void* p_last = gapvec_at(p_vec, 4);
+        CHECK(gapvec_erase(p_vec, 1, 3));
+        CHECK(2 == gapvec_size(p_vec));
+        CHECK(3 == Num_Destructed);
+        CHECK(1 == gapvec_cursor(p_vec));
+        CHECK(p_last == gapvec_at(p_vec, 1));
+        mem_release(p_vec);
+        CHECK(5 == Num_Destructed);
+    }
+
+    TEST(Verify_gapvec_erase_and_insert_at_the_cursor_replace_elements)
+    {
+        gapvec_t* p_vec = boxed_vec(6);
+        void* elem = mem_box(30);
+        CHECK(gapvec_erase(p_vec, 4, 4));
+        CHECK(gapvec_erase(p_vec, 3, 3));
+        CHECK(gapvec_insert(p_vec, 3, 1, &elem));
+        CHECK(5 == gapvec_size(p_vec));
+        CHECK(2 == unbox_at(p_vec, 2));
+        CHECK(30 == unbox_at(p_vec, 3));
+        CHECK(5 == unbox_at(p_vec, 4));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_gapvec_erase_should_fail_if_end_index_is_out_of_range)
+    {
+        gapvec_t* p_vec = counting_vec(2);
+        CHECK(!gapvec_erase(p_vec, 0, 2));
+        CHECK(2 == gapvec_size(p_vec));
+        CHECK(0 == Num_Destructed);
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_set function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_set_skips_the_gap)
+    {
+        gapvec_t* p_vec = boxed_vec(4);
+        void* elem = mem_box(40);
+        CHECK(gapvec_erase(p_vec, 1, 1));
+        mem_release(gapvec_at(p_vec, 2));
+        CHECK(gapvec_set(p_vec, 2, mem_box(41)));
+        CHECK(gapvec_insert(p_vec, 1, 1, &elem));
+        CHECK(40 == unbox_at(p_vec, 1));
+        CHECK(2 == unbox_at(p_vec, 2));
+        CHECK(41 == unbox_at(p_vec, 3));
+        CHECK(!gapvec_set(p_vec, 4, NULL));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_reserve function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_reserve_keeps_the_elements_on_both_sides_of_the_gap)
+    {
+        gapvec_t* p_vec = boxed_vec(4);
+        CHECK(gapvec_erase(p_vec, 1, 1));
+        gapvec_reserve(p_vec, 100);
+        gapvec_reserve(p_vec, 10);
+        CHECK(100 == gapvec_capacity(p_vec));
+        CHECK(3 == gapvec_size(p_vec));
+        CHECK(0 == unbox_at(p_vec, 0));
+        CHECK(2 == unbox_at(p_vec, 1));
+        CHECK(3 == unbox_at(p_vec, 2));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_clear function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_clear_releases_every_element)
+    {
+        gapvec_t* p_vec = counting_vec(5);
+        CHECK(gapvec_erase(p_vec, 2, 2));
+        gapvec_clear(p_vec);
+        CHECK(gapvec_empty(p_vec));
+        CHECK(5 == Num_Destructed);
+        CHECK(0 == gapvec_cursor(p_vec));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test gapvec_to_vec function
+    //-------------------------------------------------------------------------
+    TEST(Verify_gapvec_to_vec_copies_the_elements_in_order)
+    {
+        gapvec_t* p_vec = counting_vec(4);
+        vec_t* p_copy;
+        CHECK(gapvec_erase(p_vec, 1, 1));
+        p_copy = gapvec_to_vec(p_vec);
+        CHECK(3 == vec_size(p_copy));
+        CHECK(gapvec_at(p_vec, 0) == vec_at(p_copy, 0));
+        CHECK(gapvec_at(p_vec, 1) == vec_at(p_copy, 1));
+        CHECK(gapvec_at(p_vec, 2) == vec_at(p_copy, 2));
+        mem_release(p_vec);
+        CHECK(1 == Num_Destructed);
+        mem_release(p_copy);
+        CHECK(4 == Num_Destructed);
+    }
+}
@@ -7,6 +7,22 @@
 
 static void test_setup(void) { }
 
+/* Checks that positional access and a walk of the list both find the
+ * expected values */
+static bool list_matches(list_t* list, intptr_t* expected, size_t count)
+{
+    bool matches = (count == list_size(list));
+    list_node_t* node = list->head;
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        list_node_t* at = list_at(list, i);
+        matches = matches && (node == at) && (NULL != at) && (expected[i] == mem_unbox(at->contents));
+        node = (NULL != node) ? node->next : NULL;
+    }
+    return matches && (NULL == node) && (NULL == list_at(list, count));
+}
+
 //-----------------------------------------------------------------------------
 // Begin Unit Tests
 //-----------------------------------------------------------------------------
@@ -901,4 +917,157 @@ TEST_SUITE(List) {
         mem_release(node3);
         mem_release(list);
     }
+
+    //-------------------------------------------------------------------------
+    // Test positional access on lists with an index
+    //-------------------------------------------------------------------------
+    TEST(Verify_list_size_is_kept_up_to_date_by_every_update)
+    {
+        list_t* list = list_new();
+        list_node_t* node = list_push_back(list, mem_box(1));
+        list_push_front(list, mem_box(0));
+        list_insert_after(list, node, mem_box(3));
+        list_insert(list, 2, mem_box(2));
+        CHECK( 4 == list_size(list) );
+        list_delete(list, 1);
+        mem_release(list_pop_front(list));
+        CHECK( 2 == list_size(list) );
+        list_delete_node(list, list->tail);
+        CHECK( 1 == list_size(list) );
+        list_clear(list);
+        CHECK( 0 == list_size(list) );
+        mem_release(list);
+    }
+
+    TEST(Verify_list_at_insert_and_delete_keep_a_large_list_in_order)
+    {
+        enum { NUM_NODES = 4 * LIST_INDEX_MIN_SIZE + 100 };
+        intptr_t expected[NUM_NODES + 64];
+        list_t* list = list_new();
+        list_node_t* node;
+        size_t count = 0, i;
+        uint32_t seed = 42;
+        for (count = 0; count < NUM_NODES; count++)
+        {
+            expected[count] = (intptr_t)count;
+            list_push_back(list, mem_box((intptr_t)count));
+        }
+        CHECK( list_matches(list, expected, count) );
+        /* Updates by index and at the ends keep the index in step */
+        for (i = 0; i < 64; i++)
+        {
+            size_t index;
+            seed = (seed * 1103515245u) + 12345u;
+            index = (seed >> 8) % (count + 1);
+            list_insert(list, index, mem_box(NUM_NODES + (intptr_t)i));
+            memmove(&expected[index + 1], &expected[index], sizeof(intptr_t) * (count - index));
+            expected[index] = NUM_NODES + (intptr_t)i;
+            count++;
+            seed = (seed * 1103515245u) + 12345u;
+            index = (seed >> 8) % count;
+            list_delete(list, index);
+            memmove(&expected[index], &expected[index + 1], sizeof(intptr_t) * (count - index - 1));
+            count--;
+        }
+        CHECK( list_matches(list, expected, count) );
+        mem_release(list_pop_front(list));
+        mem_release(list_pop_back(list));
+        list_push_front(list, mem_box(-1));
+        list_push_back(list, mem_box(-2));
+        expected[0] = -1;
+        expected[count - 1] = -2;
+        CHECK( list_matches(list, expected, count) );
+        /* Updates next to the node last found by position keep the index */
+        list_insert_after(list, list_at(list, 9), mem_box(-3));
+        memmove(&expected[11], &expected[10], sizeof(intptr_t) * (count - 10));
+        expected[10] = -3;
+        count++;
+        list_delete_node(list, list_at(list, 20));
+        memmove(&expected[20], &expected[21], sizeof(intptr_t) * (count - 21));
+        count--;
+        list_delete_node(list, list_at(list, 30)->prev);
+        memmove(&expected[29], &expected[30], sizeof(intptr_t) * (count - 30));
+        count--;
+        CHECK( (0 == LIST_INDEX_MIN_SIZE) || (NULL != list->index) );
+        CHECK( list_matches(list, expected, count) );
+        /* Updates next to any other node in the middle keep it too */
+        node = list_at(list, 40);
+        list_at(list, 100);
+        list_delete_node(list, node);
+        memmove(&expected[40], &expected[41], sizeof(intptr_t) * (count - 41));
+        count--;
+        CHECK( (0 == LIST_INDEX_MIN_SIZE) || (NULL != list->index) );
+        CHECK( list_matches(list, expected, count) );
+        mem_release(list);
+    }
+
+    TEST(Verify_list_at_stays_indexed_after_edits_next_to_other_nodes_in_the_middle)
+    {
+        enum { NUM_NODES = 4 * LIST_INDEX_MIN_SIZE + 100 };
+        intptr_t expected[NUM_NODES + 1];
+        list_t* list = list_new();
+        struct list_index_t* p_index;
+        size_t count = 0, i;
+        uint32_t seed = 7;
+        for (count = 0; count < NUM_NODES; count++)
+        {
+            expected[count] = (intptr_t)count;
+            list_push_back(list, mem_box((intptr_t)count));
+        }
+        for (i = 0; (i < 64) && (NULL == list->index); i++)
+            list_at(list, count / 2);
+        p_index = list->index;
+        CHECK( (0 == LIST_INDEX_MIN_SIZE) || (NULL != p_index) );
+        /* Each edit is next to a node found before the finger moved elsewhere */
+        for (i = 0; i < 256; i++)
+        {
+            size_t index;
+            list_node_t* node;
+            seed = (seed * 1103515245u) + 12345u;
+            index = (seed >> 8) % count;
+            node = list_at(list, index);
+            seed = (seed * 1103515245u) + 12345u;
+            CHECK( expected[(seed >> 8) % count] == mem_unbox(list_at(list, (seed >> 8) % count)->contents) );
+            if (0 == (i & 1))
+            {
+                list_insert_after(list, node, mem_box(NUM_NODES + (intptr_t)i));
+                memmove(&expected[index + 2], &expected[index + 1], sizeof(intptr_t) * (count - index - 1));
+                expected[index + 1] = NUM_NODES + (intptr_t)i;
+                count++;
+            }
+            else
+            {
+                list_delete_node(list, node);
+                memmove(&expected[index], &expected[index + 1], sizeof(intptr_t) * (count - index - 1));
+                count--;
+            }
+        }
+        CHECK( p_index == list->index );
+        CHECK( list_matches(list, expected, count) );
+        mem_release(list);
+    }
+
+    TEST(Verify_list_insert_should_release_contents_if_index_out_of_range_of_a_large_list)
+    {
+        list_t* list = list_new();
+        size_t i;
+        for (i = 0; i < LIST_INDEX_MIN_SIZE + 100; i++)
+            list_push_back(list, mem_box((intptr_t)i));
+        CHECK( NULL != list_at(list, 0) );
+        CHECK( NULL == list_insert(list, LIST_INDEX_MIN_SIZE + 100 + 1, mem_box(0x1234)) );
+        CHECK( LIST_INDEX_MIN_SIZE + 100 == list_size(list) );
+        mem_release(list);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test list destruction
+    //-------------------------------------------------------------------------
+    TEST(Verify_releasing_a_list_of_a_million_nodes_does_not_overflow_the_stack)
+    {
+        list_t* list = list_new();
+        int i;
+        for (i = 0; i < 1000000; i++)
+            list_push_back(list, mem_box(i));
+        mem_release(list);
+    }
 }
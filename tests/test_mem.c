@@ -0,0 +1,914 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "mem.h"
+#include <pthread.h>
+
+#define NUM_THREADS 4
+#define NUM_RETAINS 100000
+#define CHAIN_LENGTH 1000000
+#define NUM_HANDOFFS (4 * MEM_SLAB_MAGAZINE_SIZE)
+
+static void test_setup(void) { }
+
+typedef struct {
+    void* p_child;
+} parent_t;
+
+static void parent_destructor(void* p_obj) {
+    Num_Destructed++;
+    mem_release(((parent_t*)p_obj)->p_child);
+}
+
+static parent_t* new_chain(int length) {
+    parent_t* p_head = NULL;
+    int i;
+    for (i = 0; i < length; i++) {
+        parent_t* p_parent = (parent_t*)mem_allocate(sizeof(parent_t), parent_destructor);
+        p_parent->p_child = p_head;
+        p_head = p_parent;
+    }
+    return p_head;
+}
+
+static void* retain_release_worker(void* p_obj) {
+    int i;
+    for (i = 0; i < NUM_RETAINS; i++)
+        mem_retain(p_obj);
+    for (i = 0; i < NUM_RETAINS; i++)
+        mem_release(p_obj);
+    return NULL;
+}
+
+#if (MEM_BIASED_REFCOUNT > 0)
+static void* retain_worker(void* p_obj) {
+    mem_retain(p_obj);
+    return NULL;
+}
+
+static void* release_worker(void* p_obj) {
+    mem_release(p_obj);
+    return NULL;
+}
+
+static void* allocate_worker(void* p_arg) {
+    (void)p_arg;
+    return mem_allocate(sizeof(int), count_destructor);
+}
+#endif
+
+#if (MEM_SLAB_ALLOCATOR > 0)
+static void* release_all_worker(void* p_arg) {
+    void** p_objs = (void**)p_arg;
+    int i;
+    for (i = 0; i < NUM_HANDOFFS; i++)
+        mem_release(p_objs[i]);
+    return NULL;
+}
+
+static void* churn_worker(void* p_arg) {
+    void* p_objs[NUM_HANDOFFS];
+    int i, j;
+    (void)p_arg;
+    for (i = 0; i < 100; i++) {
+        for (j = 0; j < NUM_HANDOFFS; j++)
+            p_objs[j] = mem_allocate((size_t)(j % 64), NULL);
+        for (j = 0; j < NUM_HANDOFFS; j++)
+            mem_release(p_objs[j]);
+    }
+    return NULL;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(Mem) {
+    //-------------------------------------------------------------------------
+    // Test mem_allocate function
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_allocate_returns_an_object_with_a_refcount_of_one)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        CHECK( NULL != p_obj );
+        CHECK( 1 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+    }
+
+    TEST(Verify_mem_allocate_returns_usable_memory_for_small_and_large_sizes)
+    {
+        size_t sizes[] = { 0, 1, 16, 24, 40, 128, 129, 4096 };
+        size_t i;
+        for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+            char* p_obj = (char*)mem_allocate(sizes[i], NULL);
+            memset(p_obj, 0x5A, sizes[i]);
+            CHECK( 1 == mem_refcount(p_obj) );
+            mem_release(p_obj);
+        }
+    }
+
+    TEST(Verify_mem_allocate_returns_pointer_aligned_objects)
+    {
+        void* p_obj = mem_allocate(24, NULL);
+        CHECK( 0 == ((uintptr_t)p_obj % sizeof(void*)) );
+        mem_release(p_obj);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_retain and mem_release functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_retain_increments_the_refcount)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        CHECK( p_obj == mem_retain(p_obj) );
+        CHECK( 2 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+        mem_release(p_obj);
+    }
+
+    TEST(Verify_mem_release_calls_the_destructor_when_the_last_reference_is_released)
+    {
+        void* p_obj = mem_allocate(sizeof(int), count_destructor);
+        mem_retain(p_obj);
+        mem_release(p_obj);
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_release_ignores_null)
+    {
+        mem_release(NULL);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_retain_n and mem_release_array functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_retain_n_adds_count_references)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        void* objs[6] = { p_obj, p_obj, p_obj, p_obj, p_obj, p_obj };
+        int refcount;
+        CHECK( p_obj == mem_retain_n(p_obj, 5) );
+        mem_retain_n(p_obj, 0);
+        refcount = mem_refcount(p_obj);
+        mem_release_array(objs, 6);
+        CHECK( 6 == refcount );
+    }
+
+    TEST(Verify_mem_retain_array_retains_each_entry_and_skips_null)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        void* p_other = mem_allocate(sizeof(int), NULL);
+        void* objs[5] = { p_obj, p_obj, NULL, p_other, p_obj };
+        int refcount, other_refcount;
+        mem_retain_array(objs, 5);
+        refcount = mem_refcount(p_obj);
+        other_refcount = mem_refcount(p_other);
+        mem_release_array(objs, 5);
+        mem_release(p_obj);
+        mem_release(p_other);
+        CHECK( 4 == refcount );
+        CHECK( 2 == other_refcount );
+    }
+
+    TEST(Verify_mem_release_array_releases_repeated_objects_once_each)
+    {
+        void* p_obj = mem_allocate(sizeof(int), count_destructor);
+        void* objs[4] = { p_obj, p_obj, p_obj, p_obj };
+        int refcount, destructed;
+        mem_retain_n(p_obj, 4);
+        mem_release_array(objs, 4);
+        refcount = mem_refcount(p_obj);
+        destructed = Num_Destructed;
+        mem_release(p_obj);
+        CHECK( 1 == refcount );
+        CHECK( 0 == destructed );
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_release_array_destructs_objects_whose_last_reference_it_holds)
+    {
+        void* p_kept = mem_allocate(sizeof(int), count_destructor);
+        void* objs[200];
+        int i, refcount;
+        for (i = 0; i < 200; i++)
+            objs[i] = (0 == (i % 3)) ? NULL : mem_allocate(sizeof(int), count_destructor);
+        mem_release(objs[1]);
+        objs[1] = mem_retain(p_kept);
+        mem_release(objs[2]);
+        objs[2] = mem_retain(p_kept);
+        mem_release_array(objs, 200);
+        refcount = mem_refcount(p_kept);
+        mem_release(p_kept);
+        CHECK( 1 == refcount );
+        CHECK( 134 == Num_Destructed );
+        CHECK( 0 == mem_drain(SIZE_MAX) );
+    }
+
+    TEST(Verify_mem_release_array_ignores_an_empty_array)
+    {
+        mem_release_array(NULL, 0);
+    }
+
+#if (MEM_SLAB_ALLOCATOR > 0)
+    TEST(Verify_mem_release_recycles_small_objects_through_the_slab)
+    {
+        void* p_obj1 = mem_allocate(24, NULL);
+        void* p_obj2;
+        mem_release(p_obj1);
+        p_obj2 = mem_allocate(20, NULL);
+        CHECK( p_obj1 == p_obj2 );
+        mem_release(p_obj2);
+    }
+
+    TEST(Verify_mem_allocate_does_not_mix_size_classes)
+    {
+        void* p_obj1 = mem_allocate(16, NULL);
+        void* p_obj2;
+        mem_release(p_obj1);
+        p_obj2 = mem_allocate(48, NULL);
+        CHECK( p_obj1 != p_obj2 );
+        mem_release(p_obj2);
+    }
+
+    TEST(Verify_blocks_released_on_another_thread_are_reused_after_it_exits)
+    {
+        void* p_objs[NUM_HANDOFFS];
+        void* p_reused[NUM_HANDOFFS];
+        pthread_t thread;
+        bool found = false;
+        int i, j;
+        for (i = 0; i < NUM_HANDOFFS; i++)
+            p_objs[i] = mem_allocate(40, NULL);
+        pthread_create(&thread, NULL, release_all_worker, p_objs);
+        pthread_join(thread, NULL);
+        /* Whatever this thread had cached is used up before the depot */
+        for (i = 0; i < NUM_HANDOFFS; i++)
+            p_reused[i] = mem_allocate(40, NULL);
+        for (i = 0; i < NUM_HANDOFFS; i++)
+            for (j = 0; j < NUM_HANDOFFS; j++)
+                found = found || (p_reused[i] == p_objs[j]);
+        for (i = 0; i < NUM_HANDOFFS; i++)
+            mem_release(p_reused[i]);
+        CHECK( found );
+    }
+
+    TEST(Verify_many_threads_can_allocate_and_release_small_objects_concurrently)
+    {
+        pthread_t threads[NUM_THREADS];
+        int i;
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_create(&threads[i], NULL, churn_worker, NULL);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_join(threads[i], NULL);
+        CHECK( 0 == Num_Destructed );
+    }
+#endif
+
+    TEST(Verify_mem_release_destructs_long_chains_without_recursing)
+    {
+        mem_release(new_chain(CHAIN_LENGTH));
+        CHECK( CHAIN_LENGTH == Num_Destructed );
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_defer and mem_drain functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_drain_frees_at_most_budget_objects)
+    {
+        parent_t* p_chain = new_chain(10);
+        int released, drained;
+        size_t remaining;
+        mem_defer(true);
+        mem_release(p_chain);
+        released = Num_Destructed;
+        remaining = mem_drain(3);
+        drained = Num_Destructed;
+        mem_defer(false);
+        CHECK( 0 == released );
+        CHECK( 3 == drained );
+        CHECK( 1 == remaining );
+        CHECK( 0 == mem_drain(SIZE_MAX) );
+        CHECK( 10 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_drain_returns_zero_when_nothing_is_queued)
+    {
+        CHECK( 0 == mem_drain(1) );
+    }
+
+    TEST(Verify_mem_release_drains_immediately_when_not_deferred)
+    {
+        mem_release(new_chain(10));
+        CHECK( 10 == Num_Destructed );
+        CHECK( 0 == mem_drain(SIZE_MAX) );
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_share function
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_share_returns_the_object_with_its_refcount_intact)
+    {
+        void* p_obj = mem_allocate(sizeof(int), count_destructor);
+        CHECK( p_obj == mem_share(p_obj) );
+        CHECK( 1 == mem_refcount(p_obj) );
+        mem_retain(p_obj);
+        CHECK( 2 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_shared_objects_can_be_retained_and_released_from_many_threads)
+    {
+        pthread_t threads[NUM_THREADS];
+        void* p_obj = mem_share(mem_allocate(sizeof(int), count_destructor));
+        int i;
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_create(&threads[i], NULL, retain_release_worker, p_obj);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_join(threads[i], NULL);
+        CHECK( 1 == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+#if (MEM_BIASED_REFCOUNT > 0)
+    //-------------------------------------------------------------------------
+    // Test biased reference counting
+    //-------------------------------------------------------------------------
+    TEST(Verify_unshared_objects_can_be_retained_and_released_from_many_threads)
+    {
+        pthread_t threads[NUM_THREADS];
+        void* p_obj = mem_allocate(sizeof(int), count_destructor);
+        int i;
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_create(&threads[i], NULL, retain_release_worker, p_obj);
+        retain_release_worker(p_obj);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_join(threads[i], NULL);
+        CHECK( 1 == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_releases_on_other_threads_are_merged_back_by_the_owner)
+    {
+        pthread_t thread;
+        void* p_obj = mem_retain(mem_allocate(sizeof(int), count_destructor));
+        pthread_create(&thread, NULL, release_worker, p_obj);
+        pthread_join(thread, NULL);
+        CHECK( 1 == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_objects_outliving_their_owners_references_are_reclaimed_elsewhere)
+    {
+        pthread_t thread;
+        void* p_obj = mem_allocate(sizeof(int), count_destructor);
+        int destructed;
+        pthread_create(&thread, NULL, retain_worker, p_obj);
+        pthread_join(thread, NULL);
+        mem_release(p_obj);
+        destructed = Num_Destructed;
+        pthread_create(&thread, NULL, release_worker, p_obj);
+        pthread_join(thread, NULL);
+        CHECK( 0 == destructed );
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_objects_owned_by_an_exited_thread_are_reclaimed_by_others)
+    {
+        pthread_t thread;
+        void* p_obj;
+        pthread_create(&thread, NULL, allocate_worker, NULL);
+        pthread_join(thread, &p_obj);
+        mem_retain(p_obj);
+        mem_release(p_obj);
+        CHECK( 1 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+#endif
+
+    //-------------------------------------------------------------------------
+    // Test mem_make_immortal function (immortal objects are kept in statics
+    // so the leak checkers still see them as reachable)
+    //-------------------------------------------------------------------------
+    TEST(Verify_immortal_objects_are_never_destructed)
+    {
+        static void* p_obj;
+        int refcount;
+        p_obj = mem_make_immortal(mem_allocate(sizeof(int), count_destructor));
+        refcount = mem_refcount(p_obj);
+        mem_retain(p_obj);
+        mem_release(p_obj);
+        mem_release(p_obj);
+        mem_release(p_obj);
+        CHECK( refcount == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+    }
+
+    TEST(Verify_immortal_shared_objects_are_untouched_by_many_threads)
+    {
+        pthread_t threads[NUM_THREADS];
+        static void* p_obj;
+        int refcount;
+        int i;
+        p_obj = mem_make_immortal(mem_share(mem_allocate(sizeof(int), count_destructor)));
+        refcount = mem_refcount(p_obj);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_create(&threads[i], NULL, retain_release_worker, p_obj);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_join(threads[i], NULL);
+        mem_release(p_obj);
+        CHECK( refcount == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_make_immortal_moves_arena_objects_to_the_heap)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        static int* p_immortal;
+        int* p_obj;
+        mem_arena_enter(p_arena);
+        p_obj = (int*)mem_allocate(sizeof(int), count_destructor);
+        *p_obj = 42;
+        p_immortal = (int*)mem_make_immortal(p_obj);
+        mem_arena_exit(p_arena);
+        mem_release(p_arena);
+        CHECK( p_immortal != p_obj );
+        CHECK( 42 == *p_immortal );
+        CHECK( 0 == Num_Destructed );
+    }
+
+#if (LEAK_DETECT_LEVEL > 0)
+    TEST(Verify_immortal_objects_are_not_counted_as_live)
+    {
+        static void* p_obj;
+        mem_stats_t before, after;
+        mem_stats(&before);
+        p_obj = mem_make_immortal(mem_allocate(sizeof(int), NULL));
+        (void)p_obj;
+        mem_stats(&after);
+        CHECK( before.live_objects == after.live_objects );
+        CHECK( before.live_bytes == after.live_bytes );
+    }
+#endif
+
+#if (MEM_COMPACT_HEADER == 0)
+    TEST(Verify_mem_allocate_aligns_payloads_like_malloc)
+    {
+        void* p_first = mem_allocate(sizeof(long double), NULL);
+        void* p_second = mem_allocate(1, NULL);
+        uintptr_t first = (uintptr_t)p_first;
+        uintptr_t second = (uintptr_t)p_second;
+        mem_release(p_first);
+        mem_release(p_second);
+        CHECK( 0 == (first % 16) );
+        CHECK( 0 == (second % 16) );
+    }
+#endif
+
+    //-------------------------------------------------------------------------
+    // Test mem_allocate_aligned function
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_allocate_aligned_returns_an_aligned_payload)
+    {
+        void* p_line = mem_allocate_aligned(24, MEM_CACHE_LINE_SIZE, NULL);
+        void* p_page = mem_allocate_aligned(100, 4096, NULL);
+        void* p_small = mem_allocate_aligned(8, 8, NULL);
+        uintptr_t line = (uintptr_t)p_line;
+        uintptr_t page = (uintptr_t)p_page;
+        uintptr_t small = (uintptr_t)p_small;
+        memset(p_page, 0xFF, 100);
+        mem_release(p_line);
+        mem_release(p_page);
+        mem_release(p_small);
+        CHECK( 0 == (line % MEM_CACHE_LINE_SIZE) );
+        CHECK( 0 == (page % 4096) );
+        CHECK( 0 == (small % 8) );
+    }
+
+    TEST(Verify_aligned_objects_are_reference_counted_and_destructed)
+    {
+        void* p_obj = mem_allocate_aligned(sizeof(int), 256, count_destructor);
+        mem_retain(p_obj);
+        CHECK( 2 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_aligned_objects_in_an_arena_stay_aligned_when_promoted)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        int* p_obj;
+        int* p_big;
+        int* p_copy;
+        mem_arena_enter(p_arena);
+        mem_allocate(1, NULL);
+        p_obj = (int*)mem_allocate_aligned(sizeof(int), 128, count_destructor);
+        p_big = (int*)mem_allocate_aligned(MEM_ARENA_CHUNK_SIZE, 128, NULL);
+        *p_obj = 42;
+        mem_arena_exit(p_arena);
+        p_copy = (int*)mem_arena_promote(p_obj);
+        CHECK( 0 == ((uintptr_t)p_obj % 128) );
+        CHECK( 0 == ((uintptr_t)p_big % 128) );
+        CHECK( 0 == ((uintptr_t)p_copy % 128) );
+        CHECK( 42 == *p_copy );
+        mem_release(p_arena);
+        mem_release(p_copy);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_reallocate function
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_reallocate_keeps_the_contents_and_destructor)
+    {
+        uint8_t* p_obj = (uint8_t*)mem_allocate(64, count_destructor);
+        bool intact;
+        memset(p_obj, 0x5A, 64);
+        p_obj = (uint8_t*)mem_reallocate(p_obj, 4096);
+        intact = (0x5A == p_obj[0]) && (0x5A == p_obj[63]);
+        p_obj[4095] = 0;
+        p_obj = (uint8_t*)mem_reallocate(p_obj, 32);
+        intact = intact && (0x5A == p_obj[31]) && (1 == mem_refcount(p_obj));
+        mem_release(p_obj);
+        CHECK( intact );
+        CHECK( 1 == Num_Destructed );
+    }
+
+#if (MEM_MMAP_THRESHOLD > 0)
+    TEST(Verify_mem_reallocate_moves_objects_past_the_threshold_into_a_mapping)
+    {
+        size_t size = 2 * MEM_MMAP_THRESHOLD;
+        uint8_t* p_obj = (uint8_t*)mem_allocate(100, count_destructor);
+        bool intact;
+        memset(p_obj, 0x5A, 100);
+        p_obj = (uint8_t*)mem_reallocate(p_obj, size);
+        intact = (0x5A == p_obj[0]) && (0x5A == p_obj[99]);
+        memset(p_obj, 0xA5, size);
+        p_obj = (uint8_t*)mem_reallocate(p_obj, 4 * size);
+        intact = intact && (0xA5 == p_obj[0]) && (0xA5 == p_obj[size - 1]);
+        p_obj[(4 * size) - 1] = 0;
+        p_obj = (uint8_t*)mem_reallocate(p_obj, 100);
+        intact = intact && (0xA5 == p_obj[99]);
+        mem_release(p_obj);
+        CHECK( intact );
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_reallocate_keeps_over_aligned_mappings_aligned)
+    {
+        void* p_obj = mem_allocate_aligned(MEM_MMAP_THRESHOLD, 256, NULL);
+        uintptr_t mapped = (uintptr_t)p_obj;
+        uintptr_t grown;
+        p_obj = mem_reallocate(p_obj, 8 * MEM_MMAP_THRESHOLD);
+        grown = (uintptr_t)p_obj;
+        mem_release(p_obj);
+        CHECK( 0 == (mapped % 256) );
+        CHECK( 0 == (grown % 256) );
+    }
+#endif
+
+    TEST(Verify_mem_reallocate_keeps_aligned_objects_aligned)
+    {
+        int* p_obj = (int*)mem_allocate_aligned(sizeof(int), 256, NULL);
+        uintptr_t grown;
+        *p_obj = 42;
+        p_obj = (int*)mem_reallocate(p_obj, 1024);
+        grown = (uintptr_t)p_obj;
+        CHECK( 0 == (grown % 256) );
+        CHECK( 42 == *p_obj );
+        mem_release(p_obj);
+    }
+
+    TEST(Verify_mem_reallocate_copies_arena_objects_to_the_heap)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        int* p_obj;
+        int* p_null;
+        mem_arena_enter(p_arena);
+        p_obj = (int*)mem_allocate(sizeof(int), count_destructor);
+        *p_obj = 42;
+        p_obj = (int*)mem_reallocate(p_obj, 2 * sizeof(int));
+        p_null = (int*)mem_reallocate(NULL, sizeof(int));
+        mem_arena_exit(p_arena);
+        mem_release(p_arena);
+        CHECK( 0 == Num_Destructed );
+        CHECK( 42 == *p_obj );
+        CHECK( 1 == mem_refcount(p_null) );
+        mem_release(p_obj);
+        mem_release(p_null);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_arena functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_objects_allocated_in_an_arena_are_destructed_with_the_arena)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        void* p_obj;
+        mem_arena_enter(p_arena);
+        p_obj = mem_allocate(sizeof(int), count_destructor);
+        mem_allocate(sizeof(int), count_destructor);
+        mem_arena_exit(p_arena);
+        mem_release(p_obj);
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_arena);
+        CHECK( 2 == Num_Destructed );
+    }
+
+    TEST(Verify_arena_objects_release_the_heap_objects_they_reference)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        void* p_child = mem_allocate(sizeof(int), NULL);
+        parent_t* p_parent;
+        mem_arena_enter(p_arena);
+        p_parent = (parent_t*)mem_allocate(sizeof(parent_t), parent_destructor);
+        p_parent->p_child = mem_retain(p_child);
+        mem_arena_exit(p_arena);
+        CHECK( 2 == mem_refcount(p_child) );
+        mem_release(p_arena);
+        CHECK( 1 == mem_refcount(p_child) );
+        mem_release(p_child);
+    }
+
+    TEST(Verify_objects_allocated_after_mem_arena_exit_come_from_the_heap)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        void* p_obj;
+        mem_arena_enter(p_arena);
+        mem_arena_exit(p_arena);
+        p_obj = mem_allocate(sizeof(int), count_destructor);
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+        mem_release(p_arena);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_nested_arenas_are_reclaimed_independently)
+    {
+        mem_arena_t* p_outer = mem_arena_new(0);
+        mem_arena_t* p_inner = mem_arena_new(0);
+        mem_arena_enter(p_outer);
+        mem_allocate(sizeof(int), count_destructor);
+        mem_arena_enter(p_inner);
+        mem_allocate(sizeof(int), count_destructor);
+        mem_allocate(sizeof(int), count_destructor);
+        mem_arena_exit(p_inner);
+        mem_release(p_inner);
+        CHECK( 2 == Num_Destructed );
+        mem_arena_exit(p_outer);
+        mem_release(p_outer);
+        CHECK( 3 == Num_Destructed );
+    }
+
+    TEST(Verify_arena_serves_objects_larger_than_its_chunk_size)
+    {
+        mem_arena_t* p_arena = mem_arena_new(64);
+        char* p_obj;
+        mem_arena_enter(p_arena);
+        p_obj = (char*)mem_allocate(1024, NULL);
+        memset(p_obj, 0x5A, 1024);
+        mem_allocate(8, NULL);
+        mem_allocate(8, NULL);
+        mem_arena_exit(p_arena);
+        CHECK( 0x5A == p_obj[1023] );
+        mem_release(p_arena);
+    }
+
+    TEST(Verify_mem_arena_promote_copies_the_object_out_of_the_arena)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        int* p_obj;
+        int* p_copy;
+        mem_arena_enter(p_arena);
+        p_obj = (int*)mem_allocate(sizeof(int), count_destructor);
+        *p_obj = 42;
+        mem_arena_exit(p_arena);
+        p_copy = (int*)mem_arena_promote(p_obj);
+        CHECK( p_copy != p_obj );
+        CHECK( 42 == *p_copy );
+        CHECK( 1 == mem_refcount(p_copy) );
+        mem_release(p_arena);
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_copy);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_arena_promote_keeps_shared_objects_shared)
+    {
+        pthread_t threads[NUM_THREADS];
+        mem_arena_t* p_arena = mem_arena_new(0);
+        void* p_obj;
+        int i;
+        mem_arena_enter(p_arena);
+        p_obj = mem_share(mem_allocate(sizeof(int), count_destructor));
+        mem_arena_exit(p_arena);
+        p_obj = mem_arena_promote(p_obj);
+        mem_release(p_arena);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_create(&threads[i], NULL, retain_release_worker, p_obj);
+        for (i = 0; i < NUM_THREADS; i++)
+            pthread_join(threads[i], NULL);
+        CHECK( 1 == mem_refcount(p_obj) );
+        CHECK( 0 == Num_Destructed );
+        mem_release(p_obj);
+        CHECK( 1 == Num_Destructed );
+    }
+
+    TEST(Verify_mem_arena_promote_retains_heap_objects)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        CHECK( p_obj == mem_arena_promote(p_obj) );
+        CHECK( 2 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+        mem_release(p_obj);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_stats and mem_type_stats functions
+    //-------------------------------------------------------------------------
+#if (LEAK_DETECT_LEVEL > 0)
+    TEST(Verify_mem_stats_tracks_live_objects_and_bytes)
+    {
+        mem_stats_t before, during, after;
+        void* p_obj1;
+        void* p_obj2;
+        mem_stats(&before);
+        p_obj1 = mem_allocate(10, NULL);
+        p_obj2 = mem_allocate(20, NULL);
+        mem_stats(&during);
+        mem_release(p_obj1);
+        mem_release(p_obj2);
+        mem_stats(&after);
+        CHECK( before.live_objects + 2 == during.live_objects );
+        CHECK( before.live_bytes + 30 == during.live_bytes );
+        CHECK( before.allocations + 2 == during.allocations );
+        CHECK( during.peak_bytes >= during.live_bytes );
+        CHECK( before.live_objects == after.live_objects );
+        CHECK( before.live_bytes == after.live_bytes );
+        CHECK( before.frees + 2 == after.frees );
+    }
+
+    TEST(Verify_mem_stats_tracks_bytes_across_mem_reallocate)
+    {
+        mem_stats_t before, during, after;
+        void* p_obj;
+        mem_stats(&before);
+        p_obj = mem_reallocate(mem_allocate(10, NULL), 1000);
+        mem_stats(&during);
+        mem_release(p_obj);
+        mem_stats(&after);
+        CHECK( before.live_objects + 1 == during.live_objects );
+        CHECK( before.live_bytes + 1000 == during.live_bytes );
+        CHECK( before.live_bytes == after.live_bytes );
+    }
+
+    TEST(Verify_mem_stats_counts_arena_objects_until_the_arena_is_released)
+    {
+        mem_arena_t* p_arena;
+        mem_stats_t before, after;
+        mem_stats(&before);
+        p_arena = mem_arena_new(0);
+        mem_arena_enter(p_arena);
+        mem_allocate(10, NULL);
+        mem_allocate(10, NULL);
+        mem_arena_exit(p_arena);
+        mem_release(p_arena);
+        mem_stats(&after);
+        CHECK( before.live_objects == after.live_objects );
+        CHECK( before.live_bytes == after.live_bytes );
+    }
+#else
+    TEST(Verify_mem_stats_reports_nothing_when_leak_detection_is_disabled)
+    {
+        mem_stats_t stats;
+        mem_stats(&stats);
+        CHECK( 0 == stats.live_objects );
+        CHECK( 0 == stats.allocations );
+    }
+#endif
+
+#if (LEAK_DETECT_LEVEL > 1)
+    TEST(Verify_mem_type_stats_breaks_totals_down_by_destructor)
+    {
+        mem_type_stats_t types[MEM_STATS_MAX_TYPES];
+        void* p_obj = mem_allocate(sizeof(int), count_destructor);
+        size_t count = mem_type_stats(types, MEM_STATS_MAX_TYPES);
+        size_t i;
+        bool found = false;
+        for (i = 0; i < count; i++) {
+            if ((types[i].p_finalize == count_destructor) && (0 == strcmp(__FILE__, types[i].file))) {
+                found = true;
+                CHECK( 1 == types[i].live_objects );
+                CHECK( sizeof(int) == types[i].live_bytes );
+                CHECK( 0 == strcmp("count_destructor", types[i].name) );
+            }
+        }
+        mem_release(p_obj);
+        CHECK( found );
+    }
+
+    TEST(Verify_mem_type_stats_counts_buffers_against_the_calling_file)
+    {
+        mem_type_stats_t types[MEM_STATS_MAX_TYPES];
+        void* p_buf = mem_reallocate(NULL, 64);
+        void* p_aligned = mem_allocate_aligned(64, 64, NULL);
+        size_t count = mem_type_stats(types, MEM_STATS_MAX_TYPES);
+        size_t i;
+        bool found = false;
+        for (i = 0; i < count; i++) {
+            if ((NULL == types[i].p_finalize) && (0 == strcmp(__FILE__, types[i].file)))
+                found = (types[i].live_objects >= 2) && (types[i].live_bytes >= 128);
+        }
+        mem_release(p_buf);
+        mem_release(p_aligned);
+        CHECK( found );
+    }
+#else
+    TEST(Verify_mem_type_stats_reports_nothing_without_level_2_leak_detection)
+    {
+        mem_type_stats_t types[1];
+        CHECK( 0 == mem_type_stats(types, 1) );
+    }
+#endif
+
+    //-------------------------------------------------------------------------
+    // Test mem_swap function
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_swap_replaces_and_releases_the_old_reference)
+    {
+        void* p_old = mem_allocate(sizeof(int), count_destructor);
+        void* p_new = mem_allocate(sizeof(int), NULL);
+        void* p_loc = p_old;
+        mem_swap(&p_loc, p_new);
+        CHECK( p_new == p_loc );
+        CHECK( 1 == Num_Destructed );
+        mem_release(p_new);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test mem_box and mem_unbox functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_mem_unbox_returns_the_boxed_value)
+    {
+        void* p_box = mem_box(-42);
+        CHECK( -42 == mem_unbox(p_box) );
+        mem_release(p_box);
+    }
+
+    TEST(Verify_mem_unbox_returns_values_at_the_limits_of_intptr_t)
+    {
+        void* p_min = mem_box(INTPTR_MIN);
+        void* p_max = mem_box(INTPTR_MAX);
+        void* p_lo  = mem_box(MEM_IMMEDIATE_MIN);
+        void* p_hi  = mem_box(MEM_IMMEDIATE_MAX);
+        void* p_0   = mem_box(0);
+        CHECK( INTPTR_MIN == mem_unbox(p_min) );
+        CHECK( INTPTR_MAX == mem_unbox(p_max) );
+        CHECK( MEM_IMMEDIATE_MIN == mem_unbox(p_lo) );
+        CHECK( MEM_IMMEDIATE_MAX == mem_unbox(p_hi) );
+        CHECK( 0 == mem_unbox(p_0) );
+        mem_release(p_min);
+        mem_release(p_max);
+        mem_release(p_lo);
+        mem_release(p_hi);
+        mem_release(p_0);
+    }
+
+#if (MEM_TAGGED_INTEGERS > 0)
+    TEST(Verify_mem_box_returns_an_immediate_for_small_values)
+    {
+        void* p_box = mem_box(42);
+        void* p_big = mem_box(INTPTR_MAX);
+        bool big_is_immediate = (0 != ((uintptr_t)p_big & 1u));
+        mem_release(p_big);
+        CHECK( 0 != ((uintptr_t)p_box & 1u) );
+        CHECK( p_box == mem_box(42) );
+        CHECK( !big_is_immediate );
+    }
+
+    TEST(Verify_retaining_and_releasing_an_immediate_does_nothing)
+    {
+        void* p_box = mem_box(-7);
+        CHECK( p_box == mem_retain(p_box) );
+        CHECK( 1 == mem_refcount(p_box) );
+        mem_release(p_box);
+        mem_release(p_box);
+        CHECK( p_box == mem_share(p_box) );
+        CHECK( -7 == mem_unbox(p_box) );
+    }
+#endif
+}
@@ -0,0 +1,314 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "pvec.h"
+
+/* Enough elements for a trie three levels deep */
+#define NUM_DEEP ((PVEC_WIDTH * PVEC_WIDTH) + (3 * PVEC_WIDTH) + 5)
+
+static void test_setup(void) { }
+
+static pvec_t* boxed_vec(size_t num_elements) {
+    pvec_t* p_vec = pvec_new();
+    size_t i;
+    for (i = 0; i < num_elements; i++) {
+        pvec_t* p_next = pvec_push(p_vec, mem_box((intptr_t)i));
+        mem_release(p_vec);
+        p_vec = p_next;
+    }
+    return p_vec;
+}
+
+static bool holds_range(pvec_t* p_vec, size_t num_elements, intptr_t first) {
+    bool ret = (num_elements == pvec_size(p_vec));
+    size_t i;
+    for (i = 0; ret && (i < num_elements); i++)
+        ret = ((first + (intptr_t)i) == mem_unbox(pvec_at(p_vec, i)));
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(PersistentVector) {
+    //-------------------------------------------------------------------------
+    // Test pvec_new and pvec_from_array functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_new_returns_an_empty_vector)
+    {
+        pvec_t* p_vec = pvec_new();
+        CHECK(NULL != p_vec);
+        CHECK(pvec_empty(p_vec));
+        CHECK(0 == pvec_size(p_vec));
+        CHECK(NULL == pvec_at(p_vec, 0));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_pvec_from_array_takes_over_the_elements)
+    {
+        void* elems[NUM_DEEP];
+        pvec_t* p_vec;
+        bool stored = true;
+        size_t i;
+        for (i = 0; i < NUM_DEEP; i++)
+            elems[i] = counted_object();
+        p_vec = pvec_from_array(NUM_DEEP, elems);
+        CHECK(NUM_DEEP == pvec_size(p_vec));
+        for (i = 0; i < NUM_DEEP; i++)
+            stored = stored && (elems[i] == pvec_at(p_vec, i));
+        CHECK(stored);
+        mem_release(p_vec);
+        CHECK(NUM_DEEP == Num_Destructed);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test pvec_push function
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_push_leaves_the_original_unchanged)
+    {
+        pvec_t* p_vec1 = boxed_vec(PVEC_WIDTH);
+        pvec_t* p_vec2 = pvec_push(p_vec1, mem_box(PVEC_WIDTH));
+        CHECK(holds_range(p_vec1, PVEC_WIDTH, 0));
+        CHECK(holds_range(p_vec2, PVEC_WIDTH + 1, 0));
+        CHECK(NULL == pvec_at(p_vec1, PVEC_WIDTH));
+        mem_release(p_vec1);
+        mem_release(p_vec2);
+    }
+
+    TEST(Verify_pvec_push_grows_the_trie_a_level_at_a_time)
+    {
+        pvec_t* p_vec = boxed_vec(NUM_DEEP);
+        CHECK(holds_range(p_vec, NUM_DEEP, 0));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_pvec_push_onto_one_version_twice_gives_two_versions)
+    {
+        pvec_t* p_vec = boxed_vec(PVEC_WIDTH + 3);
+        pvec_t* p_vec1 = pvec_push(p_vec, mem_box(1));
+        pvec_t* p_vec2 = pvec_push(p_vec, mem_box(2));
+        CHECK(1 == mem_unbox(pvec_at(p_vec1, PVEC_WIDTH + 3)));
+        CHECK(2 == mem_unbox(pvec_at(p_vec2, PVEC_WIDTH + 3)));
+        CHECK((PVEC_WIDTH + 3) == pvec_size(p_vec));
+        mem_release(p_vec);
+        mem_release(p_vec1);
+        mem_release(p_vec2);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test pvec_set function
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_set_replaces_elements_in_a_new_version)
+    {
+        pvec_t* p_vec = boxed_vec(NUM_DEEP);
+        pvec_t* p_trie = pvec_set(p_vec, 5, mem_box(-1));
+        pvec_t* p_tail = pvec_set(p_vec, NUM_DEEP - 1, mem_box(-2));
+        CHECK(holds_range(p_vec, NUM_DEEP, 0));
+        CHECK(-1 == mem_unbox(pvec_at(p_trie, 5)));
+        CHECK(6 == mem_unbox(pvec_at(p_trie, 6)));
+        CHECK(-2 == mem_unbox(pvec_at(p_tail, NUM_DEEP - 1)));
+        CHECK(5 == mem_unbox(pvec_at(p_tail, 5)));
+        mem_release(p_vec);
+        mem_release(p_trie);
+        mem_release(p_tail);
+    }
+
+    TEST(Verify_pvec_set_returns_null_if_index_out_of_range)
+    {
+        pvec_t* p_vec = boxed_vec(3);
+        CHECK(NULL == pvec_set(p_vec, 3, NULL));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_pvec_set_releases_the_element_with_the_last_version_holding_it)
+    {
+        void* elem = counted_object();
+        pvec_t* p_vec1 = pvec_from_array(1, &elem);
+        pvec_t* p_vec2 = pvec_set(p_vec1, 0, counted_object());
+        CHECK(0 == Num_Destructed);
+        mem_release(p_vec1);
+        CHECK(1 == Num_Destructed);
+        mem_release(p_vec2);
+        CHECK(2 == Num_Destructed);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test pvec_pop function
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_pop_removes_the_last_element_in_a_new_version)
+    {
+        pvec_t* p_vec = boxed_vec(PVEC_WIDTH + 2);
+        pvec_t* p_vec1 = pvec_pop(p_vec);
+        pvec_t* p_vec2 = pvec_pop(p_vec1);
+        pvec_t* p_vec3 = pvec_pop(p_vec2);
+        CHECK(holds_range(p_vec, PVEC_WIDTH + 2, 0));
+        CHECK(holds_range(p_vec1, PVEC_WIDTH + 1, 0));
+        CHECK(holds_range(p_vec2, PVEC_WIDTH, 0));
+        CHECK(holds_range(p_vec3, PVEC_WIDTH - 1, 0));
+        mem_release(p_vec);
+        mem_release(p_vec1);
+        mem_release(p_vec2);
+        mem_release(p_vec3);
+    }
+
+    TEST(Verify_pvec_pop_then_push_replaces_the_popped_element)
+    {
+        pvec_t* p_vec = boxed_vec(PVEC_WIDTH + 1);
+        pvec_t* p_popped1 = pvec_pop(p_vec);
+        pvec_t* p_popped2 = pvec_pop(p_popped1);
+        pvec_t* p_pushed = pvec_push(p_popped2, mem_box(-1));
+        pvec_t* p_full = pvec_push(p_pushed, mem_box(-2));
+        CHECK(-1 == mem_unbox(pvec_at(p_full, PVEC_WIDTH - 1)));
+        CHECK(-2 == mem_unbox(pvec_at(p_full, PVEC_WIDTH)));
+        CHECK(holds_range(p_vec, PVEC_WIDTH + 1, 0));
+        mem_release(p_vec);
+        mem_release(p_popped1);
+        mem_release(p_popped2);
+        mem_release(p_pushed);
+        mem_release(p_full);
+    }
+
+    TEST(Verify_pvec_pop_returns_null_if_empty)
+    {
+        pvec_t* p_vec = pvec_new();
+        CHECK(NULL == pvec_pop(p_vec));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_pvec_pop_does_not_keep_the_popped_element)
+    {
+        void* elem = counted_object();
+        pvec_t* p_vec = pvec_from_array(1, &elem);
+        pvec_t* p_popped = pvec_pop(p_vec);
+        mem_release(p_vec);
+        CHECK(1 == Num_Destructed);
+        CHECK(pvec_empty(p_popped));
+        mem_release(p_popped);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test pvec_slice function
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_slice_returns_the_range_in_a_new_version)
+    {
+        pvec_t* p_vec = boxed_vec(NUM_DEEP);
+        pvec_t* p_slice = pvec_slice(p_vec, PVEC_WIDTH + 2, NUM_DEEP - 3);
+        pvec_t* p_empty = pvec_slice(p_vec, 7, 7);
+        size_t size = NUM_DEEP - PVEC_WIDTH - 5;
+        CHECK(holds_range(p_slice, size, PVEC_WIDTH + 2));
+        CHECK(pvec_empty(p_empty));
+        CHECK(NULL == pvec_at(p_slice, size));
+        mem_release(p_vec);
+        CHECK(holds_range(p_slice, size, PVEC_WIDTH + 2));
+        mem_release(p_slice);
+        mem_release(p_empty);
+    }
+
+    TEST(Verify_pvec_slice_can_be_grown_past_its_end)
+    {
+        pvec_t* p_vec = boxed_vec(NUM_DEEP);
+        pvec_t* p_slice = pvec_slice(p_vec, 3, PVEC_WIDTH);
+        pvec_t* p_grown = pvec_transient(p_slice);
+        size_t i;
+        for (i = 0; i < (2 * PVEC_WIDTH); i++)
+            pvec_transient_push(p_grown, mem_box(PVEC_WIDTH + 1000 + i));
+        pvec_persistent(p_grown);
+        CHECK((3 * PVEC_WIDTH - 3) == pvec_size(p_grown));
+        CHECK(3 == mem_unbox(pvec_at(p_grown, 0)));
+        CHECK((intptr_t)(PVEC_WIDTH - 1) == mem_unbox(pvec_at(p_grown, PVEC_WIDTH - 4)));
+        CHECK((intptr_t)(PVEC_WIDTH + 1000) == mem_unbox(pvec_at(p_grown, PVEC_WIDTH - 3)));
+        CHECK(holds_range(p_vec, NUM_DEEP, 0));
+        CHECK(holds_range(p_slice, PVEC_WIDTH - 3, 3));
+        mem_release(p_vec);
+        mem_release(p_slice);
+        mem_release(p_grown);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test pvec_concat function
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_concat_appends_the_second_vector)
+    {
+        pvec_t* p_vec = boxed_vec(NUM_DEEP);
+        pvec_t* p_first = pvec_slice(p_vec, 0, PVEC_WIDTH + 3);
+        pvec_t* p_second = pvec_slice(p_vec, PVEC_WIDTH + 3, NUM_DEEP);
+        pvec_t* p_joined = pvec_concat(p_first, p_second);
+        CHECK(holds_range(p_joined, NUM_DEEP, 0));
+        CHECK(holds_range(p_first, PVEC_WIDTH + 3, 0));
+        mem_release(p_vec);
+        mem_release(p_first);
+        mem_release(p_second);
+        mem_release(p_joined);
+    }
+
+    TEST(Verify_pvec_concat_with_itself_repeats_the_elements)
+    {
+        pvec_t* p_vec = boxed_vec(50);
+        pvec_t* p_twice = pvec_concat(p_vec, p_vec);
+        CHECK(100 == pvec_size(p_twice));
+        CHECK(49 == mem_unbox(pvec_at(p_twice, 49)));
+        CHECK(0 == mem_unbox(pvec_at(p_twice, 50)));
+        CHECK(holds_range(p_vec, 50, 0));
+        mem_release(p_vec);
+        mem_release(p_twice);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test pvec_transient functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_pvec_transient_updates_leave_the_original_unchanged)
+    {
+        pvec_t* p_vec = boxed_vec(NUM_DEEP);
+        pvec_t* p_batch = pvec_transient(p_vec);
+        size_t i;
+        bool updated = true;
+        for (i = 0; i < NUM_DEEP; i += 7)
+            updated = updated && pvec_transient_set(p_batch, i, mem_box(-(intptr_t)i));
+        pvec_transient_push(p_batch, mem_box(-1));
+        CHECK(updated);
+        CHECK(!pvec_transient_set(p_batch, NUM_DEEP + 1, NULL));
+        pvec_persistent(p_batch);
+        CHECK(holds_range(p_vec, NUM_DEEP, 0));
+        CHECK((NUM_DEEP + 1) == pvec_size(p_batch));
+        CHECK(-7 == mem_unbox(pvec_at(p_batch, 7)));
+        CHECK(8 == mem_unbox(pvec_at(p_batch, 8)));
+        CHECK(-1 == mem_unbox(pvec_at(p_batch, NUM_DEEP)));
+        mem_release(p_vec);
+        mem_release(p_batch);
+    }
+
+    TEST(Verify_pvec_transient_set_releases_replaced_elements_in_place)
+    {
+        pvec_t* p_empty = pvec_new();
+        pvec_t* p_vec = pvec_transient(p_empty);
+        pvec_transient_push(p_vec, counted_object());
+        pvec_transient_set(p_vec, 0, counted_object());
+        CHECK(1 == Num_Destructed);
+        pvec_transient_set(p_vec, 0, NULL);
+        CHECK(2 == Num_Destructed);
+        CHECK(pvec_empty(p_empty));
+        mem_release(pvec_persistent(p_vec));
+        mem_release(p_empty);
+    }
+
+    TEST(Verify_pvec_versions_release_each_element_once)
+    {
+        pvec_t* p_vec = pvec_new();
+        pvec_t* p_versions[4];
+        size_t i;
+        for (i = 0; i < NUM_DEEP; i++) {
+            pvec_t* p_next = pvec_push(p_vec, counted_object());
+            mem_release(p_vec);
+            p_vec = p_next;
+        }
+        p_versions[0] = pvec_set(p_vec, NUM_DEEP / 2, counted_object());
+        p_versions[1] = pvec_slice(p_versions[0], 3, NUM_DEEP - 3);
+        p_versions[2] = pvec_concat(p_versions[1], p_vec);
+        p_versions[3] = pvec_pop(p_versions[2]);
+        mem_release(p_vec);
+        for (i = 0; i < 4; i++)
+            mem_release(p_versions[i]);
+        CHECK((NUM_DEEP + 1) == Num_Destructed);
+    }
+}
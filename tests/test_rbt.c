@@ -101,6 +101,19 @@ TEST_SUITE(RBT) {
         mem_release(tree);
     }
 
+    TEST(Verify_rbt_new_shares_one_default_comparator_between_trees){
+        rbt_t* tree1 = rbt_new(NULL);
+        rbt_t* tree2 = rbt_new(NULL);
+        cmp_t* comp = tree1->comp;
+        bool shared = (tree1->comp == tree2->comp);
+        mem_release(tree1);
+        mem_release(tree2);
+        tree1 = rbt_new(NULL);
+        CHECK(shared);
+        CHECK(comp == tree1->comp);
+        mem_release(tree1);
+    }
+
     //-------------------------------------------------------------------------
     // Test the test function. testception.
     //-------------------------------------------------------------------------
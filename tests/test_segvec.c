@@ -0,0 +1,167 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "segvec.h"
+
+static void test_setup(void) { }
+
+static segvec_t* counting_vec(size_t num_elements) {
+    segvec_t* p_vec = segvec_new();
+    size_t i;
+    for (i = 0; i < num_elements; i++)
+        segvec_push_back(p_vec, counted_object());
+    return p_vec;
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(SegVector) {
+    //-------------------------------------------------------------------------
+    // Test segvec_new function
+    //-------------------------------------------------------------------------
+    TEST(Verify_segvec_new_returns_an_empty_vector_without_chunks)
+    {
+        segvec_t* p_vec = segvec_new();
+        CHECK(NULL != p_vec);
+        CHECK(segvec_empty(p_vec));
+        CHECK(0 == segvec_capacity(p_vec));
+        CHECK(NULL == segvec_at(p_vec, 0));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test segvec_push_back and segvec_at functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_segvec_push_back_adds_elements_across_chunks)
+    {
+        segvec_t* p_vec = segvec_new();
+        size_t num_elements = (3 * SEGVEC_CHUNK_SIZE) + 7;
+        bool stored = true;
+        size_t i;
+        for (i = 0; i < num_elements; i++)
+            segvec_push_back(p_vec, mem_box((intptr_t)i));
+        for (i = 0; i < num_elements; i++)
+            stored = stored && ((intptr_t)i == mem_unbox(segvec_at(p_vec, i)));
+        CHECK(stored);
+        CHECK(num_elements == segvec_size(p_vec));
+        CHECK((4 * SEGVEC_CHUNK_SIZE) == segvec_capacity(p_vec));
+        CHECK(NULL == segvec_at(p_vec, num_elements));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_segvec_slot_addresses_stay_valid_as_the_vector_grows)
+    {
+        segvec_t* p_vec = segvec_new();
+        void** p_first;
+        void** p_last;
+        size_t i;
+        segvec_push_back(p_vec, mem_box(1));
+        p_first = segvec_slot(p_vec, 0);
+        for (i = 1; i < (64 * SEGVEC_CHUNK_SIZE); i++)
+            segvec_push_back(p_vec, mem_box(2));
+        p_last = segvec_slot(p_vec, i - 1);
+        CHECK(p_first == segvec_slot(p_vec, 0));
+        CHECK(1 == mem_unbox(*p_first));
+        CHECK(2 == mem_unbox(*p_last));
+        CHECK(NULL == segvec_slot(p_vec, i));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test segvec_set function
+    //-------------------------------------------------------------------------
+    TEST(Verify_segvec_set_sets_the_value_at_the_given_index)
+    {
+        segvec_t* p_vec = segvec_new();
+        segvec_resize(p_vec, SEGVEC_CHUNK_SIZE + 1, NULL);
+        CHECK(segvec_set(p_vec, SEGVEC_CHUNK_SIZE, mem_box(42)));
+        CHECK(42 == mem_unbox(segvec_at(p_vec, SEGVEC_CHUNK_SIZE)));
+        CHECK(!segvec_set(p_vec, SEGVEC_CHUNK_SIZE + 1, NULL));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test segvec_resize function
+    //-------------------------------------------------------------------------
+    TEST(Verify_segvec_resize_shares_one_reference_per_new_element)
+    {
+        segvec_t* p_vec = segvec_new();
+        void* p_obj = counted_object();
+        int refcount;
+        segvec_resize(p_vec, SEGVEC_CHUNK_SIZE + 2, p_obj);
+        refcount = mem_refcount(p_obj);
+        CHECK((int)(SEGVEC_CHUNK_SIZE + 2) == refcount);
+        CHECK(p_obj == segvec_at(p_vec, SEGVEC_CHUNK_SIZE + 1));
+        mem_release(p_vec);
+        CHECK(1 == Num_Destructed);
+    }
+
+    TEST(Verify_segvec_resize_releases_the_elements_it_removes)
+    {
+        segvec_t* p_vec = counting_vec((2 * SEGVEC_CHUNK_SIZE) + 3);
+        segvec_resize(p_vec, SEGVEC_CHUNK_SIZE - 1, NULL);
+        CHECK((SEGVEC_CHUNK_SIZE - 1) == segvec_size(p_vec));
+        CHECK((int)(SEGVEC_CHUNK_SIZE + 4) == Num_Destructed);
+        CHECK((3 * SEGVEC_CHUNK_SIZE) == segvec_capacity(p_vec));
+        mem_release(p_vec);
+        CHECK((int)((2 * SEGVEC_CHUNK_SIZE) + 3) == Num_Destructed);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test segvec_reserve and segvec_shrink_to_fit functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_segvec_reserve_allocates_whole_chunks)
+    {
+        segvec_t* p_vec = segvec_new();
+        segvec_reserve(p_vec, SEGVEC_CHUNK_SIZE + 1);
+        CHECK((2 * SEGVEC_CHUNK_SIZE) == segvec_capacity(p_vec));
+        CHECK(0 == segvec_size(p_vec));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_segvec_shrink_to_fit_frees_the_unused_chunks)
+    {
+        segvec_t* p_vec = segvec_new();
+        segvec_reserve(p_vec, 10 * SEGVEC_CHUNK_SIZE);
+        segvec_push_back(p_vec, mem_box(1));
+        segvec_shrink_to_fit(p_vec);
+        CHECK(SEGVEC_CHUNK_SIZE == segvec_capacity(p_vec));
+        CHECK(1 == mem_unbox(segvec_at(p_vec, 0)));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test segvec_pop_back and segvec_clear functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_segvec_pop_back_returns_the_last_element)
+    {
+        segvec_t* p_vec = segvec_new();
+        void* p_popped;
+        segvec_resize(p_vec, SEGVEC_CHUNK_SIZE, NULL);
+        segvec_push_back(p_vec, mem_box(42));
+        p_popped = segvec_pop_back(p_vec);
+        CHECK(42 == mem_unbox(p_popped));
+        CHECK(SEGVEC_CHUNK_SIZE == segvec_size(p_vec));
+        mem_release(p_popped);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_segvec_pop_back_returns_null_if_empty)
+    {
+        segvec_t* p_vec = segvec_new();
+        CHECK(NULL == segvec_pop_back(p_vec));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_segvec_clear_releases_every_element_and_keeps_the_chunks)
+    {
+        segvec_t* p_vec = counting_vec(SEGVEC_CHUNK_SIZE + 1);
+        segvec_clear(p_vec);
+        CHECK(0 == segvec_size(p_vec));
+        CHECK((int)(SEGVEC_CHUNK_SIZE + 1) == Num_Destructed);
+        CHECK((2 * SEGVEC_CHUNK_SIZE) == segvec_capacity(p_vec));
+        mem_release(p_vec);
+    }
+}
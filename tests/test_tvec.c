@@ -0,0 +1,306 @@
+// Unit Test Framework Includes
+#include "test.h"
+
+// File To Test
+#include "tvec.h"
+
+typedef struct {
+    int x;
+    int y;
+} point_t;
+
+static int Sum_Destructed = 0;
+
+static void test_setup(void) {
+    Sum_Destructed = 0;
+}
+
+static void int_destructor(void* p_elem) {
+    Num_Destructed++;
+    Sum_Destructed += *(int*)p_elem;
+}
+
+static tvec_t* int_vec(size_t num_elements, const int* p_elements) {
+    return tvec_new(sizeof(int), int_destructor, num_elements, p_elements);
+}
+
+static int int_at(tvec_t* p_vec, size_t index) {
+    return *(int*)tvec_at(p_vec, index);
+}
+
+//-----------------------------------------------------------------------------
+// Begin Unit Tests
+//-----------------------------------------------------------------------------
+TEST_SUITE(TypedVector) {
+    //-------------------------------------------------------------------------
+    // Test tvec_new function
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_new_returns_an_empty_vector_with_default_capacity)
+    {
+        tvec_t* p_vec = tvec_new(sizeof(point_t), NULL, 0, NULL);
+        CHECK(NULL != p_vec);
+        CHECK(0 == tvec_size(p_vec));
+        CHECK(tvec_empty(p_vec));
+        CHECK(DEFAULT_VEC_CAPACITY == tvec_capacity(p_vec));
+        CHECK(sizeof(point_t) == p_vec->elem_size);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_new_copies_the_provided_elements)
+    {
+        point_t points[] = { {1, 2}, {3, 4}, {5, 6} };
+        tvec_t* p_vec = tvec_new(sizeof(point_t), NULL, 3, points);
+        points[1].x = 42;
+        CHECK(3 == tvec_size(p_vec));
+        CHECK(3 == ((point_t*)tvec_at(p_vec, 1))->x);
+        CHECK(6 == ((point_t*)tvec_at(p_vec, 2))->y);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_new_zeroes_the_elements_if_none_are_provided)
+    {
+        tvec_t* p_vec = tvec_new(sizeof(point_t), NULL, 2, NULL);
+        CHECK(2 == tvec_size(p_vec));
+        CHECK(0 == ((point_t*)tvec_at(p_vec, 1))->y);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_stores_elements_contiguously)
+    {
+        int elems[] = { 1, 2, 3, 4 };
+        tvec_t* p_vec = int_vec(4, elems);
+        CHECK(tvec_data(p_vec) == tvec_at(p_vec, 0));
+        CHECK(((int*)tvec_data(p_vec)) + 3 == tvec_at(p_vec, 3));
+        CHECK(0 == memcmp(tvec_data(p_vec), elems, sizeof(elems)));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_max_size function
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_max_size_depends_on_the_element_size)
+    {
+        tvec_t* p_vec = tvec_new(sizeof(point_t), NULL, 0, NULL);
+        CHECK(((size_t)-1 / sizeof(point_t)) == tvec_max_size(p_vec));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_resize function
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_resize_copies_the_value_into_new_elements)
+    {
+        int val = 7;
+        tvec_t* p_vec = int_vec(1, &val);
+        val = 9;
+        tvec_resize(p_vec, 4, &val);
+        CHECK(4 == tvec_size(p_vec));
+        CHECK(7 == int_at(p_vec, 0));
+        CHECK(9 == int_at(p_vec, 1));
+        CHECK(9 == int_at(p_vec, 3));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_resize_zeroes_new_elements_without_a_value)
+    {
+        int val = 7;
+        tvec_t* p_vec = int_vec(1, &val);
+        tvec_resize(p_vec, 3, NULL);
+        CHECK(3 == tvec_size(p_vec));
+        CHECK(0 == int_at(p_vec, 2));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_resize_destructs_removed_elements)
+    {
+        int elems[] = { 1, 2, 3, 4 };
+        tvec_t* p_vec = int_vec(4, elems);
+        tvec_resize(p_vec, 2, NULL);
+        CHECK(2 == tvec_size(p_vec));
+        CHECK(2 == Num_Destructed);
+        CHECK(7 == Sum_Destructed);
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_reserve and tvec_shrink_to_fit functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_reserve_never_shrinks_the_buffer)
+    {
+        tvec_t* p_vec = tvec_new(sizeof(point_t), NULL, 0, NULL);
+        tvec_reserve(p_vec, 100);
+        tvec_reserve(p_vec, 10);
+        CHECK(100 == tvec_capacity(p_vec));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_shrink_to_fit_shrinks_capacity_to_equal_the_size)
+    {
+        int elems[] = { 1, 2, 3 };
+        tvec_t* p_vec = int_vec(3, elems);
+        tvec_reserve(p_vec, 100);
+        tvec_shrink_to_fit(p_vec);
+        CHECK(3 == tvec_capacity(p_vec));
+        CHECK(3 == int_at(p_vec, 2));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_at and tvec_set functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_at_returns_null_if_index_out_of_range)
+    {
+        int val = 1;
+        tvec_t* p_vec = int_vec(1, &val);
+        CHECK(NULL == tvec_at(p_vec, 1));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_set_destructs_the_element_it_replaces)
+    {
+        int elems[] = { 1, 2, 3 };
+        int val = 42;
+        tvec_t* p_vec = int_vec(3, elems);
+        CHECK(tvec_set(p_vec, 1, &val));
+        CHECK(42 == int_at(p_vec, 1));
+        CHECK(1 == Num_Destructed);
+        CHECK(2 == Sum_Destructed);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_set_returns_false_if_index_out_of_range)
+    {
+        int val = 42;
+        tvec_t* p_vec = int_vec(0, NULL);
+        CHECK(!tvec_set(p_vec, 0, &val));
+        CHECK(0 == Num_Destructed);
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_insert function
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_insert_inserts_elements_at_the_given_index)
+    {
+        int elems[] = { 1, 4 };
+        int inserted[] = { 2, 3 };
+        tvec_t* p_vec = int_vec(2, elems);
+        CHECK(tvec_insert(p_vec, 1, 2, inserted));
+        CHECK(4 == tvec_size(p_vec));
+        CHECK(1 == int_at(p_vec, 0));
+        CHECK(2 == int_at(p_vec, 1));
+        CHECK(3 == int_at(p_vec, 2));
+        CHECK(4 == int_at(p_vec, 3));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_insert_appends_elements_at_the_end)
+    {
+        int elems[] = { 1, 2 };
+        int val = 3;
+        tvec_t* p_vec = int_vec(2, elems);
+        CHECK(tvec_insert(p_vec, 2, 1, &val));
+        CHECK(3 == tvec_size(p_vec));
+        CHECK(3 == int_at(p_vec, 2));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_insert_should_do_nothing_if_index_out_of_range)
+    {
+        int val = 3;
+        tvec_t* p_vec = int_vec(0, NULL);
+        CHECK(!tvec_insert(p_vec, 1, 1, &val));
+        CHECK(0 == tvec_size(p_vec));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_erase function
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_erase_destructs_and_removes_the_range)
+    {
+        int elems[] = { 1, 2, 3, 4, 5 };
+        tvec_t* p_vec = int_vec(5, elems);
+        CHECK(tvec_erase(p_vec, 1, 3));
+        CHECK(2 == tvec_size(p_vec));
+        CHECK(1 == int_at(p_vec, 0));
+        CHECK(5 == int_at(p_vec, 1));
+        CHECK(3 == Num_Destructed);
+        CHECK(9 == Sum_Destructed);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_erase_should_fail_if_end_index_is_out_of_range)
+    {
+        int elems[] = { 1, 2 };
+        tvec_t* p_vec = int_vec(2, elems);
+        CHECK(!tvec_erase(p_vec, 0, 2));
+        CHECK(2 == tvec_size(p_vec));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_push_back and tvec_pop_back functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_push_back_grows_the_capacity_geometrically)
+    {
+        tvec_t* p_vec = tvec_new(sizeof(point_t), NULL, 0, NULL);
+        bool stored = true;
+        int i;
+        for (i = 0; i < 1000; i++) {
+            point_t point = { i, -i };
+            tvec_push_back(p_vec, &point);
+        }
+        for (i = 0; i < 1000; i++)
+            stored = stored && (i == ((point_t*)tvec_at(p_vec, i))->x);
+        CHECK(stored);
+        CHECK(1000 == tvec_size(p_vec));
+        CHECK(1024 == tvec_capacity(p_vec));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_pop_back_moves_the_last_element_out)
+    {
+        int elems[] = { 1, 2 };
+        int val = 0;
+        tvec_t* p_vec = int_vec(2, elems);
+        CHECK(tvec_pop_back(p_vec, &val));
+        CHECK(2 == val);
+        CHECK(1 == tvec_size(p_vec));
+        CHECK(0 == Num_Destructed);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_pop_back_destructs_the_element_without_an_output)
+    {
+        int elems[] = { 1, 2 };
+        tvec_t* p_vec = int_vec(2, elems);
+        CHECK(tvec_pop_back(p_vec, NULL));
+        CHECK(1 == Num_Destructed);
+        CHECK(2 == Sum_Destructed);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_tvec_pop_back_returns_false_if_no_elements)
+    {
+        tvec_t* p_vec = int_vec(0, NULL);
+        CHECK(!tvec_pop_back(p_vec, NULL));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test tvec_clear function
+    //-------------------------------------------------------------------------
+    TEST(Verify_tvec_release_destructs_every_element)
+    {
+        int elems[] = { 1, 2, 3 };
+        tvec_t* p_vec = int_vec(3, elems);
+        tvec_clear(p_vec);
+        CHECK(0 == tvec_size(p_vec));
+        CHECK(3 == Num_Destructed);
+        tvec_push_back(p_vec, &elems[2]);
+        mem_release(p_vec);
+        CHECK(4 == Num_Destructed);
+        CHECK(9 == Sum_Destructed);
+    }
+}
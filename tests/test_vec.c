@@ -8,6 +8,118 @@
 
 static void test_setup(void) { }
 
+/* Allocates and frees internal arrays for vectors built in place */
+static void** new_buffer(size_t num_elements) {
+#if (VEC_BUFFER_ALIGNMENT > 0)
+    return (void**)mem_allocate_aligned(sizeof(void*) * num_elements, VEC_BUFFER_ALIGNMENT, NULL);
+#else
+    return (void**)mem_reallocate(NULL, sizeof(void*) * num_elements);
+#endif
+}
+
+static void free_buffer(void** p_buffer) {
+    mem_release(p_buffer);
+}
+
+static int cmp_int(void* env, void* obja, void* objb) {
+    intptr_t a = mem_unbox(obja);
+    intptr_t b = mem_unbox(objb);
+    (void)env;
+    return (a == b) ? 0 : ((a < b) ? -1 : 1);
+}
+
+/* Orders values by key alone, leaving the low digits to record position */
+static int cmp_key(void* env, void* obja, void* objb) {
+    intptr_t a = mem_unbox(obja) / 1000000;
+    intptr_t b = mem_unbox(objb) / 1000000;
+    (void)env;
+    return (a == b) ? 0 : ((a < b) ? -1 : 1);
+}
+
+static vec_t* random_vec(size_t num_elements, intptr_t range) {
+    vec_t* p_vec = vec_new(0);
+    uint32_t seed = 42;
+    size_t i;
+    for (i = 0; i < num_elements; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        vec_push_back(p_vec, mem_box((intptr_t)(seed >> 8) % range));
+    }
+    return p_vec;
+}
+
+static bool vec_is_sorted(vec_t* p_vec, cmp_t* p_cmp) {
+    bool sorted = true;
+    size_t i;
+    for (i = 1; sorted && (i < p_vec->size); i++)
+        sorted = (cmp_compare(p_cmp, p_vec->p_buffer[i - 1], p_vec->p_buffer[i]) <= 0);
+    return sorted;
+}
+
+static intptr_t vec_sum(vec_t* p_vec) {
+    intptr_t sum = 0;
+    size_t i;
+    for (i = 0; i < p_vec->size; i++)
+        sum += mem_unbox(p_vec->p_buffer[i]);
+    return sum;
+}
+
+/* Enough elements to be split across four threads */
+#define NUM_PARALLEL ((4 * VEC_PARALLEL_MIN_CHUNK) + 3)
+
+static vec_t* sequence_vec(size_t num_elements) {
+    vec_t* p_vec = vec_new(0);
+    size_t i;
+    for (i = 0; i < num_elements; i++)
+        vec_push_back(p_vec, mem_box((intptr_t)i));
+    return p_vec;
+}
+
+/* Checks that the elements of a sequence are visited in order */
+static void visit_next(void* env, void* p_elem) {
+    intptr_t* p_next = (intptr_t*)env;
+    *p_next = (mem_unbox(p_elem) == *p_next) ? (*p_next + 1) : -1;
+}
+
+static void visit_sum(void* env, void* p_elem) {
+    __atomic_fetch_add((intptr_t*)env, mem_unbox(p_elem), __ATOMIC_RELAXED);
+}
+
+static void* double_elem(void* env, void* p_elem) {
+    (void)env;
+    return mem_box(2 * mem_unbox(p_elem));
+}
+
+static bool is_multiple(void* env, void* p_elem) {
+    return (0 == (mem_unbox(p_elem) % *(intptr_t*)env));
+}
+
+static bool is_value(void* env, void* p_elem) {
+    return (mem_unbox(p_elem) == *(intptr_t*)env);
+}
+
+/* The accumulator is a plain integer rather than a boxed one */
+static void* add_elem(void* env, void* p_acc, void* p_elem) {
+    (void)env;
+    return (void*)((intptr_t)p_acc + mem_unbox(p_elem));
+}
+
+static void* add_acc(void* env, void* p_acc, void* p_other) {
+    (void)env;
+    return (void*)((intptr_t)p_acc + (intptr_t)p_other);
+}
+
+/* Sums the whole vector again in parallel from the first element of each chunk */
+typedef struct {
+    vec_t* p_vec;
+    intptr_t sum;
+} nested_sum_t;
+
+static void visit_nested_sum(void* env, void* p_elem) {
+    nested_sum_t* p_env = (nested_sum_t*)env;
+    if (0 == (mem_unbox(p_elem) % (intptr_t)VEC_PARALLEL_MIN_CHUNK))
+        vec_parallel_foreach(p_env->p_vec, visit_sum, &p_env->sum, 4);
+}
+
 //-----------------------------------------------------------------------------
 // Begin Unit Tests
 //-----------------------------------------------------------------------------
@@ -25,6 +137,79 @@ TEST_SUITE(Vector) {
         mem_release(p_vec);
     }
 
+#if (VEC_BUFFER_ALIGNMENT > 0)
+    TEST(Verify_vec_buffer_stays_aligned_as_the_vector_grows)
+    {
+        vec_t* p_vec = vec_new(0);
+        bool aligned = (0 == ((uintptr_t)p_vec->p_buffer % VEC_BUFFER_ALIGNMENT));
+        size_t i;
+        for (i = 0; i < 100; i++)
+            vec_push_back(p_vec, mem_box((intptr_t)i));
+        aligned = aligned && (0 == ((uintptr_t)p_vec->p_buffer % VEC_BUFFER_ALIGNMENT));
+        CHECK( aligned );
+        CHECK( 99 == mem_unbox(vec_at(p_vec, 99)) );
+        mem_release(p_vec);
+    }
+#endif
+
+#if (VEC_INLINE_CAPACITY > 0) && (VEC_BUFFER_ALIGNMENT == 0)
+    TEST(Verify_vec_new_keeps_the_elements_of_small_vectors_inline)
+    {
+        vec_t* p_vec = vec_new(2, mem_box(1), mem_box(2));
+        vec_t* p_empty = vec_new(0);
+        bool inline_buffer = (p_vec->p_buffer == (void**)(p_vec + 1));
+        bool inline_empty = (p_empty->p_buffer == (void**)(p_empty + 1));
+        CHECK( inline_buffer );
+        CHECK( inline_empty );
+        CHECK( 2 == mem_unbox(vec_at(p_vec, 1)) );
+        mem_release(p_vec);
+        mem_release(p_empty);
+    }
+
+    TEST(Verify_vec_moves_inline_elements_to_the_heap_when_it_outgrows_them)
+    {
+        vec_t* p_vec = vec_new(0);
+        bool kept = true;
+        intptr_t i;
+        for (i = 0; i <= VEC_INLINE_CAPACITY; i++)
+            vec_push_back(p_vec, mem_box(i));
+        for (i = 0; i <= VEC_INLINE_CAPACITY; i++)
+            kept = kept && (i == mem_unbox(vec_at(p_vec, (size_t)i)));
+        CHECK( p_vec->p_buffer != (void**)(p_vec + 1) );
+        CHECK( kept );
+        CHECK( (VEC_INLINE_CAPACITY + 1) == p_vec->size );
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_shrink_to_fit_keeps_inline_elements_in_place)
+    {
+        vec_t* p_vec = vec_new(0);
+        vec_push_back(p_vec, mem_box(1));
+        vec_shrink_to_fit(p_vec);
+        CHECK( p_vec->p_buffer == (void**)(p_vec + 1) );
+        CHECK( 1 == p_vec->capacity );
+        vec_push_back(p_vec, mem_box(2));
+        CHECK( 2 == mem_unbox(vec_at(p_vec, 1)) );
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_new_inside_an_arena_survives_mem_arena_promote)
+    {
+        mem_arena_t* p_arena = mem_arena_new(0);
+        void* p_first = mem_box(1);
+        void* p_second = mem_box(2);
+        vec_t* p_vec;
+        mem_arena_enter(p_arena);
+        p_vec = (vec_t*)mem_arena_promote(vec_new(2, p_first, p_second));
+        mem_arena_exit(p_arena);
+        mem_release(p_arena);
+        CHECK( 2 == vec_size(p_vec) );
+        CHECK( 1 == mem_unbox(vec_at(p_vec, 0)) );
+        CHECK( 2 == mem_unbox(vec_at(p_vec, 1)) );
+        mem_release(p_vec);
+    }
+#endif
+
     TEST(Verify_vec_new_returns_newly_allocated_vector_with_the_provided_elements)
     {
         vec_t* p_vec = vec_new(2,mem_box(0x1234),mem_box(0x4321));
@@ -42,7 +227,7 @@ TEST_SUITE(Vector) {
     //-------------------------------------------------------------------------
     TEST(Verify_vec_size_returns_the_correct_size)
     {
-        vec_t vector = { 42, 24, NULL };
+        vec_t vector = { 42, 24, NULL, 0 };
         CHECK(42 == vec_size(&vector));
     }
 
@@ -59,13 +244,13 @@ TEST_SUITE(Vector) {
     //-------------------------------------------------------------------------
     TEST(Verify_vec_empty_returns_true_if_empty)
     {
-        vec_t vector = { 0, 24, NULL };
+        vec_t vector = { 0, 24, NULL, 0 };
         CHECK(true == vec_empty(&vector));
     }
 
     TEST(Verify_vec_empty_returns_false_if_not_empty)
     {
-        vec_t vector = { 42, 24, NULL };
+        vec_t vector = { 42, 24, NULL, 0 };
         CHECK(false == vec_empty(&vector));
     }
 
@@ -111,7 +296,7 @@ TEST_SUITE(Vector) {
         vec_resize( p_vec, 4, mem_box(0x2A) );
 
         CHECK( 4 == p_vec->size );
-        CHECK( 8 == p_vec->capacity );
+        CHECK( 6 == p_vec->capacity );
         CHECK( 0x2A == mem_unbox(p_vec->p_buffer[3]) );
 
         mem_release(p_vec);
@@ -123,22 +308,39 @@ TEST_SUITE(Vector) {
         vec_resize( p_vec, 5, mem_box(0x2A) );
 
         CHECK( 5 == p_vec->size );
-        CHECK( 8 == p_vec->capacity );
+        CHECK( 6 == p_vec->capacity );
         CHECK( 0x2A == mem_unbox(p_vec->p_buffer[3]) );
         CHECK( 0x2A == mem_unbox(p_vec->p_buffer[4]) );
 
         mem_release(p_vec);
     }
 
+    TEST(Verify_vec_resize_should_share_one_reference_per_new_element)
+    {
+        vec_t* p_vec = vec_new(0);
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        int grown, shrunk;
+        mem_retain(p_obj);
+        vec_resize( p_vec, 100, p_obj );
+        grown = mem_refcount(p_obj);
+        vec_resize( p_vec, 10, NULL );
+        shrunk = mem_refcount(p_obj);
+        mem_release(p_vec);
+        CHECK( 101 == grown );
+        CHECK( 11 == shrunk );
+        CHECK( 1 == mem_refcount(p_obj) );
+        mem_release(p_obj);
+    }
+
     //-------------------------------------------------------------------------
     // Test vec_shrink_to_fit function
     //-------------------------------------------------------------------------
     TEST(Verify_vec_shrink_to_fit_shrinks_capacity_to_equal_the_size)
     {
-        vec_t vector = { 1, 2, (void**)malloc(sizeof(void*) * 2) };
+        vec_t vector = { 1, 2, new_buffer(2), 0 };
         vec_shrink_to_fit(&vector);
         CHECK( vector.size == vector.capacity );
-        free(vector.p_buffer);
+        free_buffer(vector.p_buffer);
     }
 
     //-------------------------------------------------------------------------
@@ -146,7 +348,7 @@ TEST_SUITE(Vector) {
     //-------------------------------------------------------------------------
     TEST(Verify_vec_capacity_returns_the_correct_size)
     {
-        vec_t vector = { 42, 24, NULL };
+        vec_t vector = { 42, 24, NULL, 0 };
         CHECK(24 == vec_capacity(&vector));
     }
 
@@ -155,10 +357,20 @@ TEST_SUITE(Vector) {
     //-------------------------------------------------------------------------
     TEST(Verify_vec_reserve_reserves_a_buffer_of_the_desired_size)
     {
-        vec_t vector = { 0, 0, NULL };
+        vec_t vector = { 0, 0, NULL, 0 };
         vec_reserve(&vector,5);
         CHECK( 5 == vector.capacity );
-        free(vector.p_buffer);
+        free_buffer(vector.p_buffer);
+    }
+
+    TEST(Verify_vec_reserve_never_shrinks_the_buffer)
+    {
+        vec_t* p_vec = vec_new(0);
+        void** p_buffer = p_vec->p_buffer;
+        vec_reserve(p_vec, 2);
+        CHECK( DEFAULT_VEC_CAPACITY == p_vec->capacity );
+        CHECK( p_buffer == p_vec->p_buffer );
+        mem_release(p_vec);
     }
 
     //-------------------------------------------------------------------------
@@ -167,14 +379,14 @@ TEST_SUITE(Vector) {
     TEST(Verify_vec_at_returns_an_item_at_the_provided_index)
     {
         void* array[2] = { (void*)0x1234, (void*)0x4321 };
-        vec_t vector = { 2, 2, array };
+        vec_t vector = { 2, 2, array, 0 };
         CHECK((void*)0x4321 == vec_at(&vector,1));
     }
 
     TEST(Verify_vec_at_returns_null_if_index_out_of_range)
     {
         void* array[2] = { (void*)0x1234, (void*)0x4321 };
-        vec_t vector = { 2, 2, array };
+        vec_t vector = { 2, 2, array, 0 };
         CHECK(NULL == vec_at(&vector,2));
     }
 
@@ -184,7 +396,7 @@ TEST_SUITE(Vector) {
     TEST(Verify_vec_set_sets_the_value_at_the_given_index)
     {
         void* data[3] = { (void*)0x1234, NULL, NULL };
-        vec_t vector = { 2, 3, data };
+        vec_t vector = { 2, 3, data, 0 };
         CHECK(true == vec_set(&vector,1,(void*)0x4321));
         CHECK((void*)0x4321 == data[1]);
         CHECK(NULL == data[2]);
@@ -193,7 +405,7 @@ TEST_SUITE(Vector) {
     TEST(Verify_vec_set_returns_false_if_index_out_of_range)
     {
         void* data[3] = { (void*)0x1234, NULL, NULL };
-        vec_t vector = { 2, 3, data };
+        vec_t vector = { 2, 3, data, 0 };
         CHECK(false == vec_set(&vector,2,(void*)0x4321));
         CHECK(NULL == data[1]);
         CHECK(NULL == data[2]);
@@ -204,23 +416,22 @@ TEST_SUITE(Vector) {
     //-------------------------------------------------------------------------
     TEST(Verify_vec_insert_should_do_nothing_if_index_out_of_range)
     {
-        vec_t vector = { 2, 3, NULL };
+        vec_t vector = { 2, 3, NULL, 0 };
         CHECK(false == vec_insert(&vector,2,0));
     }
 
     TEST(Verify_vec_insert_should_do_nothing_if_num_elements_is_0)
     {
-        vec_t vector = { 2, 3, NULL };
+        vec_t vector = { 2, 3, NULL, 0 };
         CHECK(false == vec_insert(&vector,0,0));
     }
 
     TEST(Verify_vec_insert_should_insert_items_at_the_given_index)
     {
-    //TODO: busted.
         vec_t* p_vec = vec_new(2,mem_box(0),mem_box(1));
         CHECK(true == vec_insert(p_vec,1,2,mem_box(2),mem_box(3)));
         CHECK(4 == p_vec->size);
-        CHECK(8 == p_vec->capacity);
+        CHECK(4 == p_vec->capacity);
         CHECK(0 == mem_unbox(p_vec->p_buffer[0]));
         CHECK(2 == mem_unbox(p_vec->p_buffer[1]));
         CHECK(3 == mem_unbox(p_vec->p_buffer[2]));
@@ -230,11 +441,10 @@ TEST_SUITE(Vector) {
 
     TEST(Verify_vec_insert_should_insert_items_at_the_beginning)
     {
-    //TODO: busted.
         vec_t* p_vec = vec_new(2,mem_box(0),mem_box(1));
         CHECK(true == vec_insert(p_vec,0,2,mem_box(2),mem_box(3)));
         CHECK(4 == p_vec->size);
-        CHECK(8 == p_vec->capacity);
+        CHECK(4 == p_vec->capacity);
         CHECK(2 == mem_unbox(p_vec->p_buffer[0]));
         CHECK(3 == mem_unbox(p_vec->p_buffer[1]));
         CHECK(0 == mem_unbox(p_vec->p_buffer[2]));
@@ -242,6 +452,108 @@ TEST_SUITE(Vector) {
         mem_release(p_vec);
     }
 
+    //-------------------------------------------------------------------------
+    // Test vec_from_array, vec_insert_array, vec_append_array and vec_extend
+    //-------------------------------------------------------------------------
+    TEST(Verify_vec_from_array_copies_the_elements)
+    {
+        void* elems[3] = { mem_box(1), mem_box(2), mem_box(3) };
+        vec_t* p_vec = vec_from_array(3, elems);
+        CHECK(3 == p_vec->size);
+        CHECK(3 == p_vec->capacity);
+        CHECK(1 == mem_unbox(p_vec->p_buffer[0]));
+        CHECK(3 == mem_unbox(p_vec->p_buffer[2]));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_from_array_returns_an_empty_vector_for_no_elements)
+    {
+        vec_t* p_vec = vec_from_array(0, NULL);
+        CHECK(0 == p_vec->size);
+        CHECK(DEFAULT_VEC_CAPACITY == p_vec->capacity);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_insert_array_should_insert_items_at_the_given_index)
+    {
+        void* elems[2] = { mem_box(2), mem_box(3) };
+        vec_t* p_vec = vec_new(2,mem_box(0),mem_box(1));
+        CHECK(true == vec_insert_array(p_vec, 1, 2, elems));
+        CHECK(4 == p_vec->size);
+        CHECK(0 == mem_unbox(p_vec->p_buffer[0]));
+        CHECK(2 == mem_unbox(p_vec->p_buffer[1]));
+        CHECK(3 == mem_unbox(p_vec->p_buffer[2]));
+        CHECK(1 == mem_unbox(p_vec->p_buffer[3]));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_insert_array_should_insert_items_at_the_end)
+    {
+        void* elems[1] = { mem_box(2) };
+        vec_t* p_vec = vec_new(2,mem_box(0),mem_box(1));
+        CHECK(true == vec_insert_array(p_vec, 2, 1, elems));
+        CHECK(3 == p_vec->size);
+        CHECK(2 == mem_unbox(p_vec->p_buffer[2]));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_insert_array_should_do_nothing_if_index_out_of_range)
+    {
+        void* elems[1] = { mem_box(2) };
+        vec_t* p_vec = vec_new(2,mem_box(0),mem_box(1));
+        CHECK(false == vec_insert_array(p_vec, 3, 1, elems));
+        CHECK(2 == p_vec->size);
+        mem_release(p_vec);
+        mem_release(elems[0]);
+    }
+
+    TEST(Verify_vec_append_array_grows_the_buffer_once)
+    {
+        void* elems[100];
+        vec_t* p_vec = vec_new(1, mem_box(42));
+        bool appended = true;
+        size_t i;
+        for (i = 0; i < 100; i++)
+            elems[i] = mem_box((intptr_t)i);
+        vec_append_array(p_vec, 100, elems);
+        for (i = 0; i < 100; i++)
+            appended = appended && ((intptr_t)i == mem_unbox(p_vec->p_buffer[i + 1]));
+        CHECK(appended);
+        CHECK(101 == p_vec->size);
+        CHECK(101 == p_vec->capacity);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_extend_shares_the_source_elements)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        vec_t* p_src = vec_new(2, p_obj, mem_box(1));
+        vec_t* p_vec = vec_new(1, mem_box(0));
+        int refcount;
+        vec_extend(p_vec, p_src);
+        refcount = mem_refcount(p_obj);
+        CHECK(3 == p_vec->size);
+        CHECK(2 == p_src->size);
+        CHECK(p_obj == p_vec->p_buffer[1]);
+        CHECK(1 == mem_unbox(p_vec->p_buffer[2]));
+        CHECK(2 == refcount);
+        mem_release(p_src);
+        CHECK(1 == mem_refcount(p_obj));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_extend_can_extend_a_vector_with_itself)
+    {
+        void* p_obj = mem_allocate(sizeof(int), NULL);
+        vec_t* p_vec = vec_new(2, mem_box(1), p_obj);
+        vec_extend(p_vec, p_vec);
+        CHECK(4 == p_vec->size);
+        CHECK(1 == mem_unbox(p_vec->p_buffer[2]));
+        CHECK(p_obj == p_vec->p_buffer[3]);
+        CHECK(2 == mem_refcount(p_obj));
+        mem_release(p_vec);
+    }
+
     //-------------------------------------------------------------------------
     // Test vec_erase function
     //-------------------------------------------------------------------------
@@ -330,7 +642,7 @@ TEST_SUITE(Vector) {
         vec_t* p_vec = vec_new(3,mem_box(0), mem_box(1), mem_box(2));
         vec_push_back( p_vec, mem_box(0x2A) );
         CHECK( 4 == p_vec->size );
-        CHECK( 8 == p_vec->capacity );
+        CHECK( 6 == p_vec->capacity );
         CHECK( 0x2A == mem_unbox(p_vec->p_buffer[3]) );
         mem_release(p_vec);
     }
@@ -340,11 +652,48 @@ TEST_SUITE(Vector) {
         vec_t* p_vec = vec_new(0);
         vec_push_back( p_vec, mem_box(0x2A) );
         CHECK( 1 == p_vec->size );
-        CHECK( 2 == p_vec->capacity );
+        CHECK( DEFAULT_VEC_CAPACITY == p_vec->capacity );
         CHECK( 0x2A == mem_unbox(p_vec->p_buffer[0]) );
         mem_release(p_vec);
     }
 
+    TEST(Verify_vec_push_back_grows_the_capacity_geometrically)
+    {
+        vec_t* p_vec = vec_new(0);
+        size_t capacity = p_vec->capacity;
+        size_t num_growths = 0;
+        bool doubled = true;
+        size_t i;
+        for (i = 0; i < 1000; i++)
+        {
+            vec_push_back( p_vec, NULL );
+            if (p_vec->capacity != capacity)
+            {
+                doubled = doubled && ((capacity * 2) == p_vec->capacity);
+                capacity = p_vec->capacity;
+                num_growths++;
+            }
+        }
+        CHECK( 1000 == p_vec->size );
+        CHECK( doubled );
+        CHECK( 7 == num_growths );
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_push_back_grows_by_the_factor_set_for_the_vector)
+    {
+        vec_t* p_vec = vec_new(0);
+        size_t i;
+        vec_set_growth( p_vec, 150 );
+        for (i = 0; i < 9; i++)
+            vec_push_back( p_vec, NULL );
+        CHECK( 12 == p_vec->capacity );
+        for (i = 0; i < 4; i++)
+            vec_push_back( p_vec, NULL );
+        CHECK( 18 == p_vec->capacity );
+        mem_release(p_vec);
+    }
+
     //-------------------------------------------------------------------------
     // Test vec_pop_back function
     //-------------------------------------------------------------------------
@@ -378,4 +727,283 @@ TEST_SUITE(Vector) {
         CHECK( 0 == p_vec->size );
         mem_release(p_vec);
     }
+
+    //-------------------------------------------------------------------------
+    // Test vec_sort and vec_stable_sort functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_vec_sort_sorts_a_small_vector)
+    {
+        vec_t* p_vec = vec_new(5, mem_box(3), mem_box(1), mem_box(4), mem_box(1), mem_box(5));
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        vec_sort(p_vec, p_cmp);
+        CHECK(1 == mem_unbox(p_vec->p_buffer[0]));
+        CHECK(1 == mem_unbox(p_vec->p_buffer[1]));
+        CHECK(3 == mem_unbox(p_vec->p_buffer[2]));
+        CHECK(4 == mem_unbox(p_vec->p_buffer[3]));
+        CHECK(5 == mem_unbox(p_vec->p_buffer[4]));
+        mem_release(p_vec);
+        mem_release(p_cmp);
+    }
+
+    TEST(Verify_vec_sort_sorts_an_empty_vector)
+    {
+        vec_t* p_vec = vec_new(0);
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        vec_sort(p_vec, p_cmp);
+        vec_stable_sort(p_vec, p_cmp);
+        CHECK(0 == p_vec->size);
+        mem_release(p_vec);
+        mem_release(p_cmp);
+    }
+
+    TEST(Verify_vec_sort_sorts_a_large_vector_in_parallel)
+    {
+        vec_t* p_vec = random_vec(4 * VEC_SORT_PARALLEL_THRESHOLD + 3, 1000000);
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        intptr_t sum = vec_sum(p_vec);
+        bool sorted;
+        vec_sort(p_vec, p_cmp);
+        sorted = vec_is_sorted(p_vec, p_cmp);
+        CHECK(sorted);
+        CHECK(sum == vec_sum(p_vec));
+        mem_release(p_vec);
+        mem_release(p_cmp);
+    }
+
+    TEST(Verify_vec_sort_sorts_vectors_with_few_distinct_values)
+    {
+        vec_t* p_vec = random_vec(100000, 3);
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        intptr_t sum = vec_sum(p_vec);
+        bool sorted;
+        vec_sort(p_vec, p_cmp);
+        sorted = vec_is_sorted(p_vec, p_cmp);
+        CHECK(sorted);
+        CHECK(sum == vec_sum(p_vec));
+        mem_release(p_vec);
+        mem_release(p_cmp);
+    }
+
+    TEST(Verify_vec_sort_sorts_ordered_and_reversed_vectors)
+    {
+        vec_t* p_vec = vec_new(0);
+        vec_t* p_rev = vec_new(0);
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        bool ordered, reversed;
+        intptr_t i;
+        for (i = 0; i < 10000; i++) {
+            vec_push_back(p_vec, mem_box(i));
+            vec_push_back(p_rev, mem_box(10000 - i));
+        }
+        vec_sort(p_vec, p_cmp);
+        vec_sort(p_rev, p_cmp);
+        ordered = vec_is_sorted(p_vec, p_cmp) && (9999 == mem_unbox(p_vec->p_buffer[9999]));
+        reversed = vec_is_sorted(p_rev, p_cmp) && (1 == mem_unbox(p_rev->p_buffer[0]));
+        CHECK(ordered);
+        CHECK(reversed);
+        mem_release(p_vec);
+        mem_release(p_rev);
+        mem_release(p_cmp);
+    }
+
+    TEST(Verify_vec_stable_sort_keeps_equal_elements_in_order)
+    {
+        size_t num_elements = 2 * VEC_SORT_PARALLEL_THRESHOLD + 5;
+        vec_t* p_vec = vec_new(0);
+        cmp_t* p_cmp = cmp_new(NULL, cmp_key);
+        uint32_t seed = 42;
+        bool stable = true;
+        size_t i;
+        /* Tag each of a few keys with its original position */
+        for (i = 0; i < num_elements; i++) {
+            seed = (seed * 1664525u) + 1013904223u;
+            vec_push_back(p_vec, mem_box((intptr_t)((seed >> 8) % 16) * 1000000 + (intptr_t)i));
+        }
+        vec_stable_sort(p_vec, p_cmp);
+        for (i = 1; stable && (i < num_elements); i++)
+            stable = (mem_unbox(p_vec->p_buffer[i - 1]) < mem_unbox(p_vec->p_buffer[i]));
+        CHECK(stable);
+        CHECK(num_elements == p_vec->size);
+        mem_release(p_vec);
+        mem_release(p_cmp);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test vec_lower_bound, vec_upper_bound and vec_binary_search functions
+    //-------------------------------------------------------------------------
+    TEST(Verify_vec_lower_and_upper_bound_find_the_range_of_equal_elements)
+    {
+        vec_t* p_vec = vec_new(6, mem_box(1), mem_box(3), mem_box(3), mem_box(3), mem_box(5), mem_box(7));
+        vec_t* p_probes = vec_new(5, mem_box(0), mem_box(3), mem_box(4), mem_box(7), mem_box(8));
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        CHECK(0 == vec_lower_bound(p_vec, p_cmp, vec_at(p_probes, 0)));
+        CHECK(1 == vec_lower_bound(p_vec, p_cmp, vec_at(p_probes, 1)));
+        CHECK(4 == vec_upper_bound(p_vec, p_cmp, vec_at(p_probes, 1)));
+        CHECK(4 == vec_lower_bound(p_vec, p_cmp, vec_at(p_probes, 2)));
+        CHECK(4 == vec_upper_bound(p_vec, p_cmp, vec_at(p_probes, 2)));
+        CHECK(6 == vec_upper_bound(p_vec, p_cmp, vec_at(p_probes, 3)));
+        CHECK(6 == vec_lower_bound(p_vec, p_cmp, vec_at(p_probes, 4)));
+        mem_release(p_vec);
+        mem_release(p_probes);
+        mem_release(p_cmp);
+    }
+
+    TEST(Verify_vec_binary_search_reports_whether_the_value_is_present)
+    {
+        vec_t* p_vec = vec_new(4, mem_box(2), mem_box(4), mem_box(6), mem_box(8));
+        vec_t* p_probes = vec_new(5, mem_box(2), mem_box(8), mem_box(5), mem_box(9), mem_box(0));
+        cmp_t* p_cmp = cmp_new(NULL, cmp_int);
+        CHECK(vec_binary_search(p_vec, p_cmp, vec_at(p_probes, 0)));
+        CHECK(vec_binary_search(p_vec, p_cmp, vec_at(p_probes, 1)));
+        CHECK(!vec_binary_search(p_vec, p_cmp, vec_at(p_probes, 2)));
+        CHECK(!vec_binary_search(p_vec, p_cmp, vec_at(p_probes, 3)));
+        CHECK(!vec_binary_search(p_vec, p_cmp, vec_at(p_probes, 4)));
+        mem_release(p_vec);
+        mem_release(p_probes);
+        mem_release(p_cmp);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test vec_foreach, vec_map, vec_filter, vec_reduce and vec_find_if
+    //-------------------------------------------------------------------------
+    TEST(Verify_vec_foreach_visits_every_element_in_order)
+    {
+        vec_t* p_vec = sequence_vec(100);
+        intptr_t next = 0;
+        vec_foreach(p_vec, visit_next, &next);
+        CHECK(100 == next);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_map_returns_a_vector_of_the_results)
+    {
+        vec_t* p_vec = sequence_vec(10);
+        vec_t* p_doubled = vec_map(p_vec, double_elem, NULL);
+        CHECK(10 == vec_size(p_doubled));
+        CHECK(0 == mem_unbox(vec_at(p_doubled, 0)));
+        CHECK(18 == mem_unbox(vec_at(p_doubled, 9)));
+        CHECK(90 == vec_sum(p_doubled));
+        mem_release(p_vec);
+        mem_release(p_doubled);
+    }
+
+    TEST(Verify_vec_map_of_an_empty_vector_is_empty)
+    {
+        vec_t* p_vec = vec_new(0);
+        vec_t* p_mapped = vec_map(p_vec, double_elem, NULL);
+        CHECK(vec_empty(p_mapped));
+        mem_release(p_vec);
+        mem_release(p_mapped);
+    }
+
+    TEST(Verify_vec_filter_keeps_matching_elements_in_order)
+    {
+        vec_t* p_vec = sequence_vec(10);
+        intptr_t three = 3;
+        vec_t* p_kept = vec_filter(p_vec, is_multiple, &three);
+        CHECK(4 == vec_size(p_kept));
+        CHECK(4 == vec_capacity(p_kept));
+        CHECK(0 == mem_unbox(vec_at(p_kept, 0)));
+        CHECK(3 == mem_unbox(vec_at(p_kept, 1)));
+        CHECK(9 == mem_unbox(vec_at(p_kept, 3)));
+        CHECK(NULL == vec_at(p_kept, 4));
+        mem_release(p_vec);
+        CHECK(6 == mem_unbox(vec_at(p_kept, 2)));
+        mem_release(p_kept);
+    }
+
+    TEST(Verify_vec_reduce_folds_the_elements)
+    {
+        vec_t* p_vec = sequence_vec(101);
+        vec_t* p_empty = vec_new(0);
+        CHECK(5050 == (intptr_t)vec_reduce(p_vec, add_elem, NULL, (void*)0));
+        CHECK(7 == (intptr_t)vec_reduce(p_empty, add_elem, NULL, (void*)7));
+        mem_release(p_vec);
+        mem_release(p_empty);
+    }
+
+    TEST(Verify_vec_find_if_returns_the_first_match)
+    {
+        vec_t* p_vec = vec_new(5, mem_box(4), mem_box(7), mem_box(9), mem_box(7), mem_box(1));
+        intptr_t seven = 7;
+        intptr_t eight = 8;
+        CHECK(1 == vec_find_if(p_vec, is_value, &seven));
+        CHECK(5 == vec_find_if(p_vec, is_value, &eight));
+        mem_release(p_vec);
+    }
+
+    //-------------------------------------------------------------------------
+    // Test the parallel bulk operations
+    //-------------------------------------------------------------------------
+    TEST(Verify_vec_parallel_foreach_visits_every_element)
+    {
+        vec_t* p_vec = sequence_vec(NUM_PARALLEL);
+        intptr_t sum = 0;
+        vec_parallel_foreach(p_vec, visit_sum, &sum, 4);
+        CHECK(vec_sum(p_vec) == sum);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_parallel_map_matches_vec_map)
+    {
+        vec_t* p_vec = sequence_vec(NUM_PARALLEL);
+        vec_t* p_doubled = vec_parallel_map(p_vec, double_elem, NULL, 4);
+        bool matched = (NUM_PARALLEL == vec_size(p_doubled));
+        size_t i;
+        for (i = 0; matched && (i < NUM_PARALLEL); i++)
+            matched = ((2 * (intptr_t)i) == mem_unbox(vec_at(p_doubled, i)));
+        CHECK(matched);
+        mem_release(p_vec);
+        mem_release(p_doubled);
+    }
+
+    TEST(Verify_vec_parallel_filter_keeps_matching_elements_in_order)
+    {
+        vec_t* p_vec = sequence_vec(NUM_PARALLEL);
+        intptr_t seven = 7;
+        vec_t* p_kept = vec_parallel_filter(p_vec, is_multiple, &seven, 4);
+        bool matched = (((NUM_PARALLEL + 6) / 7) == vec_size(p_kept));
+        CHECK(vec_size(p_kept) == vec_capacity(p_kept));
+        size_t i;
+        for (i = 0; matched && (i < vec_size(p_kept)); i++)
+            matched = ((7 * (intptr_t)i) == mem_unbox(vec_at(p_kept, i)));
+        CHECK(matched);
+        mem_release(p_vec);
+        mem_release(p_kept);
+    }
+
+    TEST(Verify_vec_parallel_foreach_can_be_called_from_within_a_range)
+    {
+        vec_t* p_vec = sequence_vec(NUM_PARALLEL);
+        nested_sum_t env = { p_vec, 0 };
+        /* The inner calls find the pool busy and run on the calling thread */
+        vec_parallel_foreach(p_vec, visit_nested_sum, &env, 4);
+        CHECK((5 * vec_sum(p_vec)) == env.sum);
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_parallel_reduce_combines_the_ranges)
+    {
+        vec_t* p_vec = sequence_vec(NUM_PARALLEL);
+        intptr_t expected = ((intptr_t)NUM_PARALLEL * (NUM_PARALLEL - 1)) / 2;
+        CHECK(expected == (intptr_t)vec_parallel_reduce(p_vec, add_elem, add_acc, NULL, (void*)0, 4));
+        CHECK(expected == (intptr_t)vec_parallel_reduce(p_vec, add_elem, add_acc, NULL, (void*)0, 0));
+        mem_release(p_vec);
+    }
+
+    TEST(Verify_vec_parallel_find_if_returns_the_first_match)
+    {
+        vec_t* p_vec = sequence_vec(NUM_PARALLEL);
+        intptr_t value = 5;
+        intptr_t missing = -1;
+        mem_release(vec_at(p_vec, NUM_PARALLEL - 1));
+        vec_set(p_vec, NUM_PARALLEL - 1, mem_box(5));
+        mem_release(vec_at(p_vec, 2 * VEC_PARALLEL_MIN_CHUNK));
+        vec_set(p_vec, 2 * VEC_PARALLEL_MIN_CHUNK, mem_box(5));
+        CHECK(5 == vec_parallel_find_if(p_vec, is_value, &value, 4));
+        value = (intptr_t)(3 * VEC_PARALLEL_MIN_CHUNK);
+        CHECK((3 * VEC_PARALLEL_MIN_CHUNK) == vec_parallel_find_if(p_vec, is_value, &value, 4));
+        CHECK(NUM_PARALLEL == vec_parallel_find_if(p_vec, is_value, &missing, 4));
+        mem_release(p_vec);
+    }
 }